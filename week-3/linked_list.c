@@ -32,17 +32,94 @@
 
 #include "linked_list.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include <assert.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LINKED_LIST_X86_KERNELS 1
+#else
+#define LINKED_LIST_X86_KERNELS 0
+#endif
 
 #define ALLOC_SIZE 4096 * 1024
 #define ALLOC_DOUBLE 1
 
+// Blocks of the default alloc policy. ALLOC_DOUBLE grows them with the
+// linked_list, otherwise they all hold ALLOC_SIZE nodes.
+//
+#if ALLOC_DOUBLE
+#define ALLOC_INITIAL_BLOCK (1024 * 16)
+#define ALLOC_GROWTH_PERCENT 100
+#else
+#define ALLOC_INITIAL_BLOCK ALLOC_SIZE
+#define ALLOC_GROWTH_PERCENT 0
+#endif
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Values kept in the first half when a full unrolled node is split.
+//
+#define UNROLLED_SPLIT_KEEP ((LINKED_LIST_UNROLLED_CAPACITY + 1) / 2)
+
+_Static_assert(sizeof(struct unrolled_node) == 64,
+               "unrolled_node is expected to fill one cache line");
+
+_Static_assert(sizeof(struct compact_node) == 8,
+               "compact_node is expected to take 8 bytes");
+
+// Arena capacity, in compact nodes, of the first allocation.
+//
+#define COMPACT_ARENA_MIN 64
+
 // Function pointers to (potentially) custom malloc() and
 // free() functions.
 //
 static void * (*malloc_fptr)(size_t size) ;
 static void   (*free_fptr)(void* addr);
 
+static const struct alloc_policy default_alloc_policy = {
+    ALLOC_INITIAL_BLOCK, ALLOC_GROWTH_PERCENT, 0, 0, NULL
+};
+
+// Stats, see linked_list_get_stats(). Walks add their steps to
+// ll->walk_steps between STATS_BEGIN_WALK() and STATS_END_WALK(), which
+// files them into one of the histograms. Without LINKED_LIST_STATS every
+// one of these but STATS_CLEAR() compiles to nothing.
+//
+#define STATS_CLEAR(ll) (memset(&(ll)->stats, 0, sizeof((ll)->stats)), (ll)->walk_steps = 0)
+
+#ifdef LINKED_LIST_STATS
+static inline void __linked_list_stats_record(size_t* histogram, size_t steps){
+    size_t bucket = steps == 0 ? 0 : (size_t)(sizeof(unsigned long long) * CHAR_BIT - __builtin_clzll(steps));
+    if(bucket >= LINKED_LIST_STATS_BUCKETS)
+        bucket = LINKED_LIST_STATS_BUCKETS - 1;
+    histogram[bucket]++;
+}
+
+#define STATS_ADD(ll, counter, n) ((ll)->stats.counter += (n))
+#define STATS_WALK(ll, steps) ((ll)->walk_steps += (steps))
+#define STATS_BEGIN_WALK(ll) ((ll)->walk_steps = 0)
+#define STATS_END_WALK(ll, histogram) __linked_list_stats_record((ll)->stats.histogram, (ll)->walk_steps)
+#define STATS_RECORD(ll, histogram, steps) __linked_list_stats_record((ll)->stats.histogram, (steps))
+#else
+#define STATS_ADD(ll, counter, n) ((void)0)
+#define STATS_WALK(ll, steps) ((void)0)
+#define STATS_BEGIN_WALK(ll) ((void)0)
+#define STATS_END_WALK(ll, histogram) ((void)0)
+#define STATS_RECORD(ll, histogram, steps) ((void)0)
+#endif
+
 // Creates a new linked_list.
 // PRECONDITION: Register malloc() and free() functions via the
 //               linked_list_register_malloc() and 
@@ -55,10 +132,7 @@ struct linked_list * linked_list_create(void){
     if (ll == NULL) {
         return NULL;
     }
-    ll->head = NULL;
-    ll->tail = NULL;
-    ll->free_stack = NULL;
-    ll->size = 0;
+    linked_list_create_in_place(ll);
     return ll;
 }
 
@@ -68,405 +142,5662 @@ bool linked_list_create_in_place(struct linked_list* ll){
     ll->head = NULL;
     ll->tail = NULL;
     ll->free_stack = NULL;
+    ll->free_stack_bottom = NULL;
     ll->size = 0;
+    ll->layout = LINKED_LIST_LAYOUT_NODES;
+    ll->chunk_head = NULL;
+    ll->chunk_tail = NULL;
+    ll->chunk_free_stack = NULL;
+    ll->chunk_free_stack_bottom = NULL;
+    ll->index = NULL;
+    ll->hash = NULL;
+    ll->blocks.entries = NULL;
+    ll->blocks.count = 0;
+    ll->blocks.capacity = 0;
+    ll->blocks.values = 0;
+    ll->pool = NULL;
+    ll->compact_head = LINKED_LIST_COMPACT_NIL;
+    ll->compact_tail = LINKED_LIST_COMPACT_NIL;
+    ll->arena.nodes = NULL;
+    ll->arena.capacity = 0;
+    ll->arena.used = 0;
+    ll->arena.free_stack = LINKED_LIST_COMPACT_NIL;
+    ll->arena.mapping = NULL;
+    ll->arena.mapping_bytes = 0;
+    ll->carve.next = NULL;
+    ll->carve.end = NULL;
+    ll->carve.spare = NULL;
+    ll->chunk_carve.next = NULL;
+    ll->chunk_carve.end = NULL;
+    ll->chunk_carve.spare = NULL;
+    ll->trim.ratio = 0;
+    ll->trim.min_capacity = 0;
+    ll->trim.last_size = 0;
+    ll->trim.last_capacity = 0;
+    ll->prefetch_distance = 0;
+    ll->alloc = default_alloc_policy;
+    ll->adaptive.enabled = false;
+    ll->adaptive.sequential = 0;
+    ll->adaptive.positional = 0;
+    ll->adaptive.iterators = 0;
+    ll->adaptive.untracked = false;
+    memset(ll->fingers, 0, sizeof(ll->fingers));
+    ll->finger_next = 0;
+    STATS_CLEAR(ll);
     return true;
 }
 
+// Free stacks and block registry a linked_list allocates from: its own,
+// or those of the node_pool it is attached to.
 // Assuming ll != NULL
-bool __linked_list_save_in_free_stack(struct linked_list * ll, struct node* node){
-    node->next = ll->free_stack;
-    ll->free_stack = node;
-    return true;
+struct node ** __linked_list_free_stack(struct linked_list * ll){
+    return ll->pool != NULL ? &ll->pool->free_stack : &ll->free_stack;
 }
 
-// Deletes a linked_list.
-// \param ll : Pointer to linked_list to delete
-// POSTCONDITION : An empty linked_list has its head point to NULL.
-// Returns TRUE on success, FALSE otherwise.
+struct unrolled_node ** __linked_list_chunk_free_stack(struct linked_list * ll){
+    return ll->pool != NULL ? &ll->pool->chunk_free_stack : &ll->chunk_free_stack;
+}
+
+struct block_registry * __linked_list_blocks(struct linked_list * ll){
+    return ll->pool != NULL ? &ll->pool->blocks : &ll->blocks;
+}
+
+struct block_carve * __linked_list_carve(struct linked_list * ll){
+    return ll->pool != NULL ? &ll->pool->carve : &ll->carve;
+}
+
+struct block_carve * __linked_list_chunk_carve(struct linked_list * ll){
+    return ll->pool != NULL ? &ll->pool->chunk_carve : &ll->chunk_carve;
+}
+
+// Doubly linked nodes.
+// A struct dnode starts with a struct node, so everything that only follows
+// next links treats both layouts alike. Node blocks, the free stack and the
+// carve of a doubly linked list hold dnodes, hence the node size below.
+// prev links are only written when a node is linked in or unlinked.
 //
-bool linked_list_delete(struct linked_list * ll){
-    if(ll == NULL)
+
+// Size in bytes of the nodes of a linked_list with the given layout.
+static inline size_t __linked_list_layout_node_bytes(enum linked_list_layout layout){
+    return layout == LINKED_LIST_LAYOUT_DOUBLY ? sizeof(struct dnode) : sizeof(struct node);
+}
+
+// Size in bytes of the nodes of ll.
+// Assuming ll != NULL
+static inline size_t __linked_list_node_bytes(const struct linked_list* ll){
+    return __linked_list_layout_node_bytes(ll->layout);
+}
+
+// Returns whether a linked_list with the given layout can take its nodes
+// from pool. Compact nodes always live in the linked_list's own arena.
+// Assuming pool != NULL
+static inline bool __node_pool_accepts(const struct node_pool* pool, enum linked_list_layout layout){
+    if(layout == LINKED_LIST_LAYOUT_COMPACT)
         return false;
-    
-    struct node* curr = ll->head;
-    struct node* old_free_stack = ll->free_stack;
-    int block_count = 0;
-    while(curr != NULL){
-        struct node* next = curr->next;
-        // free_fptr(curr); // TODO: check for fail conditions
-        if(curr->is_block_head){
-            block_count += 1;
-            __linked_list_save_in_free_stack(ll, curr);
-        }
-        curr = next;
+    return layout == LINKED_LIST_LAYOUT_UNROLLED ||
+           __linked_list_layout_node_bytes(layout) == pool->node_bytes;
+}
+
+// Returns the node before node. Assuming ll is doubly linked.
+static inline struct node * __linked_list_prev(const struct node* node){
+    return ((const struct dnode*)node)->prev;
+}
+
+// Makes prev the node before node, when ll is doubly linked and node is not
+// NULL.
+// Assuming ll != NULL
+static inline void __linked_list_set_prev(const struct linked_list* ll, struct node* node, struct node* prev){
+    if(ll->layout == LINKED_LIST_LAYOUT_DOUBLY && node != NULL)
+        ((struct dnode*)node)->prev = prev;
+}
+
+// Sets the prev links of the run first..last, just linked in after prev,
+// and of the node following last.
+// Assuming ll != NULL and first, last != NULL
+void __linked_list_link_prev(const struct linked_list* ll, struct node* prev,
+                             struct node* first, struct node* last){
+    if(ll->layout != LINKED_LIST_LAYOUT_DOUBLY)
+        return;
+
+    struct node* curr = first;
+    while(1){
+        ((struct dnode*)curr)->prev = prev;
+        if(curr == last)
+            break;
+        prev = curr;
+        curr = curr->next;
     }
+    __linked_list_set_prev(ll, last->next, last);
+}
 
-    curr = old_free_stack;
-    while(curr != NULL){
-        struct node* next = curr->next;
-        // free_fptr(curr);
-        if(curr->is_block_head){
-            block_count += 1;
-            __linked_list_save_in_free_stack(ll, curr);
-        }
-        curr = next;
+// Pushes the chain from first to last onto the free stack of ll. The
+// bottom of a private free stack only changes when the stack was empty, so
+// it is kept up to date here and nowhere else but in trimming.
+// Assuming ll != NULL and last is reached from first
+void __linked_list_push_free_nodes(struct linked_list * ll, struct node* first, struct node* last){
+    struct node** free_stack = __linked_list_free_stack(ll);
+    if(ll->pool == NULL && *free_stack == NULL)
+        ll->free_stack_bottom = last;
+    last->next = *free_stack;
+    *free_stack = first;
+}
+
+// Same as __linked_list_push_free_nodes(), for unrolled nodes.
+// Assuming ll != NULL and last is reached from first
+void __linked_list_push_free_chunks(struct linked_list * ll, struct unrolled_node* first,
+                                    struct unrolled_node* last){
+    struct unrolled_node** free_stack = __linked_list_chunk_free_stack(ll);
+    if(ll->pool == NULL && *free_stack == NULL)
+        ll->chunk_free_stack_bottom = last;
+    last->next = *free_stack;
+    *free_stack = first;
+}
+
+// Assuming ll != NULL
+bool __linked_list_save_in_free_stack(struct linked_list * ll, struct node* node){
+    __linked_list_push_free_nodes(ll, node, node);
+    return true;
+}
+
+// Assuming ll != NULL
+bool __linked_list_save_chunk_in_free_stack(struct linked_list * ll, struct unrolled_node* chunk){
+    __linked_list_push_free_chunks(ll, chunk, chunk);
+    return true;
+}
+
+// Makes room in the block registry for extra more blocks.
+// Returns FALSE if the registry could not grow.
+// Assuming blocks != NULL
+bool __block_registry_reserve(struct block_registry * blocks, size_t extra){
+    if(blocks->capacity - blocks->count >= extra)
+        return true;
+
+    size_t capacity = blocks->capacity == 0 ? 16 : 2 * blocks->capacity;
+    while(capacity - blocks->count < extra){
+        capacity *= 2;
     }
-    
-    curr = ll->free_stack;
-    while(block_count--){
-        struct node* next = curr->next;
-        free_fptr(curr);
-        curr = next;
+    struct block_registry_entry* entries = malloc_fptr(capacity * sizeof(struct block_registry_entry));
+    if(entries == NULL)
+        return false;
+    if(blocks->count > 0)
+        memcpy(entries, blocks->entries, blocks->count * sizeof(struct block_registry_entry));
+    if(blocks->entries != NULL)
+        free_fptr(blocks->entries);
+    blocks->entries = entries;
+    blocks->capacity = capacity;
+    return true;
+}
+
+// Allocates bytes for a block of nodes of ll, as its alloc policy says.
+// memory is set to what __linked_list_free_block_memory() gives back.
+// Returns the start of the block, NULL on failure.
+// Assuming ll != NULL
+void * __linked_list_alloc_block_memory(struct linked_list* ll, size_t bytes, struct block_memory* memory){
+    const struct alloc_policy* policy = &ll->alloc;
+    size_t alignment = policy->alignment;
+    if(alignment < _Alignof(max_align_t))
+        alignment = _Alignof(max_align_t);
+
+    STATS_ADD(ll, allocations, 1);
+    STATS_ADD(ll, allocated_bytes, bytes);
+    memory->allocator = policy->allocator;
+    memory->bytes = bytes;
+    if(policy->allocator != NULL){
+        memory->allocation = policy->allocator->allocate(bytes, alignment, policy->allocator->context);
+        return memory->allocation;
     }
 
-    free_fptr(ll);
+    // malloc_fptr() memory is aligned for any type, anything more is
+    // over-allocated and aligned here.
+    if(alignment == _Alignof(max_align_t)){
+        memory->allocation = malloc_fptr(bytes);
+        return memory->allocation;
+    }
+    if(bytes > SIZE_MAX - alignment)
+        return NULL;
+    memory->bytes = bytes + alignment - 1;
+    memory->allocation = malloc_fptr(memory->bytes);
+    if(memory->allocation == NULL)
+        return NULL;
+    return (void*)(((uintptr_t)memory->allocation + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
 
-    return true;    
+// Gives the memory of a block back to where it was allocated from.
+// Assuming memory != NULL
+void __linked_list_free_block_memory(const struct block_memory* memory){
+    if(memory->allocator != NULL)
+        memory->allocator->release(memory->allocation, memory->bytes, memory->allocator->context);
+    else
+        free_fptr(memory->allocation);
 }
 
-// Removes all elements from linked list
-// Returns TRUE on success, FALSE otherwise
-bool linked_list_remove_all(struct linked_list * ll){
-    if(ll == NULL)
+// Records a freshly allocated block in the block registry.
+// Returns FALSE if the registry could not grow, the block is not freed.
+// Assuming blocks != NULL
+bool __linked_list_register_block(struct block_registry * blocks, void* base, size_t nodes, bool chunks,
+                                  const struct block_memory* memory){
+    if(!__block_registry_reserve(blocks, 1))
         return false;
-    
-    struct node* curr = ll->head;
-    struct node* old_free_stack = ll->free_stack;
-    int block_count = 0;
-    while(curr != NULL){
-        struct node* next = curr->next;
-        // free_fptr(curr); // TODO: check for fail conditions
-        if(curr->is_block_head){
-            block_count += 1;
-            __linked_list_save_in_free_stack(ll, curr);
-        }
-        curr = next;
+    blocks->entries[blocks->count].base = base;
+    blocks->entries[blocks->count].nodes = nodes;
+    blocks->entries[blocks->count].chunks = chunks;
+    blocks->entries[blocks->count].memory = *memory;
+    blocks->count += 1;
+    blocks->values += chunks ? nodes * LINKED_LIST_UNROLLED_CAPACITY : nodes;
+    return true;
+}
+
+// Frees every registered block, holding values or not, in O(blocks).
+// The registry itself is kept for reuse.
+// Assuming blocks != NULL
+void __linked_list_free_blocks(struct block_registry * blocks){
+    for(size_t i = 0; i < blocks->count; i++){
+        __linked_list_free_block_memory(&blocks->entries[i].memory);
     }
+    blocks->count = 0;
+    blocks->values = 0;
+}
 
-    curr = old_free_stack;
-    while(curr != NULL){
-        struct node* next = curr->next;
-        // free_fptr(curr);
-        if(curr->is_block_head){
-            block_count += 1;
-            __linked_list_save_in_free_stack(ll, curr);
-        }
-        curr = next;
+// Frees the nodes of an arena, or unmaps them when they live in a file
+// mapping.
+// Assuming arena != NULL
+void __linked_list_free_arena_nodes(struct compact_arena* arena){
+    if(arena->mapping != NULL){
+        munmap(arena->mapping, arena->mapping_bytes);
+        arena->mapping = NULL;
+        arena->mapping_bytes = 0;
     }
-    curr = ll->free_stack;
-    while(block_count--){
-        struct node* next = curr->next;
-        free_fptr(curr);
-        curr = next;
+    else if(arena->nodes != NULL){
+        free_fptr(arena->nodes);
     }
+    arena->nodes = NULL;
+}
 
-    ll->head = NULL;
-    ll->tail = NULL;
-    ll->free_stack = NULL;
-    ll->size = 0;
+// Block copies.
+// Compaction, linked_list_clone(), linked_list_split_at() and adaptive
+// switches write the values they move into fresh nodes handed out in list
+// order by a block_copy, from new blocks of at most max_block nodes of the
+// alloc_policy. Every node handed out is linked after the one before it.
+//
+struct block_copy {
+    struct block_registry * blocks;
+    size_t left;
+    size_t registered;
+    char * next;
+    char * end;
+    void * first;
+    void * last;
+};
 
-    return true;    
+// Number of nodes, of per_node values each, in the next block of ll when
+// nodes more are needed: all of them, or as many as max_block of the
+// alloc_policy allows, at least one.
+// Assuming ll != NULL
+static inline size_t __linked_list_capped_block(const struct linked_list* ll, size_t nodes, size_t per_node){
+    size_t max_block = ll->alloc.max_block;
+    if(max_block == 0)
+        return nodes;
+    size_t most = max_block / per_node;
+    if(most == 0)
+        most = 1;
+    return nodes < most ? nodes : most;
 }
 
-// Returns the size of a linked_list.
-// \param ll : Pointer to linked_list.
-// Returns size on success, SIZE_MAX on failure.
+// Frees the last count blocks of blocks.
+// Assuming blocks != NULL and blocks->count >= count
+void __linked_list_unregister_blocks(struct block_registry * blocks, size_t count){
+    for(size_t i = blocks->count - count; i < blocks->count; i++){
+        const struct block_registry_entry* entry = &blocks->entries[i];
+        blocks->values -= entry->chunks ? entry->nodes * LINKED_LIST_UNROLLED_CAPACITY : entry->nodes;
+        __linked_list_free_block_memory(&entry->memory);
+    }
+    blocks->count -= count;
+}
+
+// Starts a copy of size nodes whose blocks are registered in blocks.
 //
-size_t linked_list_size(struct linked_list * ll){
-    if(ll == NULL)
-        return SIZE_MAX;
-    
-    return ll->size;
+static inline void __block_copy_begin(struct block_copy* copy, struct block_registry* blocks, size_t size){
+    copy->blocks = blocks;
+    copy->left = size;
+    copy->registered = 0;
+    copy->next = NULL;
+    copy->end = NULL;
+    copy->first = NULL;
+    copy->last = NULL;
 }
 
-struct node * __linked_list_allocate_block(struct linked_list* ll, size_t size){
-    assert(size >= 1);
-    struct node* head = malloc_fptr(sizeof(struct node) * size);
-    if(head == NULL)
+// Allocates the next block of the copy, of nodes of node_bytes holding
+// per_node values each, unrolled nodes when chunks is TRUE.
+// Returns FALSE on failure, the blocks of the copy are then freed again.
+// Assuming ll != NULL and copy->left > 0
+bool __block_copy_refill(struct linked_list* ll, struct block_copy* copy, size_t node_bytes,
+                         size_t per_node, bool chunks){
+    size_t count = __linked_list_capped_block(ll, copy->left, per_node);
+    struct block_memory memory;
+    char* block = __linked_list_alloc_block_memory(ll, count * node_bytes, &memory);
+    if(block != NULL && !__linked_list_register_block(copy->blocks, block, count, chunks, &memory)){
+        __linked_list_free_block_memory(&memory);
+        block = NULL;
+    }
+    if(block == NULL){
+        __linked_list_unregister_blocks(copy->blocks, copy->registered);
+        copy->registered = 0;
+        return false;
+    }
+    copy->registered += 1;
+    copy->next = block;
+    copy->end = block + count * node_bytes;
+    return true;
+}
+
+// Hands out the next node of the copy, linked after the one before.
+// Returns NULL if a block could not be allocated, see __block_copy_refill().
+// Assuming ll != NULL and copy->left > 0
+struct node* __block_copy_node(struct linked_list* ll, struct block_copy* copy){
+    size_t node_bytes = __linked_list_node_bytes(ll);
+    bool block_head = copy->next == copy->end;
+    if(block_head && !__block_copy_refill(ll, copy, node_bytes, 1, false))
         return NULL;
-    
-    head->is_block_head = true;
 
-    struct node* curr = head;
-    for(size_t i = 0; i < size - 1; i++){
-        curr->next = curr + 1;
-        curr = curr->next;
-        curr->is_block_head = false;
+    struct node* node = (struct node*)copy->next;
+    struct node* prev = copy->last;
+    copy->next += node_bytes;
+    copy->left -= 1;
+    node->is_block_head = block_head;
+    __linked_list_set_prev(ll, node, prev);
+    if(prev == NULL)
+        copy->first = node;
+    else
+        prev->next = node;
+    copy->last = node;
+    return node;
+}
+
+// Same as __block_copy_node(), for an empty unrolled node.
+// Assuming ll != NULL and copy->left > 0
+struct unrolled_node* __block_copy_chunk(struct linked_list* ll, struct block_copy* copy){
+    bool block_head = copy->next == copy->end;
+    if(block_head && !__block_copy_refill(ll, copy, sizeof(struct unrolled_node),
+                                          LINKED_LIST_UNROLLED_CAPACITY, true))
+        return NULL;
+
+    struct unrolled_node* chunk = (struct unrolled_node*)copy->next;
+    struct unrolled_node* prev = copy->last;
+    copy->next += sizeof(struct unrolled_node);
+    copy->left -= 1;
+    chunk->is_block_head = block_head;
+    chunk->count = 0;
+    if(prev == NULL)
+        copy->first = chunk;
+    else
+        prev->next = chunk;
+    copy->last = chunk;
+    return chunk;
+}
+
+// Fingers.
+// A positional walk over the nodes starts from the nearest of the head,
+// the tail of a doubly linked_list and ll->fingers, and leaves a finger on
+// the node it stops at, replacing the oldest one when it did not start
+// from a finger. Walks at slowly increasing positions then only cover the
+// distance between them. Inserting or removing one node shifts the fingers
+// after it and drops a finger on the removed node; anything relinking many
+// nodes at once drops them all.
+//
+
+// Assuming ll != NULL
+void __linked_list_fingers_clear(struct linked_list* ll){
+    for(size_t i = 0; i < LINKED_LIST_FINGERS; i++){
+        ll->fingers[i].node = NULL;
     }
-    curr->next = NULL;
-    ll->free_stack = head->next;
-    return head;
 }
 
-/// @brief If there is a free node in free stack, then give that, otherwise malloc
-/// @param ll 
-/// @return node pointer for a free noed
-struct node* __linked_list_get_new_node(struct linked_list* ll){
-    if(ll->free_stack != NULL){
-        struct node* tmp = ll->free_stack;
-        ll->free_stack = ll->free_stack->next;
-        return tmp;
+// Shifts the fingers at or after position, where a node was inserted.
+// Assuming ll != NULL
+static inline void __linked_list_fingers_note_insert(struct linked_list* ll, size_t position){
+    for(size_t i = 0; i < LINKED_LIST_FINGERS; i++){
+        struct linked_list_finger* finger = &ll->fingers[i];
+        if(finger->node != NULL && finger->index >= position)
+            finger->index += 1;
+    }
+}
+
+// Drops the finger on the node removed from position and shifts those
+// after it.
+// Assuming ll != NULL
+static inline void __linked_list_fingers_note_remove(struct linked_list* ll, size_t position){
+    for(size_t i = 0; i < LINKED_LIST_FINGERS; i++){
+        struct linked_list_finger* finger = &ll->fingers[i];
+        if(finger->node == NULL || finger->index < position)
+            continue;
+        if(finger->index == position)
+            finger->node = NULL;
+        else
+            finger->index -= 1;
+    }
+}
+
+// Drops every node of ll. Private blocks are freed in O(blocks). With a
+// node_pool the blocks are shared, so the chain of live nodes is handed
+// back to the pool in one piece instead.
+// Assuming ll != NULL
+void __linked_list_release_blocks(struct linked_list * ll){
+    if(ll->pool != NULL){
+        if(ll->head != NULL){
+            ll->tail->next = ll->pool->free_stack;
+            ll->pool->free_stack = ll->head;
+        }
+        if(ll->chunk_head != NULL){
+            ll->chunk_tail->next = ll->pool->chunk_free_stack;
+            ll->pool->chunk_free_stack = ll->chunk_head;
+        }
     }
     else {
-        #if ALLOC_DOUBLE
-        size_t extra_size = 1024 * 16;
-        if(ll->size > extra_size)
-            extra_size = ll->size;
-        return __linked_list_allocate_block(ll, extra_size);
-        #else
-        return __linked_list_allocate_block(ll, ALLOC_SIZE);
-        #endif
+        __linked_list_free_blocks(&ll->blocks);
+        ll->carve.next = NULL;
+        ll->carve.end = NULL;
+        ll->carve.spare = NULL;
+        ll->chunk_carve.next = NULL;
+        ll->chunk_carve.end = NULL;
+        ll->chunk_carve.spare = NULL;
     }
+
+    __linked_list_free_arena_nodes(&ll->arena);
+    ll->arena.capacity = 0;
+    ll->arena.used = 0;
+    ll->arena.free_stack = LINKED_LIST_COMPACT_NIL;
+    ll->compact_head = LINKED_LIST_COMPACT_NIL;
+    ll->compact_tail = LINKED_LIST_COMPACT_NIL;
+
+    ll->head = NULL;
+    ll->tail = NULL;
+    ll->free_stack = NULL;
+    ll->chunk_head = NULL;
+    ll->chunk_tail = NULL;
+    ll->chunk_free_stack = NULL;
+    __linked_list_fingers_clear(ll);
 }
 
-// Inserts an element at the end of the linked_list.
-// \param ll   : Pointer to linked_list.
-// \param data : Data to insert.
-// Returns TRUE on success, FALSE otherwise.
+// Adaptive layout.
+// An adaptive linked_list counts its operations. Once it has seen at least
+// ADAPTIVE_MIN_OPS operations at its ends, scans or iterated values, and at
+// least half as many as it holds values, with nothing done in the middle
+// meanwhile, its nodes are copied in order into a compact arena twice their
+// number. Appending then fills the arena in order, popping at the front
+// and appending again reuses the slots round robin, so walks read the
+// arena sequentially. Operations in the middle reuse slots out of order and
+// a compact_node walk is no cheaper than a node walk there, so
+// ADAPTIVE_MIN_OPS of them in a row move the values back to nodes. Either
+// copy is paid for by the operations counted before it.
 //
-bool linked_list_insert_end(struct linked_list * ll,
-                            unsigned int data){
-    if(ll == NULL) 
+#define ADAPTIVE_MIN_OPS 1024
+
+// Moves the values of a nodes linked_list into a new arena, in order.
+// Returns FALSE if allocation failed, ll is unchanged.
+// Assuming ll != NULL, ll uses LINKED_LIST_LAYOUT_NODES and has private
+// storage
+bool __linked_list_adapt_to_arena(struct linked_list* ll){
+    size_t size = ll->size;
+    if(size >= LINKED_LIST_COMPACT_NIL)
         return false;
-    struct node* new_node = __linked_list_get_new_node(ll);
-    
-    if(new_node == NULL)
+
+    size_t capacity = 2 * size < COMPACT_ARENA_MIN ? COMPACT_ARENA_MIN : 2 * size;
+    if(capacity > LINKED_LIST_COMPACT_NIL)
+        capacity = LINKED_LIST_COMPACT_NIL;
+    STATS_ADD(ll, allocations, 1);
+    STATS_ADD(ll, allocated_bytes, capacity * sizeof(struct compact_node));
+    struct compact_node* nodes = malloc_fptr(capacity * sizeof(struct compact_node));
+    if(nodes == NULL)
         return false;
 
-    new_node->data = data;
-    new_node->next = NULL;
+    const struct node* curr = ll->head;
+    for(size_t i = 0; i < size; i++){
+        nodes[i].data = curr->data;
+        nodes[i].next = (uint32_t)(i + 1);
+        curr = curr->next;
+    }
 
-    if(ll->head == NULL){
-        ll->head = new_node;
-        ll->tail = new_node;
+    __linked_list_release_blocks(ll);
+    ll->layout = LINKED_LIST_LAYOUT_COMPACT;
+    ll->arena.nodes = nodes;
+    ll->arena.capacity = (uint32_t)capacity;
+    ll->arena.used = (uint32_t)size;
+    if(size > 0){
+        nodes[size - 1].next = LINKED_LIST_COMPACT_NIL;
+        ll->compact_head = 0;
+        ll->compact_tail = (uint32_t)(size - 1);
     }
-    else{
-        new_node->next = ll->tail->next;
-        ll->tail->next = new_node;
-        ll->tail = new_node;
+    return true;
+}
+
+// Moves the values of a compact linked_list into new blocks of nodes, in
+// order, see "Block copies".
+// Returns FALSE if allocation failed, ll is unchanged.
+// Assuming ll != NULL, ll uses LINKED_LIST_LAYOUT_COMPACT and has no
+// blocks of nodes
+bool __linked_list_adapt_to_nodes(struct linked_list* ll){
+    size_t size = ll->size;
+    struct block_copy copy;
+    __block_copy_begin(&copy, &ll->blocks, size);
+    const struct compact_node* nodes = ll->arena.nodes;
+    uint32_t slot = ll->compact_head;
+    for(size_t i = 0; i < size; i++){
+        struct node* node = __block_copy_node(ll, &copy);
+        if(node == NULL)
+            return false;
+        node->data = nodes[slot].data;
+        slot = nodes[slot].next;
     }
+    struct node* head = copy.first;
+    struct node* tail = copy.last;
+    if(tail != NULL)
+        tail->next = NULL;
 
-    ll->size += 1;
+    __linked_list_free_arena_nodes(&ll->arena);
+    ll->arena.capacity = 0;
+    ll->arena.used = 0;
+    ll->arena.free_stack = LINKED_LIST_COMPACT_NIL;
+    ll->compact_head = LINKED_LIST_COMPACT_NIL;
+    ll->compact_tail = LINKED_LIST_COMPACT_NIL;
+    ll->layout = LINKED_LIST_LAYOUT_NODES;
+    ll->head = head;
+    ll->tail = tail;
     return true;
 }
 
+// Moves an adaptive linked_list to layout, LINKED_LIST_LAYOUT_NODES or
+// LINKED_LIST_LAYOUT_COMPACT, and starts counting afresh.
+// Returns FALSE if ll cannot switch now or allocation failed, ll keeps its
+// layout.
+// Assuming ll != NULL
+bool __linked_list_adapt(struct linked_list* ll, enum linked_list_layout layout){
+    ll->adaptive.sequential = 0;
+    ll->adaptive.positional = 0;
+    if(ll->layout == layout)
+        return true;
 
-// Inserts an element at the front of the linked_list.
-// \param ll   : Pointer to linked_list.
-// \param data : Data to insert.
-// Returns TRUE on success, FALSE otherwise.
-//
-bool linked_list_insert_front(struct linked_list * ll,
-                              unsigned int data){
-    if(ll == NULL) 
+    if(ll->adaptive.iterators != 0 || ll->index != NULL || ll->hash != NULL || ll->pool != NULL)
         return false;
-    struct node* new_node = __linked_list_get_new_node(ll);
 
-    if(new_node == NULL)
-        return false;
+    if(layout == LINKED_LIST_LAYOUT_COMPACT)
+        return __linked_list_adapt_to_arena(ll);
+    return __linked_list_adapt_to_nodes(ll);
+}
 
-    new_node->data = data;
-    new_node->next = ll->head;
-    ll->head = new_node;
-    ll->size += 1;
-    if(ll->tail == NULL){
-        ll->tail = new_node;
-    }
-    return true;
+// Counts ops operations at the ends of ll, scans or iterated values.
+// Assuming ll != NULL
+static inline void __linked_list_note_sequential(struct linked_list* ll, size_t ops){
+    struct adaptive_policy* adaptive = &ll->adaptive;
+    if(!adaptive->enabled)
+        return;
+
+    adaptive->positional = 0;
+    adaptive->sequential += ops;
+    if(ll->layout == LINKED_LIST_LAYOUT_NODES && adaptive->sequential >= ADAPTIVE_MIN_OPS &&
+       2 * adaptive->sequential >= ll->size && adaptive->iterators == 0)
+        __linked_list_adapt(ll, LINKED_LIST_LAYOUT_COMPACT);
 }
 
-// Inserts an element at a specified index in the linked_list.
-// \param ll    : Pointer to linked_list.
-// \param index : Index to insert data at.
-// \param data  : Data to insert.
-// Returns TRUE on success, FALSE otherwise.
-//
-bool linked_list_insert(struct linked_list * ll,
-                        size_t index,
-                        unsigned int data){
-    if(ll == NULL) 
+// Counts a new iterator on ll if ll is adaptive, otherwise remembers that
+// ll had one it cannot follow.
+// Returns whether it was counted.
+// Assuming ll != NULL
+static inline bool __linked_list_open_iterator(struct linked_list* ll){
+    if(!ll->adaptive.enabled){
+        ll->adaptive.untracked = true;
         return false;
+    }
 
-    if(ll->size < index)
-        return false;
+    ll->adaptive.iterators += 1;
+    return true;
+}
 
-    if(index == 0)
-        return linked_list_insert_front(ll, data);
-    
-    if(index == ll->size)
-        return linked_list_insert_end(ll, data);
+// Counts an operation in the middle of ll.
+// Assuming ll != NULL
+static inline void __linked_list_note_positional(struct linked_list* ll){
+    struct adaptive_policy* adaptive = &ll->adaptive;
+    if(!adaptive->enabled)
+        return;
 
-    struct node* new_node = __linked_list_get_new_node(ll);
+    adaptive->sequential = 0;
+    adaptive->positional += 1;
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT && adaptive->positional >= ADAPTIVE_MIN_OPS &&
+       adaptive->iterators == 0)
+        __linked_list_adapt(ll, LINKED_LIST_LAYOUT_NODES);
+}
 
-    if(new_node == NULL)
-        return false;
-    
+// Positional index.
+// The list is cut into segments of consecutive nodes. A skip list over the
+// segments, in which every link records how many nodes it jumps over, finds
+// the segment holding any position in O(log n). The node itself is then at
+// most 2 * SKIP_INDEX_SEGMENT steps away from the start of its segment.
+//
+#define SKIP_INDEX_SEGMENT 32
+#define SKIP_INDEX_MAX_LEVEL 24
 
-    new_node->data = data;
-    new_node->next = NULL;
+struct skip_index_entry;
 
-    struct node* curr = ll->head;
+struct skip_index_link {
+    struct skip_index_entry * next;
+    size_t width;   // start(next) - start(owner), unused when next is NULL
+};
 
-    // TODO: check for off by one error
-    for(size_t i = 0; i < index-1; i++){
-        curr = curr->next;
+struct skip_index_entry {
+    struct node * first;
+    size_t length;
+    int levels;
+    struct skip_index_link links[];
+};
+
+// stale is set when the index could not follow a change to the list. It is
+// rebuilt from the list on next use.
+//
+struct skip_index {
+    struct skip_index_entry * header;
+    int levels;
+    uint32_t seed;
+    bool stale;
+};
+
+struct skip_index_entry * __skip_index_new_entry(int levels){
+    struct skip_index_entry* entry = malloc_fptr(sizeof(struct skip_index_entry) +
+                                                 levels * sizeof(struct skip_index_link));
+    if(entry == NULL)
+        return NULL;
+
+    entry->first = NULL;
+    entry->length = 0;
+    entry->levels = levels;
+    for(int l = 0; l < levels; l++){
+        entry->links[l].next = NULL;
+        entry->links[l].width = 0;
     }
+    return entry;
+}
 
-    struct node* tmp = curr->next;
-    curr->next = new_node;
-    new_node->next = tmp;
-    ll->size += 1;
-    return true;
+// Each level holds a quarter of the entries of the level below.
+//
+int __skip_index_random_level(struct skip_index* index){
+    uint32_t x = index->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    index->seed = x;
+
+    int level = 1;
+    while((x & 3) == 0 && level < SKIP_INDEX_MAX_LEVEL){
+        level++;
+        x >>= 2;
+    }
+    return level;
 }
 
-// Finds the first occurrence of data and returns its index.
-// \param ll   : Pointer to linked_list.
-// \param data : Data to find.
-// Returns index of the first index with that data, SIZE_MAX otherwise.
+// Frees every entry except the header.
 //
-size_t linked_list_find(struct linked_list * ll,
-                        unsigned int data){
-    if(ll == NULL)
-        return SIZE_MAX;
-    
+void __skip_index_clear(struct skip_index* index){
+    struct skip_index_entry* curr = index->header->links[0].next;
+    while(curr != NULL){
+        struct skip_index_entry* next = curr->links[0].next;
+        free_fptr(curr);
+        curr = next;
+    }
+    for(int l = 0; l < SKIP_INDEX_MAX_LEVEL; l++){
+        index->header->links[l].next = NULL;
+        index->header->links[l].width = 0;
+    }
+    index->levels = 1;
+    index->stale = false;
+}
+
+// Rebuilds the index from scratch with full segments.
+// Assuming ll != NULL and ll->index != NULL
+bool __skip_index_rebuild(struct linked_list* ll){
+    struct skip_index* index = ll->index;
+    __skip_index_clear(index);
+
+    struct skip_index_entry* last[SKIP_INDEX_MAX_LEVEL];
+    size_t last_start[SKIP_INDEX_MAX_LEVEL];
+    for(int l = 0; l < SKIP_INDEX_MAX_LEVEL; l++){
+        last[l] = index->header;
+        last_start[l] = 0;
+    }
+
     struct node* curr = ll->head;
-    size_t index = 0;
+    for(size_t start = 0; start < ll->size; start += SKIP_INDEX_SEGMENT){
+        int levels = __skip_index_random_level(index);
+        struct skip_index_entry* entry = __skip_index_new_entry(levels);
+        if(entry == NULL){
+            __skip_index_clear(index);
+            index->stale = true;
+            return false;
+        }
+
+        entry->first = curr;
+        entry->length = ll->size - start < SKIP_INDEX_SEGMENT ? ll->size - start : SKIP_INDEX_SEGMENT;
+        for(size_t i = 0; i < entry->length; i++){
+            curr = curr->next;
+        }
+
+        for(int l = 0; l < levels; l++){
+            last[l]->links[l].next = entry;
+            last[l]->links[l].width = start - last_start[l];
+            last[l] = entry;
+            last_start[l] = start;
+        }
+        if(levels > index->levels)
+            index->levels = levels;
+    }
+    return true;
+}
 
-    // TODO: should we use iterators?
-    while(curr != NULL && index < ll->size){
-        if(curr->data == data){
-            return index;
+// Finds the entry whose segment holds position. For every level, update
+// receives the last entry at that level starting at or before position,
+// and rank the start of that entry.
+// Assuming the index is not stale and position < ll->size
+struct skip_index_entry * __skip_index_seek(struct skip_index* index,
+                                            size_t position,
+                                            struct skip_index_entry** update,
+                                            size_t* rank,
+                                            size_t* start){
+    struct skip_index_entry* x = index->header;
+    size_t pos = 0;
+    for(int l = index->levels - 1; l >= 0; l--){
+        while(x->links[l].next != NULL && pos + x->links[l].width <= position){
+            pos += x->links[l].width;
+            x = x->links[l].next;
+        }
+        if(update != NULL){
+            update[l] = x;
+            rank[l] = pos;
         }
+    }
+    *start = pos;
+    return x;
+}
+
+// Returns the node at position, NULL if the index is unusable.
+// Assuming ll->index != NULL and position < ll->size
+struct node * __skip_index_node_at(struct linked_list* ll, size_t position){
+    if(ll->index->stale && !__skip_index_rebuild(ll))
+        return NULL;
+
+    size_t start;
+    struct skip_index_entry* entry = __skip_index_seek(ll->index, position, NULL, NULL, &start);
+    struct node* curr = entry->first;
+    for(size_t i = start; i < position; i++){
         curr = curr->next;
-        index++;
     }
-    return SIZE_MAX;
+    STATS_WALK(ll, position - start);
+    return curr;
 }
 
+// Records that node was linked in at position. ll->size already counts it.
+// Assuming ll->index != NULL
+void __skip_index_note_insert(struct linked_list* ll, size_t position, struct node* node){
+    struct skip_index* index = ll->index;
+    if(index->stale)
+        return;
 
+    if(ll->size == 1){
+        int levels = __skip_index_random_level(index);
+        struct skip_index_entry* entry = __skip_index_new_entry(levels);
+        if(entry == NULL){
+            index->stale = true;
+            return;
+        }
+        entry->first = node;
+        entry->length = 1;
+        for(int l = 0; l < levels; l++){
+            index->header->links[l].next = entry;
+            index->header->links[l].width = 0;
+        }
+        index->levels = levels;
+        return;
+    }
 
-// Assuming ll != NULL;; consider making this public
-bool __linked_list_remove_top(struct  linked_list * ll){
-    struct node* tmp = ll->head;
-    if(tmp == NULL) return false;
-    
-    ll->head = tmp->next;
-    // free_fptr(tmp);
-    __linked_list_save_in_free_stack(ll, tmp);
-    ll->size -= 1;
+    // The new node joins the segment of its predecessor, or becomes the
+    // first node of the first segment.
+    //
+    struct skip_index_entry* update[SKIP_INDEX_MAX_LEVEL];
+    size_t rank[SKIP_INDEX_MAX_LEVEL];
+    size_t start;
+    struct skip_index_entry* x = __skip_index_seek(index, position == 0 ? 0 : position - 1,
+                                                   update, rank, &start);
+    if(position == 0)
+        x->first = node;
+    x->length += 1;
+    for(int l = 0; l < index->levels; l++){
+        if(update[l]->links[l].next != NULL)
+            update[l]->links[l].width += 1;
+    }
 
-    if(ll->size <= 1){
-        ll->tail = ll->head;
+    if(x->length <= 2 * SKIP_INDEX_SEGMENT)
+        return;
+
+    // Split an overgrown segment in two halves.
+    //
+    int levels = __skip_index_random_level(index);
+    struct skip_index_entry* y = __skip_index_new_entry(levels);
+    if(y == NULL)
+        return;
+
+    y->first = x->first;
+    for(size_t i = 0; i < SKIP_INDEX_SEGMENT; i++){
+        y->first = y->first->next;
     }
-    
-    return true;
+    y->length = x->length - SKIP_INDEX_SEGMENT;
+    x->length = SKIP_INDEX_SEGMENT;
+
+    size_t y_start = start + SKIP_INDEX_SEGMENT;
+    for(int l = 0; l < levels; l++){
+        if(l >= index->levels){
+            update[l] = index->header;
+            rank[l] = 0;
+        }
+        struct skip_index_link* link = &update[l]->links[l];
+        y->links[l].next = link->next;
+        if(link->next != NULL)
+            y->links[l].width = link->width - (y_start - rank[l]);
+        link->next = y;
+        link->width = y_start - rank[l];
+    }
+    if(levels > index->levels)
+        index->levels = levels;
 }
 
-// Removes a node from the linked_list at a specific index.
-// \param ll    : Pointer to linked_list.
-// \param index : Index to remove node.
+// Records that the node at position was unlinked, next being the node that
+// followed it. ll->size no longer counts it.
+// Assuming ll->index != NULL
+void __skip_index_note_remove(struct linked_list* ll, size_t position, struct node* next){
+    struct skip_index* index = ll->index;
+    if(index->stale)
+        return;
+
+    struct skip_index_entry* update[SKIP_INDEX_MAX_LEVEL];
+    size_t rank[SKIP_INDEX_MAX_LEVEL];
+    size_t start;
+    struct skip_index_entry* x = __skip_index_seek(index, position, update, rank, &start);
+
+    x->length -= 1;
+    if(x->length > 0){
+        if(position == start)
+            x->first = next;
+        for(int l = 0; l < index->levels; l++){
+            if(update[l]->links[l].next != NULL)
+                update[l]->links[l].width -= 1;
+        }
+        return;
+    }
+
+    // The segment is empty, unlink its entry. Its predecessors at every
+    // level are the last entries starting strictly before it.
+    //
+    if(start == 0){
+        for(int l = 0; l < index->levels; l++){
+            update[l] = index->header;
+        }
+    }
+    else {
+        __skip_index_seek(index, start - 1, update, rank, &start);
+    }
+
+    for(int l = 0; l < index->levels; l++){
+        struct skip_index_link* link = &update[l]->links[l];
+        if(link->next == x){
+            link->next = x->links[l].next;
+            link->width += x->links[l].width - 1;
+        }
+        else if(link->next != NULL){
+            link->width -= 1;
+        }
+    }
+    free_fptr(x);
+
+    while(index->levels > 1 && index->header->links[index->levels - 1].next == NULL){
+        index->levels--;
+    }
+}
+
+// Enables the positional index of a linked_list. While enabled,
+// linked_list_insert(), linked_list_remove() and
+// linked_list_create_iterator() reach any index in O(log n), at the cost
+// of O(log n) bookkeeping on every insertion and removal.
+// \param ll : Pointer to linked_list.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_NODES.
 // Returns TRUE on success, FALSE otherwise.
 //
-bool linked_list_remove(struct linked_list * ll,
-                        size_t index){
+bool linked_list_enable_index(struct linked_list * ll){
     if(ll == NULL)
         return false;
-    
-    if(ll->size <= index)
+
+    if(ll->adaptive.enabled && !__linked_list_adapt(ll, LINKED_LIST_LAYOUT_NODES))
         return false;
 
-    if(index == 0){
-        return __linked_list_remove_top(ll);
-    }
+    if(ll->layout != LINKED_LIST_LAYOUT_NODES)
+        return false;
 
-    struct node* curr = ll->head;
-    
-    for(size_t i = 0; i < index - 1; i++){
-        curr = curr->next;
-    }
+    if(ll->index != NULL)
+        return true;
 
-    struct node* node_to_remove = curr->next;
-    
-    // Update tail if needed
-    if(index == ll->size - 1){
-        ll->tail = curr;
+    struct skip_index* index = malloc_fptr(sizeof(struct skip_index));
+    if(index == NULL)
+        return false;
+
+    index->header = __skip_index_new_entry(SKIP_INDEX_MAX_LEVEL);
+    if(index->header == NULL){
+        free_fptr(index);
+        return false;
     }
-    
-    curr->next = node_to_remove->next;
-    // free_fptr(node_to_remove);
-    __linked_list_save_in_free_stack(ll, node_to_remove);
-    
-    ll->size -= 1;
+    index->levels = 1;
+    index->seed = 0x9e3779b9u;
+    index->stale = true;
+
+    ll->index = index;
     return true;
 }
 
-// Creates an iterator struct at a particular index.
-// \param linked_list : Pointer to linked_list.
-// \param index       : Index of the linked list to start at.
-// Returns pointer to an iterator on success, NULL otherwise.
+// Disables and frees the positional index of a linked_list.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
 //
-struct iterator * linked_list_create_iterator(struct linked_list * ll,
-                                              size_t index){
+bool linked_list_disable_index(struct linked_list * ll){
     if(ll == NULL)
-        return NULL;
-    
-    if(index >= ll->size)
-        return NULL;
-    
-    struct node* curr = ll->head;
+        return false;
+
+    if(ll->index == NULL)
+        return true;
+
+    __skip_index_clear(ll->index);
+    free_fptr(ll->index->header);
+    free_fptr(ll->index);
+    ll->index = NULL;
+    return true;
+}
+
+// Hash index.
+// An open addressing table, probed linearly, from every value in the list
+// to its number of occurrences and the position of the first one. Counts
+// are always exact, so a value that is not in the list is found missing
+// without walking it.
+// Positions are stored as base + position. Inserting or removing at the
+// front moves base instead of every entry, and appending keeps all of them
+// valid. Any other change lowers valid_end, and first positions outside
+// [base, valid_end) are recomputed by one walk on the next lookup that
+// needs them. Once removals at the front move base past valid_end, first
+// positions left below base may be anything, and the range stays empty
+// until then.
+//
+#define HASH_INDEX_MIN_CAPACITY 16
+#define HASH_INDEX_BASE (SIZE_MAX / 2)
+#define HASH_INDEX_UNKNOWN SIZE_MAX
+
+// count is 0 for an empty slot.
+//
+struct hash_index_entry {
+    size_t count;
+    size_t first;
+    unsigned int value;
+};
 
-    for(size_t i = 0; i <= index; i++){
-        if(curr == NULL){
+// size is the number of elements the index has seen, stale is set when an
+// allocation failed and the counts could not follow the list. It is then
+// rebuilt from the list on next use.
+//
+struct hash_index {
+    struct hash_index_entry * entries;
+    size_t capacity;
+    size_t used;
+    unsigned int shift;
+    size_t size;
+    size_t base;
+    size_t valid_end;
+    bool stale;
+};
+
+static inline size_t __hash_index_home(const struct hash_index* hash, unsigned int value){
+    return (size_t)(((uint64_t)value * 0x9e3779b97f4a7c15ull) >> hash->shift);
+}
+
+// Returns the entry of value, or the empty slot it would go in.
+// Assuming hash->capacity > hash->used
+static inline struct hash_index_entry * __hash_index_probe(const struct hash_index* hash, unsigned int value){
+    size_t mask = hash->capacity - 1;
+    size_t slot = __hash_index_home(hash, value);
+    while(hash->entries[slot].count != 0 && hash->entries[slot].value != value){
+        slot = (slot + 1) & mask;
+    }
+    return &hash->entries[slot];
+}
+
+// Moves every entry into a new table of capacity slots.
+// Returns FALSE if the table could not be allocated, hash is unchanged.
+bool __hash_index_resize(struct hash_index* hash, size_t capacity){
+    struct hash_index_entry* entries = malloc_fptr(capacity * sizeof(struct hash_index_entry));
+    if(entries == NULL)
+        return false;
+    memset(entries, 0, capacity * sizeof(struct hash_index_entry));
+
+    struct hash_index_entry* old = hash->entries;
+    size_t old_capacity = hash->capacity;
+    hash->entries = entries;
+    hash->capacity = capacity;
+    hash->shift = 64 - (unsigned int)__builtin_ctzll(capacity);
+    for(size_t i = 0; i < old_capacity; i++){
+        if(old[i].count != 0)
+            *__hash_index_probe(hash, old[i].value) = old[i];
+    }
+    if(old != NULL)
+        free_fptr(old);
+    return true;
+}
+
+// Returns the entry of value, adding an empty one, with count 0, when the
+// value is new. The table is kept at most half full.
+// Returns NULL if the table had to grow and could not.
+struct hash_index_entry * __hash_index_add(struct hash_index* hash, unsigned int value){
+    struct hash_index_entry* entry = __hash_index_probe(hash, value);
+    if(entry->count != 0)
+        return entry;
+
+    if(2 * (hash->used + 1) > hash->capacity){
+        if(!__hash_index_resize(hash, 2 * hash->capacity))
             return NULL;
-        }
-        // TODO: find a better way of doing this
-        if(i == index){
+        entry = __hash_index_probe(hash, value);
+    }
+    entry->value = value;
+    entry->first = HASH_INDEX_UNKNOWN;
+    hash->used += 1;
+    return entry;
+}
+
+// Empties the slot of entry, shifting back the entries probed past it.
+void __hash_index_erase(struct hash_index* hash, struct hash_index_entry* entry){
+    size_t mask = hash->capacity - 1;
+    size_t hole = (size_t)(entry - hash->entries);
+    size_t slot = hole;
+    for(;;){
+        slot = (slot + 1) & mask;
+        if(hash->entries[slot].count == 0)
             break;
+        size_t home = __hash_index_home(hash, hash->entries[slot].value);
+        if(((slot - home) & mask) >= ((slot - hole) & mask)){
+            hash->entries[hole] = hash->entries[slot];
+            hole = slot;
         }
-        curr = curr->next;
     }
+    hash->entries[hole].count = 0;
+    hash->used -= 1;
+}
 
-    struct iterator* iter = malloc_fptr(sizeof(struct iterator));
-    if(iter == NULL)
-        return NULL;
+// Forgets every value. The table keeps its capacity.
+void __hash_index_clear(struct hash_index* hash){
+    memset(hash->entries, 0, hash->capacity * sizeof(struct hash_index_entry));
+    hash->used = 0;
+    hash->size = 0;
+    hash->base = HASH_INDEX_BASE;
+    hash->valid_end = HASH_INDEX_BASE;
+    hash->stale = false;
+}
 
-    iter->ll = ll;
-    iter->current_node = curr;
-    iter->current_index = index;
-    iter->data = curr->data;
+// Recounts every value of the list from scratch.
+// Returns FALSE if the table could not grow, the index is left stale.
+// Assuming ll != NULL and ll->hash != NULL
+bool __hash_index_rebuild(struct linked_list* ll){
+    struct hash_index* hash = ll->hash;
+    __hash_index_clear(hash);
 
-    return iter;
+    size_t position = 0;
+    for(struct node* curr = ll->head; curr != NULL; curr = curr->next, position++){
+        struct hash_index_entry* entry = __hash_index_add(hash, curr->data);
+        if(entry == NULL){
+            hash->stale = true;
+            return false;
+        }
+        if(entry->count == 0)
+            entry->first = hash->base + position;
+        entry->count += 1;
+    }
+    hash->size = ll->size;
+    hash->valid_end = hash->base + ll->size;
+    return true;
 }
 
-// Deletes an iterator struct.
-// \param iterator : Iterator to delete.
+// Recomputes every first position with one walk, stopping once each value
+// has been seen.
+// Assuming ll != NULL, ll->hash != NULL and the index is not stale
+void __hash_index_refresh(struct linked_list* ll){
+    struct hash_index* hash = ll->hash;
+    for(size_t i = 0; i < hash->capacity; i++){
+        hash->entries[i].first = HASH_INDEX_UNKNOWN;
+    }
+    hash->base = HASH_INDEX_BASE;
+
+    size_t seen = 0;
+    size_t position = 0;
+    for(struct node* curr = ll->head; curr != NULL && seen < hash->used; curr = curr->next, position++){
+        struct hash_index_entry* entry = __hash_index_probe(hash, curr->data);
+        if(entry->first == HASH_INDEX_UNKNOWN){
+            entry->first = hash->base + position;
+            seen++;
+        }
+    }
+    STATS_WALK(ll, position);
+    hash->valid_end = hash->base + ll->size;
+}
+
+// Records data inserted at position.
+// Assuming ll != NULL and ll->hash != NULL
+void __hash_index_note_insert(struct linked_list* ll, size_t position, unsigned int data){
+    struct hash_index* hash = ll->hash;
+    if(hash->stale)
+        return;
+
+    struct hash_index_entry* entry = __hash_index_add(hash, data);
+    if(entry == NULL){
+        hash->stale = true;
+        return;
+    }
+
+    size_t size = hash->size;
+    hash->size += 1;
+    if(position == 0){
+        // Everything moved up by one: so does the origin. An empty range
+        // stays empty, the new origin may hold a left over first position.
+        bool empty = hash->valid_end <= hash->base;
+        hash->base -= 1;
+        entry->first = hash->base;
+        if(empty)
+            hash->valid_end = hash->base;
+    }
+    else{
+        size_t at = hash->base + position;
+        if(position < size && hash->valid_end > at)
+            hash->valid_end = at;
+        if(entry->count == 0)
+            entry->first = at;
+        if(position == size && hash->valid_end == at)
+            hash->valid_end = at + 1;
+    }
+    entry->count += 1;
+}
+
+// Records the removal of data from position, HASH_INDEX_UNKNOWN if the
+// caller does not know it.
+// Assuming ll != NULL and ll->hash != NULL
+void __hash_index_note_remove(struct linked_list* ll, size_t position, unsigned int data){
+    struct hash_index* hash = ll->hash;
+    if(hash->stale)
+        return;
+
+    struct hash_index_entry* entry = __hash_index_probe(hash, data);
+    assert(entry->count != 0);
+    hash->size -= 1;
+    if(position == 0 && entry->first == hash->base)
+        entry->first = HASH_INDEX_UNKNOWN;
+    entry->count -= 1;
+    if(entry->count == 0)
+        __hash_index_erase(hash, entry);
+
+    if(position == 0){
+        hash->base += 1;
+    }
+    else if(position == HASH_INDEX_UNKNOWN){
+        hash->valid_end = hash->base;
+    }
+    else if(hash->valid_end > hash->base + position){
+        hash->valid_end = hash->base + position;
+    }
+}
+
+// Returns the position of the first occurrence of data, SIZE_MAX if there
+// is none.
+// Assuming ll != NULL, ll->hash != NULL and the index is not stale
+size_t __hash_index_find(struct linked_list* ll, unsigned int data){
+    struct hash_index* hash = ll->hash;
+    struct hash_index_entry* entry = __hash_index_probe(hash, data);
+    if(entry->count == 0)
+        return SIZE_MAX;
+
+    if(entry->first < hash->base || entry->first >= hash->valid_end)
+        __hash_index_refresh(ll);
+    return entry->first - hash->base;
+}
+
+// Returns whether the hash index of ll can answer lookups, rebuilding it if
+// it went stale.
+// Assuming ll != NULL
+static inline bool __hash_index_usable(struct linked_list* ll){
+    return ll->hash != NULL && (!ll->hash->stale || __hash_index_rebuild(ll));
+}
+
+// Enables the hash index of a linked_list. While enabled,
+// linked_list_contains() is O(1) and linked_list_find() O(1) expected:
+// first positions moved by insertions or removals other than at the front
+// or the end are recomputed, with one walk, by the next lookup that needs
+// one. Every insertion and removal updates the index in O(1).
+// \param ll : Pointer to linked_list.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_NODES or
+//               LINKED_LIST_LAYOUT_DOUBLY.
 // Returns TRUE on success, FALSE otherwise.
 //
-bool linked_list_delete_iterator(struct iterator * iter){
-    if(iter == NULL)
+bool linked_list_enable_hash_index(struct linked_list * ll){
+    if(ll == NULL)
         return false;
 
-    free_fptr(iter);
+    if(ll->adaptive.enabled && !__linked_list_adapt(ll, LINKED_LIST_LAYOUT_NODES))
+        return false;
+
+    if(ll->layout != LINKED_LIST_LAYOUT_NODES && ll->layout != LINKED_LIST_LAYOUT_DOUBLY)
+        return false;
+
+    if(ll->hash != NULL)
+        return true;
+
+    struct hash_index* hash = malloc_fptr(sizeof(struct hash_index));
+    if(hash == NULL)
+        return false;
+
+    hash->entries = NULL;
+    hash->capacity = 0;
+    hash->used = 0;
+    if(!__hash_index_resize(hash, HASH_INDEX_MIN_CAPACITY)){
+        free_fptr(hash);
+        return false;
+    }
 
+    ll->hash = hash;
+    if(!__hash_index_rebuild(ll)){
+        linked_list_disable_hash_index(ll);
+        return false;
+    }
     return true;
 }
 
-// Iterates to the next node in the linked_list.
-// \param iterator: Iterator to iterate on.
-// Returns TRUE when next node is present, FALSE once end of list is reached.
+// Disables and frees the hash index of a linked_list.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
 //
-bool linked_list_iterate(struct iterator * iter){
-    if(iter == NULL)
+bool linked_list_disable_hash_index(struct linked_list * ll){
+    if(ll == NULL)
         return false;
 
-    if(iter->current_index + 1 >= iter->ll->size){
+    if(ll->hash == NULL)
+        return true;
+
+    free_fptr(ll->hash->entries);
+    free_fptr(ll->hash);
+    ll->hash = NULL;
+    return true;
+}
+
+// Returns whether data is in the linked_list. O(1) with the hash index
+// enabled, a linked_list_find() otherwise.
+// \param ll   : Pointer to linked_list.
+// \param data : Data to look for.
+// Returns TRUE if data is in the linked_list, FALSE otherwise.
+//
+bool linked_list_contains(struct linked_list * ll,
+                          unsigned int data){
+    if(ll == NULL)
         return false;
+
+    if(__hash_index_usable(ll))
+        return __hash_index_probe(ll->hash, data)->count != 0;
+
+    return linked_list_find(ll, data) != SIZE_MAX;
+}
+
+// Software prefetching, see linked_list_set_prefetch().
+// A walk only learns the address of a node by loading its predecessor, so
+// in general nothing further than the next node can be requested early.
+// Nodes handed out from the same block are the exception: while a walk is
+// inside a run of physically consecutive nodes, the node distance steps
+// ahead is most likely at curr + distance.
+//
+
+// Starts loading what a walk currently at node will read next.
+// Assuming node != NULL
+static inline void __linked_list_prefetch_after(const struct node* node, size_t distance){
+    __builtin_prefetch(node->next);
+    if(node->next == node + 1)
+        __builtin_prefetch(node + distance);
+}
+
+// Same as __linked_list_prefetch_after(), for a compact linked_list.
+// Assuming slot != LINKED_LIST_COMPACT_NIL
+static inline void __linked_list_prefetch_after_slot(const struct compact_node* nodes,
+                                                     uint32_t slot,
+                                                     size_t distance){
+    uint32_t next = nodes[slot].next;
+    if(next == LINKED_LIST_COMPACT_NIL)
+        return;
+    __builtin_prefetch(nodes + next);
+    if(next == slot + 1)
+        __builtin_prefetch(nodes + slot + distance);
+}
+
+// Returns the node at position, through the index when there is one.
+// Assuming ll != NULL and position < ll->size
+struct node * __linked_list_node_at(struct linked_list* ll, size_t position){
+    if(ll->index != NULL){
+        struct node* node = __skip_index_node_at(ll, position);
+        if(node != NULL)
+            return node;
     }
 
-    iter->current_node = iter->current_node->next;
-    iter->current_index++;
-    iter->data = iter->current_node->data;
+    bool doubly = ll->layout == LINKED_LIST_LAYOUT_DOUBLY;
+    struct node* curr = ll->head;
+    size_t steps = position;
+    bool backwards = false;
+    if(doubly && ll->size - 1 - position < steps){
+        curr = ll->tail;
+        steps = ll->size - 1 - position;
+        backwards = true;
+    }
+
+    struct linked_list_finger* used = NULL;
+    for(size_t i = 0; i < LINKED_LIST_FINGERS; i++){
+        struct linked_list_finger* finger = &ll->fingers[i];
+        if(finger->node == NULL)
+            continue;
+        if(finger->index <= position && position - finger->index < steps){
+            curr = finger->node;
+            steps = position - finger->index;
+            backwards = false;
+            used = finger;
+        }
+        else if(doubly && finger->index > position && finger->index - position < steps){
+            curr = finger->node;
+            steps = finger->index - position;
+            backwards = true;
+            used = finger;
+        }
+    }
+
+    STATS_WALK(ll, steps);
+    size_t distance = ll->prefetch_distance;
+    if(backwards){
+        for(size_t i = 0; i < steps; i++){
+            curr = __linked_list_prev(curr);
+        }
+    }
+    else if(distance != 0){
+        for(size_t i = 0; i < steps; i++){
+            if(curr->next == curr + 1)
+                __builtin_prefetch(curr + distance);
+            curr = curr->next;
+        }
+    }
+    else{
+        for(size_t i = 0; i < steps; i++){
+            curr = curr->next;
+        }
+    }
+
+    if(used == NULL){
+        used = &ll->fingers[ll->finger_next];
+        ll->finger_next = (ll->finger_next + 1) % LINKED_LIST_FINGERS;
+    }
+    used->node = curr;
+    used->index = position;
+    return curr;
+}
+
+// Frees a node_pool together with every block it handed out.
+// Assuming pool != NULL
+void __node_pool_free(struct node_pool * pool){
+    __linked_list_free_blocks(&pool->blocks);
+    if(pool->blocks.entries != NULL)
+        free_fptr(pool->blocks.entries);
+    free_fptr(pool);
+}
+
+// Detaches ll from its node_pool, freeing the pool if it was deleted and
+// ll was the last linked_list using it.
+// PRECONDITION: ll holds no nodes.
+// Assuming ll != NULL
+void __linked_list_detach_pool(struct linked_list * ll){
+    struct node_pool* pool = ll->pool;
+    if(pool == NULL)
+        return;
+
+    ll->pool = NULL;
+    pool->lists -= 1;
+    if(pool->deleted && pool->lists == 0)
+        __node_pool_free(pool);
+}
+
+// Creates an empty node_pool.
+// Returns a new node_pool on success, NULL on failure.
+//
+struct node_pool * node_pool_create(void){
+    struct node_pool* pool = malloc_fptr(sizeof(struct node_pool));
+    if(pool == NULL)
+        return NULL;
+
+    pool->free_stack = NULL;
+    pool->chunk_free_stack = NULL;
+    pool->blocks.entries = NULL;
+    pool->blocks.count = 0;
+    pool->blocks.capacity = 0;
+    pool->blocks.values = 0;
+    pool->carve.next = NULL;
+    pool->carve.end = NULL;
+    pool->carve.spare = NULL;
+    pool->chunk_carve.next = NULL;
+    pool->chunk_carve.end = NULL;
+    pool->chunk_carve.spare = NULL;
+    pool->node_bytes = sizeof(struct node);
+    pool->lists = 0;
+    pool->deleted = false;
+    return pool;
+}
+
+// Deletes a node_pool. If linked_lists are still attached, the pool is
+// only freed once the last of them is deleted or detached.
+// \param pool : Pointer to node_pool.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool node_pool_delete(struct node_pool * pool){
+    if(pool == NULL || pool->deleted)
+        return false;
+
+    pool->deleted = true;
+    if(pool->lists == 0)
+        __node_pool_free(pool);
+    return true;
+}
+
+// Makes an empty linked_list take its nodes from pool, and give removed
+// nodes back to it. A NULL pool switches back to private allocation.
+// \param ll   : Pointer to linked_list.
+// \param pool : Pointer to node_pool, or NULL.
+// PRECONDITION: linked_list is empty and neither LINKED_LIST_LAYOUT_COMPACT
+//               nor LINKED_LIST_LAYOUT_DOUBLY. Any cached nodes are
+//               released.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_attach_pool(struct linked_list * ll,
+                             struct node_pool * pool){
+    if(ll == NULL)
+        return false;
+
+    if(ll->size != 0)
+        return false;
+
+    if(pool != NULL && pool->deleted)
+        return false;
+
+    if(pool != NULL && ll->adaptive.enabled && !__linked_list_adapt(ll, LINKED_LIST_LAYOUT_NODES))
+        return false;
+
+    if(pool != NULL && !__node_pool_accepts(pool, ll->layout))
+        return false;
+
+    if(pool == ll->pool)
+        return true;
+
+    linked_list_remove_all(ll);
+    __linked_list_detach_pool(ll);
+    if(pool != NULL){
+        pool->lists += 1;
+        ll->pool = pool;
+    }
+    return true;
+}
+
+// Deletes a linked_list.
+// \param ll : Pointer to linked_list to delete
+// POSTCONDITION : An empty linked_list has its head point to NULL.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_delete(struct linked_list * ll){
+    if(ll == NULL)
+        return false;
+
+    linked_list_delete_in_place(ll);
+    free_fptr(ll);
+
+    return true;    
+}
+
+// Frees everything owned by a linked_list created with
+// linked_list_create_in_place(), but not the linked_list itself.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_delete_in_place(struct linked_list * ll){
+    if(ll == NULL)
+        return false;
+
+    __linked_list_release_blocks(ll);
+    if(ll->blocks.entries != NULL)
+        free_fptr(ll->blocks.entries);
+    ll->blocks.entries = NULL;
+    ll->blocks.capacity = 0;
+    ll->size = 0;
+    linked_list_disable_index(ll);
+    linked_list_disable_hash_index(ll);
+    __linked_list_detach_pool(ll);
+
+    return true;
+}
+
+// Removes all elements from linked list
+// Returns TRUE on success, FALSE otherwise
+bool linked_list_remove_all(struct linked_list * ll){
+    if(ll == NULL)
+        return false;
+
+    __linked_list_release_blocks(ll);
+    ll->size = 0;
+
+    if(ll->index != NULL)
+        __skip_index_clear(ll->index);
+    if(ll->hash != NULL)
+        __hash_index_clear(ll->hash);
+
+    return true;    
+}
+
+// Changes the storage layout of an empty linked_list.
+// \param ll     : Pointer to linked_list.
+// \param layout : Layout to switch to.
+// PRECONDITION: linked_list is empty. Any cached nodes are released.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_layout(struct linked_list * ll,
+                            enum linked_list_layout layout){
+    if(ll == NULL)
+        return false;
+
+    if(ll->size != 0)
+        return false;
+
+    if(layout != LINKED_LIST_LAYOUT_NODES && layout != LINKED_LIST_LAYOUT_UNROLLED &&
+       layout != LINKED_LIST_LAYOUT_COMPACT && layout != LINKED_LIST_LAYOUT_DOUBLY)
+        return false;
+
+    if(layout != LINKED_LIST_LAYOUT_NODES && ll->index != NULL)
+        return false;
+
+    if(layout != LINKED_LIST_LAYOUT_NODES && layout != LINKED_LIST_LAYOUT_DOUBLY && ll->hash != NULL)
+        return false;
+
+    if(ll->pool != NULL && !__node_pool_accepts(ll->pool, layout))
+        return false;
+
+    if(ll->adaptive.enabled && layout != LINKED_LIST_LAYOUT_NODES && layout != LINKED_LIST_LAYOUT_COMPACT)
+        return false;
+
+    linked_list_remove_all(ll);
+    ll->layout = layout;
+    return true;
+}
+
+// Lets the linked_list pick its layout from the way it is used. A
+// linked_list that mostly sees insertions and removals at its ends, scans
+// and iteration moves its values, in order, into a compact arena: one
+// contiguous array that is walked sequentially. Once operations in the
+// middle dominate it moves back to nodes. Switching copies the values once
+// and never happens while an iterator created since is open, delete those
+// before the linked_list. Iterators created before are not tracked, so a
+// linked_list that ever had one cannot be made adaptive. Disabling it
+// moves the linked_list back to nodes.
+// \param ll      : Pointer to linked_list.
+// \param enabled : TRUE to switch layouts automatically.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_NODES and never had an
+//               iterator, or is already adaptive. It does not switch
+//               while it has an index or a node_pool, and functions taking
+//               two linked_lists need both in the same layout.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_adaptive(struct linked_list * ll, bool enabled){
+    if(ll == NULL)
+        return false;
+
+    if(!ll->adaptive.enabled && ll->layout != LINKED_LIST_LAYOUT_NODES)
+        return false;
+
+    // An iterator created before is not counted and may still be open.
+    if(enabled && !ll->adaptive.enabled && ll->adaptive.untracked)
+        return false;
+
+    if(!enabled && ll->adaptive.enabled && !__linked_list_adapt(ll, LINKED_LIST_LAYOUT_NODES))
+        return false;
+
+    ll->adaptive.enabled = enabled;
+    ll->adaptive.sequential = 0;
+    ll->adaptive.positional = 0;
+    return true;
+}
+
+// Returns the size of a linked_list.
+// \param ll : Pointer to linked_list.
+// Returns size on success, SIZE_MAX on failure.
+//
+size_t linked_list_size(struct linked_list * ll){
+    if(ll == NULL)
+        return SIZE_MAX;
+    
+    return ll->size;
+}
+
+// A never used end of an older block, on the spare chain of a
+// block_carve. It is written over the first node of the run, the only one
+// touched before the run is carved from.
+//
+struct carve_run {
+    struct carve_run * next;
+    void * end;
+};
+
+_Static_assert(sizeof(struct carve_run) <= sizeof(struct node),
+               "carve_run is expected to fit in a node");
+
+// Puts what is left of carve, if anything, on its spare chain.
+// Assuming carve != NULL
+void __block_carve_retire(struct block_carve* carve){
+    if(carve->next != carve->end){
+        struct carve_run* run = carve->next;
+        run->next = carve->spare;
+        run->end = carve->end;
+        carve->spare = run;
+    }
+    carve->next = NULL;
+    carve->end = NULL;
+}
+
+// Carves from the first spare run next.
+// Returns FALSE if there is none.
+// Assuming carve != NULL
+bool __block_carve_refill(struct block_carve* carve){
+    struct carve_run* run = carve->spare;
+    if(run == NULL)
+        return false;
+
+    carve->spare = run->next;
+    carve->next = run;
+    carve->end = run->end;
+    return true;
+}
+
+// Number of never used nodes of node_bytes in carve and its spare runs.
+// Assuming carve != NULL
+size_t __block_carve_count(const struct block_carve* carve, size_t node_bytes){
+    size_t count = ((char*)carve->end - (char*)carve->next) / node_bytes;
+    for(const struct carve_run* run = carve->spare; run != NULL; run = run->next){
+        count += ((char*)run->end - (char*)run) / node_bytes;
+    }
+    return count;
+}
+
+// Moves the never used nodes of src to the spare chain of dst.
+// Assuming dst != NULL and src != NULL
+void __block_carve_adopt(struct block_carve* dst, struct block_carve* src){
+    __block_carve_retire(src);
+    if(src->spare != NULL){
+        struct carve_run* last = src->spare;
+        while(last->next != NULL){
+            last = last->next;
+        }
+        last->next = dst->spare;
+        dst->spare = src->spare;
+        src->spare = NULL;
+    }
+    if(dst->next == dst->end)
+        __block_carve_refill(dst);
+}
+
+// Hands out the next never used node of the newest block, or of a spare
+// run once that block is used up.
+// Returns NULL once every one of them is used up.
+// Assuming ll != NULL
+struct node * __linked_list_carve_node(struct linked_list* ll){
+    struct block_carve* carve = __linked_list_carve(ll);
+    if(carve->next == carve->end && !__block_carve_refill(carve))
+        return NULL;
+
+    struct node* node = carve->next;
+    carve->next = (char*)node + __linked_list_node_bytes(ll);
+    node->is_block_head = false;
+    return node;
+}
+
+// Allocates a block of size nodes. The first node is returned to the caller
+// and the others are carved off lazily by __linked_list_carve_node(), so a
+// new block costs one allocation and its pages are only touched once used.
+// Whatever was left of the previous block becomes a spare run.
+// Assuming ll != NULL
+struct node * __linked_list_allocate_block(struct linked_list* ll, size_t size){
+    assert(size >= 1);
+    size_t node_bytes = __linked_list_node_bytes(ll);
+    struct block_memory memory;
+    struct node* head = __linked_list_alloc_block_memory(ll, node_bytes * size, &memory);
+    if(head == NULL)
+        return NULL;
+    if(!__linked_list_register_block(__linked_list_blocks(ll), head, size, false, &memory)){
+        __linked_list_free_block_memory(&memory);
+        return NULL;
+    }
+    
+    head->is_block_head = true;
+
+    struct block_carve* carve = __linked_list_carve(ll);
+    __block_carve_retire(carve);
+    carve->next = (char*)head + node_bytes;
+    carve->end = (char*)head + node_bytes * size;
+    return head;
+}
+
+/// @brief Number of nodes in the next block allocated for ll, see
+///        struct alloc_policy
+/// @param ll 
+/// @return block size in nodes
+size_t __linked_list_block_size(struct linked_list* ll){
+    const struct alloc_policy* policy = &ll->alloc;
+    size_t extra_size = policy->initial_block;
+    if(policy->growth_percent != 0){
+        size_t grown = ll->size / 100 * policy->growth_percent +
+                       ll->size % 100 * policy->growth_percent / 100;
+        if(grown > extra_size)
+            extra_size = grown;
+    }
+    if(policy->max_block != 0 && extra_size > policy->max_block)
+        extra_size = policy->max_block;
+    return extra_size;
+}
+
+/// @brief If there is a free node in free stack, then give that, otherwise
+///        carve one from the newest block, otherwise malloc
+/// @param ll 
+/// @return node pointer for a free noed
+struct node* __linked_list_get_new_node(struct linked_list* ll){
+    STATS_ADD(ll, node_requests, 1);
+    struct node** free_stack = __linked_list_free_stack(ll);
+    if(*free_stack != NULL){
+        struct node* tmp = *free_stack;
+        *free_stack = tmp->next;
+        STATS_ADD(ll, free_stack_hits, 1);
+        return tmp;
+    }
+
+    struct node* node = __linked_list_carve_node(ll);
+    if(node != NULL){
+        STATS_ADD(ll, carve_hits, 1);
+        return node;
+    }
+    return __linked_list_allocate_block(ll, __linked_list_block_size(ll));
+}
+
+/// @brief Takes count nodes from the pool and fills them with data, in order.
+///        Short pools get one block big enough for all remaining nodes, up to
+///        the max_block of the alloc_policy, so a fresh run of nodes is
+///        physically contiguous.
+/// @param ll 
+/// @param data values to store
+/// @param count number of nodes, at least 1
+/// @param last set to the last node of the chain
+/// @return first node of a NULL terminated chain, NULL if allocation failed
+struct node* __linked_list_build_chain(struct linked_list* ll,
+                                       const unsigned int* data,
+                                       size_t count,
+                                       struct node** last){
+    struct node** free_stack = __linked_list_free_stack(ll);
+    struct node* first = NULL;
+    struct node* prev = NULL;
+    STATS_ADD(ll, node_requests, count);
+    for(size_t i = 0; i < count; i++){
+        struct node* node = *free_stack;
+        if(node != NULL){
+            *free_stack = node->next;
+            STATS_ADD(ll, free_stack_hits, 1);
+        }
+        else if((node = __linked_list_carve_node(ll)) != NULL){
+            STATS_ADD(ll, carve_hits, 1);
+        }
+        else{
+            size_t block_size = __linked_list_block_size(ll);
+            if(block_size < count - i)
+                block_size = count - i;
+            block_size = __linked_list_capped_block(ll, block_size, 1);
+            node = __linked_list_allocate_block(ll, block_size);
+            if(node == NULL){
+                // Hand the nodes taken so far back to the free stack.
+                if(prev != NULL)
+                    __linked_list_push_free_nodes(ll, first, prev);
+                return NULL;
+            }
+        }
+
+        node->data = data[i];
+        if(prev == NULL)
+            first = node;
+        else
+            prev->next = node;
+        prev = node;
+    }
+    prev->next = NULL;
+    *last = prev;
+    return first;
+}
+
+// Same as __linked_list_carve_node(), for unrolled nodes.
+// Assuming ll != NULL
+struct unrolled_node * __linked_list_carve_chunk(struct linked_list* ll){
+    struct block_carve* carve = __linked_list_chunk_carve(ll);
+    if(carve->next == carve->end && !__block_carve_refill(carve))
+        return NULL;
+
+    struct unrolled_node* chunk = carve->next;
+    carve->next = chunk + 1;
+    chunk->is_block_head = false;
+    return chunk;
+}
+
+// Same as __linked_list_allocate_block(), for unrolled nodes.
+// Assuming ll != NULL
+struct unrolled_node * __linked_list_allocate_chunk_block(struct linked_list* ll, size_t size){
+    assert(size >= 1);
+    struct block_memory memory;
+    struct unrolled_node* head = __linked_list_alloc_block_memory(ll, sizeof(struct unrolled_node) * size, &memory);
+    if(head == NULL)
+        return NULL;
+    if(!__linked_list_register_block(__linked_list_blocks(ll), head, size, true, &memory)){
+        __linked_list_free_block_memory(&memory);
+        return NULL;
+    }
+
+    head->is_block_head = true;
+
+    struct block_carve* carve = __linked_list_chunk_carve(ll);
+    __block_carve_retire(carve);
+    carve->next = head + 1;
+    carve->end = head + size;
+    return head;
+}
+
+/// @brief Same as __linked_list_get_new_node(), for unrolled nodes
+/// @param ll 
+/// @return empty unrolled node, not linked into the list
+struct unrolled_node* __linked_list_get_new_chunk(struct linked_list* ll){
+    STATS_ADD(ll, node_requests, 1);
+    struct unrolled_node** free_stack = __linked_list_chunk_free_stack(ll);
+    struct unrolled_node* chunk;
+    if(*free_stack != NULL){
+        chunk = *free_stack;
+        *free_stack = chunk->next;
+        STATS_ADD(ll, free_stack_hits, 1);
+    }
+    else if((chunk = __linked_list_carve_chunk(ll)) != NULL){
+        STATS_ADD(ll, carve_hits, 1);
+    }
+    else{
+        // Same growth as __linked_list_get_new_node(), counted in chunks.
+        size_t extra_size = __linked_list_block_size(ll) / LINKED_LIST_UNROLLED_CAPACITY;
+        if(extra_size == 0)
+            extra_size = 1;
+        chunk = __linked_list_allocate_chunk_block(ll, extra_size);
+        if(chunk == NULL)
+            return NULL;
+    }
+    chunk->next = NULL;
+    chunk->count = 0;
+    return chunk;
+}
+
+// Finds the unrolled node holding the value at index.
+// \param prev   : If not NULL, set to the unrolled node before the result.
+// \param offset : Set to the position of the value inside the result.
+// Assuming ll != NULL and index < ll->size
+struct unrolled_node* __linked_list_unrolled_locate(struct linked_list* ll,
+                                                    size_t index,
+                                                    struct unrolled_node** prev,
+                                                    size_t* offset){
+    struct unrolled_node* tail = ll->chunk_tail;
+    if(prev == NULL && index >= ll->size - tail->count){
+        *offset = index - (ll->size - tail->count);
+        return tail;
+    }
+
+    struct unrolled_node* before = NULL;
+    struct unrolled_node* curr = ll->chunk_head;
+    while(index >= curr->count){
+        index -= curr->count;
+        before = curr;
+        curr = curr->next;
+        STATS_WALK(ll, 1);
+    }
+
+    if(prev != NULL)
+        *prev = before;
+    *offset = index;
+    return curr;
+}
+
+// Assuming ll != NULL
+bool __linked_list_unrolled_insert_end(struct linked_list* ll, unsigned int data){
+    struct unrolled_node* tail = ll->chunk_tail;
+    if(tail == NULL || tail->count == LINKED_LIST_UNROLLED_CAPACITY){
+        struct unrolled_node* chunk = __linked_list_get_new_chunk(ll);
+        if(chunk == NULL)
+            return false;
+
+        if(tail == NULL)
+            ll->chunk_head = chunk;
+        else
+            tail->next = chunk;
+        ll->chunk_tail = chunk;
+        tail = chunk;
+    }
+
+    tail->data[tail->count++] = data;
+    ll->size += 1;
+    return true;
+}
+
+// Assuming ll != NULL
+bool __linked_list_unrolled_insert_front(struct linked_list* ll, unsigned int data){
+    struct unrolled_node* head = ll->chunk_head;
+    if(head == NULL || head->count == LINKED_LIST_UNROLLED_CAPACITY){
+        struct unrolled_node* chunk = __linked_list_get_new_chunk(ll);
+        if(chunk == NULL)
+            return false;
+
+        chunk->next = head;
+        ll->chunk_head = chunk;
+        if(ll->chunk_tail == NULL)
+            ll->chunk_tail = chunk;
+        head = chunk;
+    }
+
+    memmove(head->data + 1, head->data, head->count * sizeof(unsigned int));
+    head->data[0] = data;
+    head->count += 1;
+    ll->size += 1;
+    return true;
+}
+
+// Builds a chain of unrolled nodes holding data[0..count), all of them full
+// except the last one.
+// Returns the first unrolled node and sets last, NULL if allocation failed.
+// Assuming ll != NULL and count >= 1
+struct unrolled_node* __linked_list_unrolled_build_chain(struct linked_list* ll,
+                                                         const unsigned int* data,
+                                                         size_t count,
+                                                         struct unrolled_node** last){
+    struct unrolled_node* first = NULL;
+    struct unrolled_node* prev = NULL;
+    for(size_t i = 0; i < count; i += LINKED_LIST_UNROLLED_CAPACITY){
+        struct unrolled_node* chunk = __linked_list_get_new_chunk(ll);
+        if(chunk == NULL){
+            while(first != NULL){
+                struct unrolled_node* next = first->next;
+                __linked_list_save_chunk_in_free_stack(ll, first);
+                first = next;
+            }
+            return NULL;
+        }
+
+        size_t n = count - i < LINKED_LIST_UNROLLED_CAPACITY ? count - i : LINKED_LIST_UNROLLED_CAPACITY;
+        memcpy(chunk->data, data + i, n * sizeof(unsigned int));
+        chunk->count = n;
+        if(prev == NULL)
+            first = chunk;
+        else
+            prev->next = chunk;
+        prev = chunk;
+    }
+    *last = prev;
+    return first;
+}
+
+// Appends data[0..count), topping up the tail unrolled node first.
+// Assuming ll != NULL and count >= 1
+bool __linked_list_unrolled_insert_end_n(struct linked_list* ll,
+                                         const unsigned int* data,
+                                         size_t count){
+    struct unrolled_node* tail = ll->chunk_tail;
+    size_t room = (tail == NULL) ? 0 : LINKED_LIST_UNROLLED_CAPACITY - tail->count;
+    if(room > count)
+        room = count;
+
+    if(room < count){
+        struct unrolled_node* last;
+        struct unrolled_node* first = __linked_list_unrolled_build_chain(ll, data + room, count - room, &last);
+        if(first == NULL)
+            return false;
+
+        if(tail == NULL)
+            ll->chunk_head = first;
+        else
+            tail->next = first;
+        ll->chunk_tail = last;
+    }
+
+    if(room > 0){
+        memcpy(tail->data + tail->count, data, room * sizeof(unsigned int));
+        tail->count += room;
+    }
+    ll->size += count;
+    return true;
+}
+
+// Prepends data[0..count), keeping its order.
+// Assuming ll != NULL and count >= 1
+bool __linked_list_unrolled_insert_front_n(struct linked_list* ll,
+                                           const unsigned int* data,
+                                           size_t count){
+    struct unrolled_node* last;
+    struct unrolled_node* first = __linked_list_unrolled_build_chain(ll, data, count, &last);
+    if(first == NULL)
+        return false;
+
+    last->next = ll->chunk_head;
+    ll->chunk_head = first;
+    if(ll->chunk_tail == NULL)
+        ll->chunk_tail = last;
+    ll->size += count;
+    return true;
+}
+
+// Inserts data at offset inside chunk, first splitting a full chunk in two
+// halves. split receives the new second half, NULL if there was no split;
+// after a split, offsets past UNROLLED_SPLIT_KEEP belong to the second half.
+// Assuming ll != NULL and offset <= chunk->count
+bool __linked_list_unrolled_insert_in(struct linked_list* ll,
+                                      struct unrolled_node* chunk,
+                                      size_t offset,
+                                      unsigned int data,
+                                      struct unrolled_node** split){
+    *split = NULL;
+    if(chunk->count == LINKED_LIST_UNROLLED_CAPACITY){
+        struct unrolled_node* half = __linked_list_get_new_chunk(ll);
+        if(half == NULL)
+            return false;
+
+        half->count = chunk->count - UNROLLED_SPLIT_KEEP;
+        memcpy(half->data, chunk->data + UNROLLED_SPLIT_KEEP, half->count * sizeof(unsigned int));
+        chunk->count = UNROLLED_SPLIT_KEEP;
+
+        half->next = chunk->next;
+        chunk->next = half;
+        if(ll->chunk_tail == chunk)
+            ll->chunk_tail = half;
+        *split = half;
+
+        if(offset > UNROLLED_SPLIT_KEEP){
+            chunk = half;
+            offset -= UNROLLED_SPLIT_KEEP;
+        }
+    }
+
+    memmove(chunk->data + offset + 1, chunk->data + offset,
+            (chunk->count - offset) * sizeof(unsigned int));
+    chunk->data[offset] = data;
+    chunk->count += 1;
+    ll->size += 1;
+    return true;
+}
+
+// Inserts data right after the value at index - 1.
+// Assuming ll != NULL and 0 < index < ll->size
+bool __linked_list_unrolled_insert(struct linked_list* ll, size_t index, unsigned int data){
+    size_t offset;
+    struct unrolled_node* chunk = __linked_list_unrolled_locate(ll, index - 1, NULL, &offset);
+    struct unrolled_node* split;
+    return __linked_list_unrolled_insert_in(ll, chunk, offset + 1, data, &split);
+}
+
+// Removes the value at offset inside chunk, prev being the unrolled node
+// before chunk. An unrolled node that drops below half full absorbs its
+// successor when both fit in one node.
+// Returns TRUE if chunk became empty and went back to chunk_free_stack.
+// Assuming ll != NULL and offset < chunk->count
+bool __linked_list_unrolled_remove_in(struct linked_list* ll,
+                                      struct unrolled_node* prev,
+                                      struct unrolled_node* chunk,
+                                      size_t offset){
+    memmove(chunk->data + offset, chunk->data + offset + 1,
+            (chunk->count - offset - 1) * sizeof(unsigned int));
+    chunk->count -= 1;
+    ll->size -= 1;
+
+    if(chunk->count == 0){
+        if(prev == NULL)
+            ll->chunk_head = chunk->next;
+        else
+            prev->next = chunk->next;
+
+        if(ll->chunk_tail == chunk)
+            ll->chunk_tail = prev;
+
+        __linked_list_save_chunk_in_free_stack(ll, chunk);
+        return true;
+    }
+
+    struct unrolled_node* next = chunk->next;
+    if(chunk->count < LINKED_LIST_UNROLLED_CAPACITY / 2 && next != NULL &&
+       chunk->count + next->count <= LINKED_LIST_UNROLLED_CAPACITY){
+        memcpy(chunk->data + chunk->count, next->data, next->count * sizeof(unsigned int));
+        chunk->count += next->count;
+        chunk->next = next->next;
+        if(ll->chunk_tail == next)
+            ll->chunk_tail = chunk;
+        __linked_list_save_chunk_in_free_stack(ll, next);
+    }
+    return false;
+}
+
+// Removes the value at index.
+// Assuming ll != NULL and index < ll->size
+bool __linked_list_unrolled_remove(struct linked_list* ll, size_t index){
+    struct unrolled_node* prev;
+    size_t offset;
+    struct unrolled_node* chunk = __linked_list_unrolled_locate(ll, index, &prev, &offset);
+    __linked_list_unrolled_remove_in(ll, prev, chunk, offset);
+    return true;
+}
+
+// Compact layout.
+// Every compact_node lives in ll->arena and names its successor by index.
+// The arena doubles when it runs out of room; since no link is a pointer,
+// moving it is a single copy.
+//
+
+// Grows the arena so that it holds at least capacity compact nodes.
+// Assuming ll != NULL
+bool __linked_list_compact_grow(struct linked_list* ll, size_t capacity){
+    struct compact_arena* arena = &ll->arena;
+    if(capacity <= arena->capacity)
+        return true;
+
+    // LINKED_LIST_COMPACT_NIL itself is never a valid index.
+    if(capacity > LINKED_LIST_COMPACT_NIL)
+        return false;
+
+    size_t new_capacity = arena->capacity == 0 ? COMPACT_ARENA_MIN : 2 * (size_t)arena->capacity;
+    while(new_capacity < capacity)
+        new_capacity *= 2;
+    if(new_capacity > LINKED_LIST_COMPACT_NIL)
+        new_capacity = LINKED_LIST_COMPACT_NIL;
+
+    STATS_ADD(ll, allocations, 1);
+    STATS_ADD(ll, allocated_bytes, new_capacity * sizeof(struct compact_node));
+    struct compact_node* nodes = malloc_fptr(new_capacity * sizeof(struct compact_node));
+    if(nodes == NULL)
+        return false;
+    if(arena->used > 0)
+        memcpy(nodes, arena->nodes, arena->used * sizeof(struct compact_node));
+    __linked_list_free_arena_nodes(arena);
+    arena->nodes = nodes;
+    arena->capacity = (uint32_t)new_capacity;
+    return true;
+}
+
+// Hands out a recycled slot if there is one, otherwise the next slot that
+// was never used, growing the arena when it is full.
+// Returns LINKED_LIST_COMPACT_NIL on failure. ll->arena.nodes may move.
+// Assuming ll != NULL
+uint32_t __linked_list_compact_new_slot(struct linked_list* ll){
+    STATS_ADD(ll, node_requests, 1);
+    struct compact_arena* arena = &ll->arena;
+    uint32_t slot = arena->free_stack;
+    if(slot != LINKED_LIST_COMPACT_NIL){
+        arena->free_stack = arena->nodes[slot].next;
+        STATS_ADD(ll, free_stack_hits, 1);
+        return slot;
+    }
+
+    if(arena->used < arena->capacity)
+        STATS_ADD(ll, carve_hits, 1);
+    else if(!__linked_list_compact_grow(ll, (size_t)arena->used + 1))
+        return LINKED_LIST_COMPACT_NIL;
+    return arena->used++;
+}
+
+// Assuming ll != NULL
+void __linked_list_compact_free_slot(struct linked_list* ll, uint32_t slot){
+    ll->arena.nodes[slot].next = ll->arena.free_stack;
+    ll->arena.free_stack = slot;
+}
+
+// Returns the slot of the node at position.
+// Assuming ll != NULL and position < ll->size
+uint32_t __linked_list_compact_slot_at(struct linked_list* ll, size_t position){
+    STATS_WALK(ll, position);
+    const struct compact_node* nodes = ll->arena.nodes;
+    uint32_t slot = ll->compact_head;
+    size_t distance = ll->prefetch_distance;
+    if(distance != 0){
+        for(size_t i = 0; i < position; i++){
+            if(nodes[slot].next == slot + 1)
+                __builtin_prefetch(nodes + slot + distance);
+            slot = nodes[slot].next;
+        }
+        return slot;
+    }
+
+    for(size_t i = 0; i < position; i++){
+        slot = nodes[slot].next;
+    }
+    return slot;
+}
+
+// Links a new node holding data in after prev, or at the head when prev is
+// LINKED_LIST_COMPACT_NIL.
+// Returns the slot of the new node, LINKED_LIST_COMPACT_NIL on failure.
+// Assuming ll != NULL
+uint32_t __linked_list_compact_insert_after(struct linked_list* ll, uint32_t prev, unsigned int data){
+    uint32_t slot = __linked_list_compact_new_slot(ll);
+    if(slot == LINKED_LIST_COMPACT_NIL)
+        return LINKED_LIST_COMPACT_NIL;
+
+    struct compact_node* nodes = ll->arena.nodes;
+    nodes[slot].data = data;
+    if(prev == LINKED_LIST_COMPACT_NIL){
+        nodes[slot].next = ll->compact_head;
+        ll->compact_head = slot;
+    }
+    else {
+        nodes[slot].next = nodes[prev].next;
+        nodes[prev].next = slot;
+    }
+    if(nodes[slot].next == LINKED_LIST_COMPACT_NIL)
+        ll->compact_tail = slot;
+    ll->size += 1;
+    return slot;
+}
+
+// Unlinks the node following prev, or the head when prev is
+// LINKED_LIST_COMPACT_NIL, and recycles its slot.
+// Returns the slot of the node that followed the removed one.
+// Assuming ll != NULL and that node exists
+uint32_t __linked_list_compact_remove_after(struct linked_list* ll, uint32_t prev){
+    struct compact_node* nodes = ll->arena.nodes;
+    uint32_t slot = (prev == LINKED_LIST_COMPACT_NIL) ? ll->compact_head : nodes[prev].next;
+    uint32_t next = nodes[slot].next;
+
+    if(prev == LINKED_LIST_COMPACT_NIL)
+        ll->compact_head = next;
+    else
+        nodes[prev].next = next;
+    if(ll->compact_tail == slot)
+        ll->compact_tail = prev;
+
+    __linked_list_compact_free_slot(ll, slot);
+    ll->size -= 1;
+
+    // Popping from the front reads the new head next.
+    if(ll->prefetch_distance != 0 && next != LINKED_LIST_COMPACT_NIL){
+        __builtin_prefetch(nodes + next);
+        if(next == slot + 1)
+            __builtin_prefetch(nodes + slot + ll->prefetch_distance);
+    }
+    return next;
+}
+
+// Removes the node at index.
+// Assuming ll != NULL and index < ll->size
+bool __linked_list_compact_remove(struct linked_list* ll, size_t index){
+    uint32_t prev = (index == 0) ? LINKED_LIST_COMPACT_NIL : __linked_list_compact_slot_at(ll, index - 1);
+    __linked_list_compact_remove_after(ll, prev);
+    return true;
+}
+
+// Builds a chain of compact nodes holding data[0..count). The arena is grown
+// once up front, as far as recycled slots cannot cover.
+// Returns the first slot and sets last, LINKED_LIST_COMPACT_NIL if the arena
+// could not grow; nothing is taken from the arena in that case.
+// Assuming ll != NULL and count >= 1
+uint32_t __linked_list_compact_build_chain(struct linked_list* ll,
+                                           const unsigned int* data,
+                                           size_t count,
+                                           uint32_t* last){
+    // Every slot below arena.used is either live or recycled.
+    if(!__linked_list_compact_grow(ll, ll->size + count))
+        return LINKED_LIST_COMPACT_NIL;
+
+    struct compact_node* nodes = ll->arena.nodes;
+    uint32_t first = LINKED_LIST_COMPACT_NIL;
+    uint32_t prev = LINKED_LIST_COMPACT_NIL;
+    for(size_t i = 0; i < count; i++){
+        uint32_t slot = __linked_list_compact_new_slot(ll);
+        nodes[slot].data = data[i];
+        if(prev == LINKED_LIST_COMPACT_NIL)
+            first = slot;
+        else
+            nodes[prev].next = slot;
+        prev = slot;
+    }
+    nodes[prev].next = LINKED_LIST_COMPACT_NIL;
+    *last = prev;
+    return first;
+}
+
+// Scans a compact linked_list. Like __linked_list_find_nodes(), runs of
+// consecutive slots are walked without waiting on the next index.
+// Assuming ll != NULL
+static inline __attribute__((always_inline))
+size_t __linked_list_compact_find_at(struct linked_list* ll, unsigned int data, size_t distance){
+    const struct compact_node* nodes = ll->arena.nodes;
+    uint32_t slot = ll->compact_head;
+    size_t size = ll->size;
+    size_t index = 0;
+
+    while(index < size){
+        while(1){
+            if(nodes[slot].data == data)
+                return index;
+            index++;
+            if(index == size || nodes[slot].next != slot + 1)
+                break;
+            slot++;
+            if(distance != 0)
+                __builtin_prefetch(nodes + slot + distance);
+        }
+        slot = nodes[slot].next;
+    }
+    return SIZE_MAX;
+}
+
+size_t __linked_list_compact_find(struct linked_list* ll, unsigned int data){
+    if(ll->prefetch_distance != 0)
+        return __linked_list_compact_find_at(ll, data, ll->prefetch_distance);
+    return __linked_list_compact_find_at(ll, data, 0);
+}
+
+// Inserts an element at the end of the linked_list.
+// \param ll   : Pointer to linked_list.
+// \param data : Data to insert.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_insert_end(struct linked_list * ll,
+                            unsigned int data){
+    if(ll == NULL) 
+        return false;
+
+    __linked_list_note_sequential(ll, 1);
+    STATS_RECORD(ll, insert_walks, 0);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED)
+        return __linked_list_unrolled_insert_end(ll, data);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT)
+        return __linked_list_compact_insert_after(ll, ll->compact_tail, data) != LINKED_LIST_COMPACT_NIL;
+
+    struct node* new_node = __linked_list_get_new_node(ll);
+    
+    if(new_node == NULL)
+        return false;
+
+    new_node->data = data;
+    new_node->next = NULL;
+    __linked_list_set_prev(ll, new_node, ll->tail);
+
+    if(ll->head == NULL){
+        ll->head = new_node;
+        ll->tail = new_node;
+    }
+    else{
+        new_node->next = ll->tail->next;
+        ll->tail->next = new_node;
+        ll->tail = new_node;
+    }
+
+    ll->size += 1;
+
+    if(ll->index != NULL)
+        __skip_index_note_insert(ll, ll->size - 1, new_node);
+    if(ll->hash != NULL)
+        __hash_index_note_insert(ll, ll->size - 1, data);
+    return true;
+}
+
+
+// Inserts an element at the front of the linked_list.
+// \param ll   : Pointer to linked_list.
+// \param data : Data to insert.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_insert_front(struct linked_list * ll,
+                              unsigned int data){
+    if(ll == NULL) 
+        return false;
+
+    __linked_list_note_sequential(ll, 1);
+    STATS_RECORD(ll, insert_walks, 0);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED)
+        return __linked_list_unrolled_insert_front(ll, data);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT)
+        return __linked_list_compact_insert_after(ll, LINKED_LIST_COMPACT_NIL, data) != LINKED_LIST_COMPACT_NIL;
+
+    struct node* new_node = __linked_list_get_new_node(ll);
+
+    if(new_node == NULL)
+        return false;
+
+    new_node->data = data;
+    new_node->next = ll->head;
+    __linked_list_set_prev(ll, new_node, NULL);
+    __linked_list_set_prev(ll, ll->head, new_node);
+    ll->head = new_node;
+    ll->size += 1;
+    if(ll->tail == NULL){
+        ll->tail = new_node;
+    }
+
+    __linked_list_fingers_note_insert(ll, 0);
+    if(ll->index != NULL)
+        __skip_index_note_insert(ll, 0, new_node);
+    if(ll->hash != NULL)
+        __hash_index_note_insert(ll, 0, data);
+    return true;
+}
+
+// Inserts count elements at the end of the linked_list, in order.
+// \param ll    : Pointer to linked_list.
+// \param data  : Data to insert.
+// \param count : Number of elements in data.
+// Returns TRUE on success, FALSE otherwise. Nothing is inserted on failure.
+//
+bool linked_list_insert_end_n(struct linked_list * ll,
+                              const unsigned int * data,
+                              size_t count){
+    if(ll == NULL)
+        return false;
+
+    if(count == 0)
+        return true;
+
+    if(data == NULL)
+        return false;
+
+    __linked_list_note_sequential(ll, count);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED)
+        return __linked_list_unrolled_insert_end_n(ll, data, count);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        uint32_t last;
+        uint32_t first = __linked_list_compact_build_chain(ll, data, count, &last);
+        if(first == LINKED_LIST_COMPACT_NIL)
+            return false;
+
+        if(ll->compact_head == LINKED_LIST_COMPACT_NIL)
+            ll->compact_head = first;
+        else
+            ll->arena.nodes[ll->compact_tail].next = first;
+        ll->compact_tail = last;
+        ll->size += count;
+        return true;
+    }
+
+    struct node* last;
+    struct node* first = __linked_list_build_chain(ll, data, count, &last);
+    if(first == NULL)
+        return false;
+
+    if(ll->head == NULL)
+        ll->head = first;
+    else
+        ll->tail->next = first;
+    __linked_list_link_prev(ll, ll->tail, first, last);
+    ll->tail = last;
+    ll->size += count;
+
+    if(ll->index != NULL)
+        ll->index->stale = true;
+    if(ll->hash != NULL){
+        for(size_t i = 0; i < count; i++){
+            __hash_index_note_insert(ll, ll->size - count + i, data[i]);
+        }
+    }
+    return true;
+}
+
+// Inserts count elements at the front of the linked_list, so that it
+// starts with data[0], data[1], ..., data[count - 1].
+// \param ll    : Pointer to linked_list.
+// \param data  : Data to insert.
+// \param count : Number of elements in data.
+// Returns TRUE on success, FALSE otherwise. Nothing is inserted on failure.
+//
+bool linked_list_insert_front_n(struct linked_list * ll,
+                                const unsigned int * data,
+                                size_t count){
+    if(ll == NULL)
+        return false;
+
+    if(count == 0)
+        return true;
+
+    if(data == NULL)
+        return false;
+
+    __linked_list_note_sequential(ll, count);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED)
+        return __linked_list_unrolled_insert_front_n(ll, data, count);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        uint32_t last;
+        uint32_t first = __linked_list_compact_build_chain(ll, data, count, &last);
+        if(first == LINKED_LIST_COMPACT_NIL)
+            return false;
+
+        ll->arena.nodes[last].next = ll->compact_head;
+        ll->compact_head = first;
+        if(ll->compact_tail == LINKED_LIST_COMPACT_NIL)
+            ll->compact_tail = last;
+        ll->size += count;
+        return true;
+    }
+
+    struct node* last;
+    struct node* first = __linked_list_build_chain(ll, data, count, &last);
+    if(first == NULL)
+        return false;
+
+    last->next = ll->head;
+    __linked_list_link_prev(ll, NULL, first, last);
+    ll->head = first;
+    if(ll->tail == NULL)
+        ll->tail = last;
+    ll->size += count;
+
+    __linked_list_fingers_clear(ll);
+    if(ll->index != NULL)
+        ll->index->stale = true;
+    if(ll->hash != NULL){
+        for(size_t i = count; i-- > 0;){
+            __hash_index_note_insert(ll, 0, data[i]);
+        }
+    }
+    return true;
+}
+
+// Inserts data at index, between two existing nodes.
+// Assuming ll != NULL and 0 < index < ll->size
+bool __linked_list_nodes_insert(struct linked_list* ll, size_t index, unsigned int data){
+    struct node* new_node = __linked_list_get_new_node(ll);
+
+    if(new_node == NULL)
+        return false;
+    
+
+    new_node->data = data;
+    new_node->next = NULL;
+
+    struct node* curr = __linked_list_node_at(ll, index - 1);
+
+    struct node* tmp = curr->next;
+    curr->next = new_node;
+    new_node->next = tmp;
+    __linked_list_set_prev(ll, new_node, curr);
+    __linked_list_set_prev(ll, tmp, new_node);
+    ll->size += 1;
+
+    __linked_list_fingers_note_insert(ll, index);
+    if(ll->index != NULL)
+        __skip_index_note_insert(ll, index, new_node);
+    if(ll->hash != NULL)
+        __hash_index_note_insert(ll, index, data);
+    return true;
+}
+
+// Inserts an element at a specified index in the linked_list.
+// \param ll    : Pointer to linked_list.
+// \param index : Index to insert data at.
+// \param data  : Data to insert.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_insert(struct linked_list * ll,
+                        size_t index,
+                        unsigned int data){
+    if(ll == NULL) 
+        return false;
+
+    if(ll->size < index)
+        return false;
+
+    if(index == 0)
+        return linked_list_insert_front(ll, data);
+    
+    if(index == ll->size)
+        return linked_list_insert_end(ll, data);
+
+    __linked_list_note_positional(ll);
+    STATS_BEGIN_WALK(ll);
+    bool inserted;
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED){
+        inserted = __linked_list_unrolled_insert(ll, index, data);
+    }
+    else if(ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        uint32_t prev = __linked_list_compact_slot_at(ll, index - 1);
+        inserted = __linked_list_compact_insert_after(ll, prev, data) != LINKED_LIST_COMPACT_NIL;
+    }
+    else{
+        inserted = __linked_list_nodes_insert(ll, index, data);
+    }
+    STATS_END_WALK(ll, insert_walks);
+    return inserted;
+}
+
+// Find kernels.
+// Each kernel scans count packed values and returns the position of the
+// first one equal to data, SIZE_MAX if there is none. Only unrolled nodes
+// hold packed values, at most LINKED_LIST_UNROLLED_CAPACITY of them, and
+// consecutive nodes are not adjacent in memory, so no kernel is wider than
+// 8 values. The widest kernel supported by the CPU is picked once when the
+// library is loaded, linked_list_set_find_kernel() can pick another.
+//
+static inline size_t __linked_list_find_packed_scalar(const unsigned int* values,
+                                                      size_t count,
+                                                      unsigned int data){
+    for(size_t i = 0; i < count; i++){
+        if(values[i] == data)
+            return i;
+    }
+    return SIZE_MAX;
+}
+
+#if LINKED_LIST_X86_KERNELS
+__attribute__((target("sse4.2")))
+static inline size_t __linked_list_find_packed_sse42(const unsigned int* values,
+                                                     size_t count,
+                                                     unsigned int data){
+    __m128i key = _mm_set1_epi32((int)data);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+        __m128i v = _mm_loadu_si128((const __m128i*)(values + i));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, key)));
+        if(mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    for(; i < count; i++){
+        if(values[i] == data)
+            return i;
+    }
+    return SIZE_MAX;
+}
+
+__attribute__((target("avx2")))
+static inline size_t __linked_list_find_packed_avx2(const unsigned int* values,
+                                                    size_t count,
+                                                    unsigned int data){
+    __m256i key = _mm256_set1_epi32((int)data);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8){
+        __m256i v = _mm256_loadu_si256((const __m256i*)(values + i));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, key)));
+        if(mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    if(i < count){
+        // Masked out lanes read as zero, so they are dropped from the result.
+        int rest = (int)(count - i);
+        __m256i lanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(rest),
+                                           _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256i v = _mm256_maskload_epi32((const int*)(values + i), lanes);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, key)));
+        mask &= (1 << rest) - 1;
+        if(mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    return SIZE_MAX;
+}
+#endif
+
+// Walks the unrolled nodes starting at chunk, scanning each with kernel.
+//
+#define LINKED_LIST_DEFINE_UNROLLED_FIND(name, kernel, ...)                      \
+    __VA_ARGS__                                                                   \
+    static size_t name(const struct unrolled_node* chunk, unsigned int data){     \
+        size_t index = 0;                                                         \
+        for(; chunk != NULL; chunk = chunk->next){                                \
+            size_t found = kernel(chunk->data, chunk->count, data);               \
+            if(found != SIZE_MAX)                                                 \
+                return index + found;                                             \
+            index += chunk->count;                                                \
+        }                                                                         \
+        return SIZE_MAX;                                                          \
+    }
+
+LINKED_LIST_DEFINE_UNROLLED_FIND(__linked_list_unrolled_find_scalar,
+                                 __linked_list_find_packed_scalar)
+#if LINKED_LIST_X86_KERNELS
+LINKED_LIST_DEFINE_UNROLLED_FIND(__linked_list_unrolled_find_sse42,
+                                 __linked_list_find_packed_sse42,
+                                 __attribute__((target("sse4.2"))))
+LINKED_LIST_DEFINE_UNROLLED_FIND(__linked_list_unrolled_find_avx2,
+                                 __linked_list_find_packed_avx2,
+                                 __attribute__((target("avx2"))))
+#endif
+
+static size_t (*unrolled_find_kernel)(const struct unrolled_node* chunk,
+                                      unsigned int data) = __linked_list_unrolled_find_scalar;
+
+// Sets *find to the unrolled find of kernel.
+// Returns FALSE if the CPU does not support kernel, *find is left as is.
+//
+static bool __linked_list_find_kernel(enum linked_list_find_kernel kernel,
+                                      size_t (**find)(const struct unrolled_node*, unsigned int)){
+#if LINKED_LIST_X86_KERNELS
+    __builtin_cpu_init();
+    if(kernel == LINKED_LIST_FIND_KERNEL_AUTO){
+        if(__builtin_cpu_supports("avx2"))
+            kernel = LINKED_LIST_FIND_KERNEL_AVX2;
+        else if(__builtin_cpu_supports("sse4.2"))
+            kernel = LINKED_LIST_FIND_KERNEL_SSE42;
+    }
+    if(kernel == LINKED_LIST_FIND_KERNEL_AVX2){
+        if(!__builtin_cpu_supports("avx2"))
+            return false;
+        *find = __linked_list_unrolled_find_avx2;
+        return true;
+    }
+    if(kernel == LINKED_LIST_FIND_KERNEL_SSE42){
+        if(!__builtin_cpu_supports("sse4.2"))
+            return false;
+        *find = __linked_list_unrolled_find_sse42;
+        return true;
+    }
+#endif
+    if(kernel != LINKED_LIST_FIND_KERNEL_AUTO && kernel != LINKED_LIST_FIND_KERNEL_SCALAR)
+        return false;
+    *find = __linked_list_unrolled_find_scalar;
+    return true;
+}
+
+__attribute__((constructor))
+static void __linked_list_select_find_kernels(void){
+    __linked_list_find_kernel(LINKED_LIST_FIND_KERNEL_AUTO, &unrolled_find_kernel);
+}
+
+// Sets the kernel linked_list_find() scans unrolled linked_lists with, for
+// every linked_list. Every kernel returns the same index.
+// \param kernel : Kernel to use, see enum linked_list_find_kernel.
+// Returns TRUE on success, FALSE if the CPU does not support kernel, the
+// kernel in use is kept then.
+//
+bool linked_list_set_find_kernel(enum linked_list_find_kernel kernel){
+    return __linked_list_find_kernel(kernel, &unrolled_find_kernel);
+}
+
+// Scans a node-based linked_list. Nodes handed out from the same block are
+// often physically consecutive; inside such a run the next address is known
+// without waiting on curr->next, so the loads no longer form a chain and the
+// CPU can keep many of them in flight.
+// With prefetching on, the node distance steps ahead inside the run is
+// requested as well.
+// Assuming ll != NULL
+static inline __attribute__((always_inline))
+size_t __linked_list_find_nodes_at(struct linked_list* ll, unsigned int data, size_t distance){
+    struct node* curr = ll->head;
+    size_t size = ll->size;
+    size_t index = 0;
+
+    while(index < size){
+        while(1){
+            if(curr->data == data)
+                return index;
+            index++;
+            if(index == size || curr->next != curr + 1)
+                break;
+            curr++;
+            if(distance != 0)
+                __builtin_prefetch(curr + distance);
+        }
+        curr = curr->next;
+    }
+    return SIZE_MAX;
+}
+
+size_t __linked_list_find_nodes(struct linked_list* ll, unsigned int data){
+    if(ll->prefetch_distance != 0)
+        return __linked_list_find_nodes_at(ll, data, ll->prefetch_distance);
+    return __linked_list_find_nodes_at(ll, data, 0);
+}
+
+// Finds the first occurrence of data and returns its index.
+// \param ll   : Pointer to linked_list.
+// \param data : Data to find.
+// Returns index of the first index with that data, SIZE_MAX otherwise.
+//
+size_t linked_list_find(struct linked_list * ll,
+                        unsigned int data){
+    if(ll == NULL)
+        return SIZE_MAX;
+
+    __linked_list_note_sequential(ll, 1);
+
+    if(__hash_index_usable(ll)){
+        STATS_BEGIN_WALK(ll);
+        size_t position = __hash_index_find(ll, data);
+        STATS_END_WALK(ll, find_walks);
+        return position;
+    }
+
+    size_t position;
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED)
+        position = unrolled_find_kernel(ll->chunk_head, data);
+    else if(ll->layout == LINKED_LIST_LAYOUT_COMPACT)
+        position = __linked_list_compact_find(ll, data);
+    else
+        position = __linked_list_find_nodes(ll, data);
+
+    STATS_RECORD(ll, find_walks, position == SIZE_MAX ? ll->size : position + 1);
+    return position;
+}
+
+
+
+// Trimming.
+// A block can be given back once none of its nodes is in use, that is all
+// of them are on a free stack or still uncarved. The free stacks are walked
+// once to count the free nodes of every block, and once more to drop the
+// nodes of the blocks being released. Live nodes never move.
+//
+
+static int __block_registry_entry_compare(const void* a, const void* b){
+    uintptr_t x = (uintptr_t)((const struct block_registry_entry*)a)->base;
+    uintptr_t y = (uintptr_t)((const struct block_registry_entry*)b)->base;
+    return (x > y) - (x < y);
+}
+
+// Returns the entry of the block holding addr.
+// Assuming blocks->entries is sorted by base and some block holds addr
+size_t __block_registry_lookup(struct block_registry* blocks, const void* addr){
+    size_t lo = 0;
+    size_t hi = blocks->count;
+    while(hi - lo > 1){
+        size_t mid = lo + (hi - lo) / 2;
+        if((uintptr_t)blocks->entries[mid].base <= (uintptr_t)addr)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Releases every block of the registry whose nodes are all free.
+// Returns FALSE if scratch memory could not be allocated, nothing is
+// released in that case. node_bytes is the size of the nodes on free_stack
+// and in carve. free_bottom and chunk_free_bottom, when not NULL, are set to
+// the last node left on each free stack.
+// Assuming every other argument != NULL
+bool __block_registry_trim(struct block_registry* blocks,
+                           size_t node_bytes,
+                           struct node** free_stack,
+                           struct node** free_bottom,
+                           struct unrolled_node** chunk_free_stack,
+                           struct unrolled_node** chunk_free_bottom,
+                           struct block_carve* carve,
+                           struct block_carve* chunk_carve){
+    if(blocks->count == 0)
+        return true;
+
+    size_t* free_nodes = malloc_fptr(blocks->count * sizeof(size_t));
+    if(free_nodes == NULL)
+        return false;
+
+    qsort(blocks->entries, blocks->count, sizeof(struct block_registry_entry),
+          __block_registry_entry_compare);
+    memset(free_nodes, 0, blocks->count * sizeof(size_t));
+
+    for(struct node* curr = *free_stack; curr != NULL; curr = curr->next){
+        free_nodes[__block_registry_lookup(blocks, curr)] += 1;
+    }
+    for(struct unrolled_node* curr = *chunk_free_stack; curr != NULL; curr = curr->next){
+        free_nodes[__block_registry_lookup(blocks, curr)] += 1;
+    }
+    if(carve->next != carve->end){
+        free_nodes[__block_registry_lookup(blocks, carve->next)] +=
+            ((char*)carve->end - (char*)carve->next) / node_bytes;
+    }
+    if(chunk_carve->next != chunk_carve->end){
+        free_nodes[__block_registry_lookup(blocks, chunk_carve->next)] +=
+            (struct unrolled_node*)chunk_carve->end - (struct unrolled_node*)chunk_carve->next;
+    }
+    for(struct carve_run* run = carve->spare; run != NULL; run = run->next){
+        free_nodes[__block_registry_lookup(blocks, run)] += ((char*)run->end - (char*)run) / node_bytes;
+    }
+    for(struct carve_run* run = chunk_carve->spare; run != NULL; run = run->next){
+        free_nodes[__block_registry_lookup(blocks, run)] +=
+            (struct unrolled_node*)run->end - (struct unrolled_node*)run;
+    }
+
+    // SIZE_MAX marks the blocks being released.
+    size_t released = 0;
+    for(size_t i = 0; i < blocks->count; i++){
+        if(free_nodes[i] == blocks->entries[i].nodes){
+            free_nodes[i] = SIZE_MAX;
+            released++;
+        }
+    }
+
+    if(released > 0){
+        struct node** link = free_stack;
+        while(*link != NULL){
+            if(free_nodes[__block_registry_lookup(blocks, *link)] == SIZE_MAX)
+                *link = (*link)->next;
+            else{
+                if(free_bottom != NULL)
+                    *free_bottom = *link;
+                link = &(*link)->next;
+            }
+        }
+        struct unrolled_node** chunk_link = chunk_free_stack;
+        while(*chunk_link != NULL){
+            if(free_nodes[__block_registry_lookup(blocks, *chunk_link)] == SIZE_MAX)
+                *chunk_link = (*chunk_link)->next;
+            else{
+                if(chunk_free_bottom != NULL)
+                    *chunk_free_bottom = *chunk_link;
+                chunk_link = &(*chunk_link)->next;
+            }
+        }
+        if(carve->next != carve->end &&
+           free_nodes[__block_registry_lookup(blocks, carve->next)] == SIZE_MAX){
+            carve->next = NULL;
+            carve->end = NULL;
+        }
+        if(chunk_carve->next != chunk_carve->end &&
+           free_nodes[__block_registry_lookup(blocks, chunk_carve->next)] == SIZE_MAX){
+            chunk_carve->next = NULL;
+            chunk_carve->end = NULL;
+        }
+        struct block_carve* carves[] = {carve, chunk_carve};
+        for(size_t c = 0; c < 2; c++){
+            struct carve_run** run_link = (struct carve_run**)&carves[c]->spare;
+            while(*run_link != NULL){
+                if(free_nodes[__block_registry_lookup(blocks, *run_link)] == SIZE_MAX)
+                    *run_link = (*run_link)->next;
+                else
+                    run_link = &(*run_link)->next;
+            }
+        }
+
+        size_t kept = 0;
+        for(size_t i = 0; i < blocks->count; i++){
+            struct block_registry_entry entry = blocks->entries[i];
+            if(free_nodes[i] == SIZE_MAX){
+                blocks->values -= entry.chunks ? entry.nodes * LINKED_LIST_UNROLLED_CAPACITY : entry.nodes;
+                __linked_list_free_block_memory(&entry.memory);
+            }
+            else {
+                blocks->entries[kept++] = entry;
+            }
+        }
+        blocks->count = kept;
+    }
+
+    free_fptr(free_nodes);
+    return true;
+}
+
+// Shrinks the arena of a compact linked_list to the slots handed out so
+// far, or frees it once the linked_list is empty. Slots keep their index.
+// Assuming ll != NULL
+bool __linked_list_compact_trim(struct linked_list* ll){
+    struct compact_arena* arena = &ll->arena;
+    if(ll->size == 0){
+        __linked_list_free_arena_nodes(arena);
+        arena->capacity = 0;
+        arena->used = 0;
+        arena->free_stack = LINKED_LIST_COMPACT_NIL;
+        ll->compact_head = LINKED_LIST_COMPACT_NIL;
+        ll->compact_tail = LINKED_LIST_COMPACT_NIL;
+        return true;
+    }
+
+    if(arena->used == arena->capacity)
+        return true;
+
+    struct compact_node* nodes = malloc_fptr(arena->used * sizeof(struct compact_node));
+    if(nodes == NULL)
+        return false;
+    memcpy(nodes, arena->nodes, arena->used * sizeof(struct compact_node));
+    __linked_list_free_arena_nodes(arena);
+    arena->nodes = nodes;
+    arena->capacity = arena->used;
+    return true;
+}
+
+// Number of values a linked_list with private storage can hold without
+// allocating.
+// Assuming ll != NULL
+size_t __linked_list_capacity(struct linked_list* ll){
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT)
+        return ll->arena.capacity;
+    return ll->blocks.values;
+}
+
+// Assuming pool != NULL
+bool __node_pool_trim(struct node_pool * pool){
+    return __block_registry_trim(&pool->blocks, pool->node_bytes,
+                                 &pool->free_stack, NULL, &pool->chunk_free_stack, NULL,
+                                 &pool->carve, &pool->chunk_carve);
+}
+
+// Gives every block of the node_pool that holds no live node back through
+// free_fptr().
+// \param pool : Pointer to node_pool.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool node_pool_trim(struct node_pool * pool){
+    if(pool == NULL || pool->deleted)
+        return false;
+
+    return __node_pool_trim(pool);
+}
+
+// Gives every block of the linked_list that holds no live element back
+// through free_fptr(). Live elements do not move, so iterators stay valid.
+// A linked_list attached to a node_pool trims the node_pool.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_trim(struct linked_list * ll){
+    if(ll == NULL)
+        return false;
+
+    if(ll->pool != NULL)
+        return __node_pool_trim(ll->pool);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT)
+        return __linked_list_compact_trim(ll);
+
+    return __block_registry_trim(&ll->blocks, __linked_list_node_bytes(ll),
+                                 &ll->free_stack, &ll->free_stack_bottom,
+                                 &ll->chunk_free_stack, &ll->chunk_free_stack_bottom,
+                                 &ll->carve, &ll->chunk_carve);
+}
+
+// Makes removals trim the linked_list once its capacity exceeds both ratio
+// times its size and min_capacity. After a trim, the next one waits until
+// the linked_list has allocated more or shrunk to half its size, so a list
+// whose free blocks cannot be released is not trimmed on every removal.
+// \param ll           : Pointer to linked_list.
+// \param ratio        : Capacity to size ratio that triggers a trim, 0 to
+//                       disable automatic trimming.
+// \param min_capacity : Capacity, in elements, below which nothing is
+//                       trimmed.
+// PRECONDITION: linked_list is not attached to a node_pool.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_trim_policy(struct linked_list * ll,
+                                 size_t ratio,
+                                 size_t min_capacity){
+    if(ll == NULL)
+        return false;
+
+    if(ratio != 0 && ll->pool != NULL)
+        return false;
+
+    ll->trim.ratio = ratio;
+    ll->trim.min_capacity = min_capacity;
+    ll->trim.last_size = 0;
+    ll->trim.last_capacity = 0;
+    return true;
+}
+
+// Sets how the linked_list sizes and allocates its blocks of nodes, for
+// the blocks allocated from now on. Blocks keep the allocator they were
+// allocated with, which must outlive them. The compact layout's arena is
+// resized by copying and always uses malloc_fptr().
+// \param ll     : Pointer to linked_list.
+// \param policy : Policy to follow, NULL for the default one.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_alloc_policy(struct linked_list * ll,
+                                  const struct alloc_policy * policy){
+    if(ll == NULL)
+        return false;
+
+    if(policy == NULL){
+        ll->alloc = default_alloc_policy;
+        return true;
+    }
+
+    if(policy->initial_block == 0 ||
+       (policy->max_block != 0 && policy->max_block < policy->initial_block))
+        return false;
+    if((policy->alignment & (policy->alignment - 1)) != 0)
+        return false;
+    if(policy->allocator != NULL &&
+       (policy->allocator->allocate == NULL || policy->allocator->release == NULL))
+        return false;
+
+    ll->alloc = *policy;
+    return true;
+}
+
+// Copies the alloc policy of the linked_list into policy.
+// \param ll     : Pointer to linked_list.
+// \param policy : Policy to fill in.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_get_alloc_policy(struct linked_list * ll,
+                                  struct alloc_policy * policy){
+    if(ll == NULL || policy == NULL)
+        return false;
+
+    *policy = ll->alloc;
+    return true;
+}
+
+// Fills in the part of stats that describes the linked_list as it is now.
+// Assuming ll != NULL and stats != NULL
+void __linked_list_stats_snapshot(struct linked_list* ll, struct linked_list_stats* stats){
+    const struct block_registry* blocks = __linked_list_blocks(ll);
+    stats->blocks = blocks->count;
+    stats->reserved_bytes = 0;
+    for(size_t i = 0; i < blocks->count; i++){
+        stats->reserved_bytes += blocks->entries[i].memory.bytes;
+    }
+    if(ll->arena.nodes != NULL){
+        stats->blocks += 1;
+        stats->reserved_bytes += ll->arena.capacity * sizeof(struct compact_node);
+    }
+
+    size_t free_nodes = 0;
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED){
+        stats->live_bytes = 0;
+        for(struct unrolled_node* chunk = ll->chunk_head; chunk != NULL; chunk = chunk->next){
+            stats->live_bytes += sizeof(struct unrolled_node);
+        }
+        for(struct unrolled_node* chunk = *__linked_list_chunk_free_stack(ll); chunk != NULL; chunk = chunk->next){
+            free_nodes++;
+        }
+        free_nodes += __block_carve_count(__linked_list_chunk_carve(ll), sizeof(struct unrolled_node));
+    }
+    else if(ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        stats->live_bytes = ll->size * sizeof(struct compact_node);
+        for(uint32_t slot = ll->arena.free_stack; slot != LINKED_LIST_COMPACT_NIL; slot = ll->arena.nodes[slot].next){
+            free_nodes++;
+        }
+        free_nodes += ll->arena.capacity - ll->arena.used;
+    }
+    else{
+        size_t node_bytes = __linked_list_node_bytes(ll);
+        stats->live_bytes = ll->size * node_bytes;
+        for(struct node* node = *__linked_list_free_stack(ll); node != NULL; node = node->next){
+            free_nodes++;
+        }
+        free_nodes += __block_carve_count(__linked_list_carve(ll), node_bytes);
+    }
+    stats->free_nodes = free_nodes;
+}
+
+// Fills in stats for the linked_list, see struct linked_list_stats.
+// \param ll    : Pointer to linked_list.
+// \param stats : Stats to fill in.
+// PRECONDITION: The library was built with LINKED_LIST_STATS defined.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_get_stats(struct linked_list * ll,
+                           struct linked_list_stats * stats){
+#ifdef LINKED_LIST_STATS
+    if(ll == NULL || stats == NULL)
+        return false;
+
+    *stats = ll->stats;
+    __linked_list_stats_snapshot(ll, stats);
+    return true;
+#else
+    (void)ll;
+    (void)stats;
+    return false;
+#endif
+}
+
+// Sets the counters and histograms of the linked_list back to zero.
+// \param ll : Pointer to linked_list.
+// PRECONDITION: The library was built with LINKED_LIST_STATS defined.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_reset_stats(struct linked_list * ll){
+#ifdef LINKED_LIST_STATS
+    if(ll == NULL)
+        return false;
+
+    STATS_CLEAR(ll);
+    return true;
+#else
+    (void)ll;
+    return false;
+#endif
+}
+
+// Huge page allocator, see linked_list_huge_page_allocator.
+// Mappings are rounded up to whole huge pages, so blocks of a whole number
+// of huge pages waste nothing. One more alignment is mapped and the ends
+// are unmapped again, which leaves an aligned mapping.
+//
+static size_t __huge_page_bytes(size_t bytes){
+    return (bytes + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+}
+
+static void * __huge_page_allocate(size_t bytes, size_t alignment, void * context){
+    (void)context;
+    size_t size = __huge_page_bytes(bytes);
+    if(alignment < HUGE_PAGE_SIZE)
+        alignment = HUGE_PAGE_SIZE;
+
+    size_t span = size + alignment;
+    char* raw = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(raw == MAP_FAILED)
+        return NULL;
+
+    char* start = (char*)(((uintptr_t)raw + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if(start != raw)
+        munmap(raw, (size_t)(start - raw));
+    if(raw + span != start + size)
+        munmap(start + size, (size_t)(raw + span - (start + size)));
+#ifdef MADV_HUGEPAGE
+    madvise(start, size, MADV_HUGEPAGE);
+#endif
+    return start;
+}
+
+static void __huge_page_release(void * addr, size_t bytes, void * context){
+    (void)context;
+    munmap(addr, __huge_page_bytes(bytes));
+}
+
+const struct linked_list_allocator linked_list_huge_page_allocator = {
+    __huge_page_allocate, __huge_page_release, NULL
+};
+
+// Applies the automatic trim policy after a removal.
+// Assuming ll != NULL
+void __linked_list_auto_trim(struct linked_list* ll){
+    struct trim_policy* trim = &ll->trim;
+    if(trim->ratio == 0 || ll->pool != NULL)
+        return;
+
+    size_t capacity = __linked_list_capacity(ll);
+    if(capacity < trim->min_capacity || capacity / trim->ratio <= ll->size)
+        return;
+    if(capacity <= trim->last_capacity && ll->size > trim->last_size / 2)
+        return;
+
+    linked_list_trim(ll);
+    trim->last_size = ll->size;
+    trim->last_capacity = __linked_list_capacity(ll);
+}
+
+// Assuming ll != NULL;; consider making this public
+bool __linked_list_remove_top(struct  linked_list * ll){
+    struct node* tmp = ll->head;
+    if(tmp == NULL) return false;
+    
+    ll->head = tmp->next;
+
+    // Popping from the front reads the new head next.
+    if(ll->prefetch_distance != 0 && ll->head != NULL){
+        __builtin_prefetch(ll->head);
+        if(ll->head == tmp + 1)
+            __builtin_prefetch(tmp + ll->prefetch_distance);
+    }
+
+    __linked_list_set_prev(ll, ll->head, NULL);
+
+    // free_fptr(tmp);
+    __linked_list_save_in_free_stack(ll, tmp);
+    ll->size -= 1;
+
+    if(ll->size <= 1){
+        ll->tail = ll->head;
+    }
+
+    __linked_list_fingers_note_remove(ll, 0);
+    if(ll->index != NULL)
+        __skip_index_note_remove(ll, 0, ll->head);
+    if(ll->hash != NULL)
+        __hash_index_note_remove(ll, 0, tmp->data);
+    
+    return true;
+}
+
+// Removes the node at index.
+// Assuming ll != NULL and index < ll->size
+bool __linked_list_nodes_remove(struct linked_list* ll, size_t index){
+    if(index == 0){
+        return __linked_list_remove_top(ll);
+    }
+
+    struct node* curr = __linked_list_node_at(ll, index - 1);
+
+    struct node* node_to_remove = curr->next;
+    
+    // Update tail if needed
+    if(index == ll->size - 1){
+        ll->tail = curr;
+    }
+    
+    curr->next = node_to_remove->next;
+    __linked_list_set_prev(ll, curr->next, curr);
+    // free_fptr(node_to_remove);
+    __linked_list_save_in_free_stack(ll, node_to_remove);
+    
+    ll->size -= 1;
+
+    __linked_list_fingers_note_remove(ll, index);
+    if(ll->index != NULL)
+        __skip_index_note_remove(ll, index, curr->next);
+    if(ll->hash != NULL)
+        __hash_index_note_remove(ll, index, node_to_remove->data);
+    return true;
+}
+
+// Removes a node from the linked_list at a specific index.
+// \param ll    : Pointer to linked_list.
+// \param index : Index to remove node.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_remove(struct linked_list * ll,
+                        size_t index){
+    if(ll == NULL)
+        return false;
+    
+    if(ll->size <= index)
+        return false;
+
+    if(index == 0 || index == ll->size - 1)
+        __linked_list_note_sequential(ll, 1);
+    else
+        __linked_list_note_positional(ll);
+
+    STATS_BEGIN_WALK(ll);
+    bool removed;
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED)
+        removed = __linked_list_unrolled_remove(ll, index);
+    else if(ll->layout == LINKED_LIST_LAYOUT_COMPACT)
+        removed = __linked_list_compact_remove(ll, index);
+    else
+        removed = __linked_list_nodes_remove(ll, index);
+    STATS_END_WALK(ll, remove_walks);
+
+    __linked_list_auto_trim(ll);
+    return removed;
+}
+
+// Removes the last element of the linked_list. O(1) with
+// LINKED_LIST_LAYOUT_DOUBLY, the other layouts walk to the tail.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_remove_end(struct linked_list * ll){
+    if(ll == NULL || ll->size == 0)
+        return false;
+
+    return linked_list_remove(ll, ll->size - 1);
+}
+
+// Removes node from the linked_list in O(1), without knowing its index.
+// \param ll   : Pointer to linked_list.
+// \param node : Node of ll to remove, such as the current_node of an
+//               iterator.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_DOUBLY. Iterators on
+//               node are invalidated.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_remove_node(struct linked_list * ll,
+                             struct node * node){
+    if(ll == NULL || node == NULL)
+        return false;
+
+    if(ll->layout != LINKED_LIST_LAYOUT_DOUBLY || ll->size == 0)
+        return false;
+
+    struct node* prev = __linked_list_prev(node);
+    struct node* next = node->next;
+    if(prev == NULL)
+        ll->head = next;
+    else
+        prev->next = next;
+    if(next == NULL)
+        ll->tail = prev;
+    else
+        __linked_list_set_prev(ll, next, prev);
+
+    __linked_list_save_in_free_stack(ll, node);
+    ll->size -= 1;
+
+    __linked_list_fingers_clear(ll);
+    if(ll->hash != NULL)
+        __hash_index_note_remove(ll, HASH_INDEX_UNKNOWN, node->data);
+
+    __linked_list_auto_trim(ll);
+    return true;
+}
+
+// Creates an iterator struct at a particular index.
+// \param linked_list : Pointer to linked_list.
+// \param index       : Index of the linked list to start at.
+// Returns pointer to an iterator on success, NULL otherwise.
+//
+struct iterator * linked_list_create_iterator(struct linked_list * ll,
+                                              size_t index){
+    if(ll == NULL)
+        return NULL;
+    
+    if(index >= ll->size)
+        return NULL;
+
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED){
+        struct unrolled_node* prev;
+        size_t offset;
+        struct unrolled_node* chunk = __linked_list_unrolled_locate(ll, index, &prev, &offset);
+
+        struct iterator* iter = malloc_fptr(sizeof(struct iterator));
+        if(iter == NULL)
+            return NULL;
+
+        iter->ll = ll;
+        iter->current_node = NULL;
+        iter->current_index = index;
+        iter->data = chunk->data[offset];
+        iter->current_chunk = chunk;
+        iter->current_offset = offset;
+        iter->previous_node = NULL;
+        iter->previous_chunk = prev;
+        iter->current_slot = LINKED_LIST_COMPACT_NIL;
+        iter->previous_slot = LINKED_LIST_COMPACT_NIL;
+        iter->adaptive = __linked_list_open_iterator(ll);
+        return iter;
+    }
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        uint32_t prev = LINKED_LIST_COMPACT_NIL;
+        uint32_t curr = ll->compact_head;
+        if(index > 0){
+            prev = __linked_list_compact_slot_at(ll, index - 1);
+            curr = ll->arena.nodes[prev].next;
+        }
+
+        struct iterator* iter = malloc_fptr(sizeof(struct iterator));
+        if(iter == NULL)
+            return NULL;
+
+        iter->ll = ll;
+        iter->current_node = NULL;
+        iter->current_index = index;
+        iter->data = ll->arena.nodes[curr].data;
+        iter->current_chunk = NULL;
+        iter->current_offset = 0;
+        iter->previous_node = NULL;
+        iter->previous_chunk = NULL;
+        iter->current_slot = curr;
+        iter->previous_slot = prev;
+        iter->adaptive = __linked_list_open_iterator(ll);
+        return iter;
+    }
+
+    struct node* prev = NULL;
+    struct node* curr = ll->head;
+    if(index > 0){
+        prev = __linked_list_node_at(ll, index - 1);
+        curr = prev->next;
+    }
+
+    struct iterator* iter = malloc_fptr(sizeof(struct iterator));
+    if(iter == NULL)
+        return NULL;
+
+    iter->ll = ll;
+    iter->current_node = curr;
+    iter->current_index = index;
+    iter->data = curr->data;
+    iter->current_chunk = NULL;
+    iter->current_offset = 0;
+    iter->previous_node = prev;
+    iter->previous_chunk = NULL;
+    iter->current_slot = LINKED_LIST_COMPACT_NIL;
+    iter->previous_slot = LINKED_LIST_COMPACT_NIL;
+    iter->adaptive = __linked_list_open_iterator(ll);
+
+    return iter;
+}
+
+// Same as linked_list_create_iterator(ll, 0), for an iterator deleted
+// before the caller returns. It does not keep ll from becoming adaptive.
+// Assuming ll != NULL and ll->size > 0
+struct iterator* __linked_list_own_iterator(struct linked_list* ll){
+    bool untracked = ll->adaptive.untracked;
+    struct iterator* iter = linked_list_create_iterator(ll, 0);
+    ll->adaptive.untracked = untracked;
+    return iter;
+}
+
+// Deletes an iterator struct.
+// \param iterator : Iterator to delete.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_delete_iterator(struct iterator * iter){
+    if(iter == NULL)
+        return false;
+
+    if(iter->adaptive){
+        struct linked_list* ll = iter->ll;
+        ll->adaptive.iterators -= 1;
+        __linked_list_note_sequential(ll, iter->current_index);
+    }
+    free_fptr(iter);
+
+    return true;
+}
+
+// Iterates to the next node in the linked_list.
+// \param iterator: Iterator to iterate on.
+// Returns TRUE when next node is present, FALSE once end of list is reached.
+//
+bool linked_list_iterate(struct iterator * iter){
+    if(iter == NULL)
+        return false;
+
+    if(iter->current_index + 1 >= iter->ll->size){
+        return false;
+    }
+
+    if(iter->current_chunk != NULL){
+        struct unrolled_node* chunk = iter->current_chunk;
+        iter->current_offset += 1;
+        if(iter->current_offset == chunk->count){
+            iter->previous_chunk = chunk;
+            chunk = chunk->next;
+            iter->current_chunk = chunk;
+            iter->current_offset = 0;
+            if(iter->ll->prefetch_distance != 0 && chunk->next != NULL)
+                __builtin_prefetch(chunk->next);
+        }
+        iter->current_index++;
+        iter->data = chunk->data[iter->current_offset];
+        return true;
+    }
+
+    if(iter->ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        const struct compact_node* nodes = iter->ll->arena.nodes;
+        iter->previous_slot = iter->current_slot;
+        iter->current_slot = nodes[iter->current_slot].next;
+        iter->current_index++;
+        iter->data = nodes[iter->current_slot].data;
+        if(iter->ll->prefetch_distance != 0)
+            __linked_list_prefetch_after_slot(nodes, iter->current_slot, iter->ll->prefetch_distance);
+        return true;
+    }
+
+    iter->previous_node = iter->current_node;
+    iter->current_node = iter->current_node->next;
+    iter->current_index++;
+    iter->data = iter->current_node->data;
+    if(iter->ll->prefetch_distance != 0 && iter->current_node->next != NULL)
+        __linked_list_prefetch_after(iter->current_node, iter->ll->prefetch_distance);
+
+    return true;
+}
+
+// Moves an iterator back to the previous node in the linked_list. An
+// iterator past the end moves to the last element.
+// \param iterator: Iterator to iterate on.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_DOUBLY.
+// Returns TRUE when previous node is present, FALSE once start of list is
+// reached.
+//
+bool linked_list_iterate_reverse(struct iterator * iter){
+    if(iter == NULL)
+        return false;
+
+    if(iter->ll->layout != LINKED_LIST_LAYOUT_DOUBLY || iter->current_index == 0)
+        return false;
+
+    struct node* curr = iter->previous_node;
+    iter->current_node = curr;
+    iter->previous_node = __linked_list_prev(curr);
+    iter->current_index--;
+    iter->data = curr->data;
+    return true;
+}
+
+// Copies up to n consecutive values, starting with the iterator's current
+// element, into buf and moves the iterator to the element after the last
+// one copied. Once the last element has been copied the iterator points
+// past the end.
+// \param iter : Iterator to read from.
+// \param buf  : Caller owned array with room for n values.
+// \param n    : Maximum number of values to copy.
+// Returns the number of values copied, 0 past the end or on error.
+//
+size_t linked_list_iterate_batch(struct iterator * iter,
+                                 unsigned int * buf,
+                                 size_t n){
+    if(iter == NULL || buf == NULL)
+        return 0;
+
+    struct linked_list* ll = iter->ll;
+    if(iter->current_index >= ll->size)
+        return 0;
+
+    size_t left = ll->size - iter->current_index;
+    if(n > left)
+        n = left;
+    if(n == 0)
+        return 0;
+
+    if(iter->current_chunk != NULL){
+        struct unrolled_node* prev = iter->previous_chunk;
+        struct unrolled_node* chunk = iter->current_chunk;
+        size_t offset = iter->current_offset;
+        size_t copied = 0;
+        while(copied < n){
+            size_t run = chunk->count - offset;
+            if(run > n - copied)
+                run = n - copied;
+            memcpy(buf + copied, chunk->data + offset, run * sizeof(unsigned int));
+            copied += run;
+            offset += run;
+            if(offset == chunk->count){
+                prev = chunk;
+                chunk = chunk->next;
+                offset = 0;
+            }
+        }
+
+        iter->previous_chunk = prev;
+        iter->current_chunk = chunk;
+        iter->current_offset = offset;
+        iter->current_index += n;
+        if(chunk != NULL)
+            iter->data = chunk->data[offset];
+        return n;
+    }
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        const struct compact_node* nodes = ll->arena.nodes;
+        uint32_t prev = iter->previous_slot;
+        uint32_t curr = iter->current_slot;
+        for(size_t i = 0; i < n; i++){
+            buf[i] = nodes[curr].data;
+            prev = curr;
+            curr = nodes[curr].next;
+        }
+
+        iter->previous_slot = prev;
+        iter->current_slot = curr;
+        iter->current_index += n;
+        if(curr != LINKED_LIST_COMPACT_NIL)
+            iter->data = nodes[curr].data;
+        return n;
+    }
+
+    struct node* prev = iter->previous_node;
+    struct node* curr = iter->current_node;
+    for(size_t i = 0; i < n; i++){
+        buf[i] = curr->data;
+        prev = curr;
+        curr = curr->next;
+    }
+
+    iter->previous_node = prev;
+    iter->current_node = curr;
+    iter->current_index += n;
+    if(curr != NULL)
+        iter->data = curr->data;
+    return n;
+}
+
+// Inserts data at offset inside the iterator's current unrolled node and
+// moves the iterator so that it keeps referring to the same value.
+// Assuming iter != NULL and iter->current_chunk != NULL
+bool __linked_list_unrolled_insert_at_iterator(struct iterator* iter,
+                                               size_t offset,
+                                               unsigned int data){
+    struct unrolled_node* chunk = iter->current_chunk;
+    size_t current = iter->current_offset;
+    struct unrolled_node* split;
+    if(!__linked_list_unrolled_insert_in(iter->ll, chunk, offset, data, &split))
+        return false;
+
+    struct unrolled_node* target = chunk;
+    if(split != NULL && offset > UNROLLED_SPLIT_KEEP){
+        target = split;
+        offset -= UNROLLED_SPLIT_KEEP;
+    }
+    if(split != NULL && current >= UNROLLED_SPLIT_KEEP){
+        iter->previous_chunk = chunk;
+        iter->current_chunk = split;
+        current -= UNROLLED_SPLIT_KEEP;
+    }
+    if(target == iter->current_chunk && offset <= current)
+        current += 1;
+    iter->current_offset = current;
+    return true;
+}
+
+// Inserts an element right after the iterator's current element.
+// The iterator stays on its current element.
+// \param iter : Iterator to insert after.
+// \param data : Data to insert.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_insert_after_iterator(struct iterator * iter,
+                                       unsigned int data){
+    if(iter == NULL)
+        return false;
+
+    struct linked_list* ll = iter->ll;
+    if(iter->current_index >= ll->size)
+        return false;
+
+    __linked_list_note_positional(ll);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED)
+        return __linked_list_unrolled_insert_at_iterator(iter, iter->current_offset + 1, data);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT)
+        return __linked_list_compact_insert_after(ll, iter->current_slot, data) != LINKED_LIST_COMPACT_NIL;
+
+    struct node* new_node = __linked_list_get_new_node(ll);
+    if(new_node == NULL)
+        return false;
+
+    struct node* curr = iter->current_node;
+    new_node->data = data;
+    new_node->next = curr->next;
+    curr->next = new_node;
+    __linked_list_set_prev(ll, new_node, curr);
+    __linked_list_set_prev(ll, new_node->next, new_node);
+    if(ll->tail == curr)
+        ll->tail = new_node;
+    ll->size += 1;
+
+    __linked_list_fingers_note_insert(ll, iter->current_index + 1);
+    if(ll->index != NULL)
+        __skip_index_note_insert(ll, iter->current_index + 1, new_node);
+    if(ll->hash != NULL)
+        __hash_index_note_insert(ll, iter->current_index + 1, data);
+    return true;
+}
+
+// Inserts an element right before the iterator's current element, or at
+// the end of the linked_list if the iterator points past the end.
+// The iterator stays on its current element, whose index grows by one.
+// \param iter : Iterator to insert before.
+// \param data : Data to insert.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_insert_before_iterator(struct iterator * iter,
+                                        unsigned int data){
+    if(iter == NULL)
+        return false;
+
+    struct linked_list* ll = iter->ll;
+    if(iter->current_index > ll->size)
+        return false;
+
+    __linked_list_note_positional(ll);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED){
+        if(iter->current_index == ll->size){
+            if(!__linked_list_unrolled_insert_end(ll, data))
+                return false;
+            iter->previous_chunk = ll->chunk_tail;
+        }
+        else if(!__linked_list_unrolled_insert_at_iterator(iter, iter->current_offset, data)){
+            return false;
+        }
+        iter->current_index += 1;
+        return true;
+    }
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        uint32_t slot = __linked_list_compact_insert_after(ll, iter->previous_slot, data);
+        if(slot == LINKED_LIST_COMPACT_NIL)
+            return false;
+        iter->previous_slot = slot;
+        iter->current_index += 1;
+        return true;
+    }
+
+    struct node* new_node = __linked_list_get_new_node(ll);
+    if(new_node == NULL)
+        return false;
+
+    struct node* prev = iter->previous_node;
+    new_node->data = data;
+    new_node->next = iter->current_node;
+    if(prev == NULL)
+        ll->head = new_node;
+    else
+        prev->next = new_node;
+    __linked_list_set_prev(ll, new_node, prev);
+    __linked_list_set_prev(ll, iter->current_node, new_node);
+    if(iter->current_node == NULL)
+        ll->tail = new_node;
+    ll->size += 1;
+
+    iter->previous_node = new_node;
+    iter->current_index += 1;
+
+    __linked_list_fingers_note_insert(ll, iter->current_index - 1);
+    if(ll->index != NULL)
+        __skip_index_note_insert(ll, iter->current_index - 1, new_node);
+    if(ll->hash != NULL)
+        __hash_index_note_insert(ll, iter->current_index - 1, data);
+    return true;
+}
+
+// Removes the iterator's current element. The iterator moves on to the
+// element that followed it, keeping the same index.
+// \param iter : Iterator to remove at.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_remove_at_iterator(struct iterator * iter){
+    if(iter == NULL)
+        return false;
+
+    struct linked_list* ll = iter->ll;
+    if(iter->current_index >= ll->size)
+        return false;
+
+    __linked_list_note_positional(ll);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED){
+        struct unrolled_node* prev = iter->previous_chunk;
+        struct unrolled_node* chunk = iter->current_chunk;
+        size_t offset = iter->current_offset;
+
+        if(__linked_list_unrolled_remove_in(ll, prev, chunk, offset)){
+            chunk = (prev == NULL) ? ll->chunk_head : prev->next;
+            offset = 0;
+        }
+        else if(offset == chunk->count){
+            iter->previous_chunk = chunk;
+            chunk = chunk->next;
+            offset = 0;
+        }
+
+        iter->current_chunk = chunk;
+        iter->current_offset = offset;
+        if(chunk != NULL)
+            iter->data = chunk->data[offset];
+        __linked_list_auto_trim(ll);
+        return true;
+    }
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        uint32_t next = __linked_list_compact_remove_after(ll, iter->previous_slot);
+        iter->current_slot = next;
+        if(next != LINKED_LIST_COMPACT_NIL)
+            iter->data = ll->arena.nodes[next].data;
+        __linked_list_auto_trim(ll);
+        return true;
+    }
+
+    struct node* prev = iter->previous_node;
+    struct node* curr = iter->current_node;
+    struct node* next = curr->next;
+
+    if(prev == NULL)
+        ll->head = next;
+    else
+        prev->next = next;
+    if(ll->tail == curr)
+        ll->tail = prev;
+    __linked_list_set_prev(ll, next, prev);
+
+    __linked_list_save_in_free_stack(ll, curr);
+    ll->size -= 1;
+
+    iter->current_node = next;
+    if(next != NULL)
+        iter->data = next->data;
+
+    __linked_list_fingers_note_remove(ll, iter->current_index);
+    if(ll->index != NULL)
+        __skip_index_note_remove(ll, iter->current_index, next);
+    if(ll->hash != NULL)
+        __hash_index_note_remove(ll, iter->current_index, curr->data);
+    __linked_list_auto_trim(ll);
+    return true;
+}
+
+// Compaction.
+// Elements are copied, in list order, into freshly allocated blocks whose
+// nodes link to their physical successor, see "Block copies", so that a
+// walk over the list turns into a sequential scan. The nodes previously
+// holding them are then dropped. linked_list_clone() builds the same blocks
+// for a new linked_list instead.
+//
+
+// Makes the last fresh blocks registered for ll its whole storage, then
+// drops every other node: private blocks are freed, with a node_pool the
+// old chain is handed back to the pool. The caller links the new blocks in
+// as the list afterwards.
+// Assuming ll != NULL and __linked_list_blocks(ll) holds fresh blocks or
+// more
+void __linked_list_replace_storage(struct linked_list* ll, size_t fresh){
+    if(ll->pool != NULL){
+        __linked_list_release_blocks(ll);
+        return;
+    }
+
+    // Free the older blocks only, then move the fresh ones to the front.
+    struct block_registry* blocks = &ll->blocks;
+    size_t older = blocks->count - fresh;
+    blocks->count = older;
+    __linked_list_release_blocks(ll);
+    memmove(blocks->entries, blocks->entries + older, fresh * sizeof(struct block_registry_entry));
+    blocks->count = fresh;
+    for(size_t i = 0; i < fresh; i++){
+        const struct block_registry_entry* entry = &blocks->entries[i];
+        blocks->values += entry->chunks ? entry->nodes * LINKED_LIST_UNROLLED_CAPACITY : entry->nodes;
+    }
+}
+
+// Copies the size values of the chain starting at first into new blocks
+// of nodes allocated for ll and registered in blocks, see "Block copies".
+// \param last : Set to the last node of the copy.
+// Returns the first node of the copy, NULL on failure, nothing is
+// registered then.
+// Assuming ll != NULL, size > 0 and the chain holds size nodes or more
+struct node* __linked_list_nodes_copy(struct linked_list* ll, struct block_registry* blocks,
+                                      const struct node* first, size_t size, struct node** last){
+    struct block_copy copy;
+    __block_copy_begin(&copy, blocks, size);
+    const struct node* curr = first;
+    for(size_t i = 0; i < size; i++){
+        struct node* node = __block_copy_node(ll, &copy);
+        if(node == NULL)
+            return NULL;
+        node->data = curr->data;
+        curr = curr->next;
+    }
+    *last = copy.last;
+    (*last)->next = NULL;
+    return copy.first;
+}
+
+// Assuming ll != NULL and ll->size > 0
+bool __linked_list_nodes_compact(struct linked_list* ll){
+    struct block_registry* blocks = __linked_list_blocks(ll);
+    size_t before = blocks->count;
+    struct node* last;
+    struct node* first = __linked_list_nodes_copy(ll, blocks, ll->head, ll->size, &last);
+    if(first == NULL)
+        return false;
+
+    __linked_list_replace_storage(ll, blocks->count - before);
+    ll->head = first;
+    ll->tail = last;
+
+    __linked_list_fingers_clear(ll);
+    if(ll->index != NULL)
+        ll->index->stale = true;
+    return true;
+}
+
+// Number of full unrolled nodes, the last one excepted, holding size values.
+//
+static inline size_t __linked_list_unrolled_chunks(size_t size){
+    return (size + LINKED_LIST_UNROLLED_CAPACITY - 1) / LINKED_LIST_UNROLLED_CAPACITY;
+}
+
+// Packs the size values of the unrolled nodes starting at first into
+// __linked_list_unrolled_chunks(size) full unrolled nodes, the last one
+// excepted, in new blocks allocated for ll and registered in blocks, see
+// "Block copies".
+// \param last : Set to the last unrolled node of the copy.
+// Returns the first unrolled node of the copy, NULL on failure, nothing is
+// registered then.
+// Assuming ll != NULL, size > 0 and first starts a chain of size values
+struct unrolled_node* __linked_list_unrolled_copy(struct linked_list* ll, struct block_registry* blocks,
+                                                  const struct unrolled_node* first, size_t size,
+                                                  struct unrolled_node** last){
+    struct block_copy copy;
+    __block_copy_begin(&copy, blocks, __linked_list_unrolled_chunks(size));
+    struct unrolled_node* out = __block_copy_chunk(ll, &copy);
+    if(out == NULL)
+        return NULL;
+
+    size_t filled = 0;
+    for(const struct unrolled_node* curr = first; curr != NULL; curr = curr->next){
+        size_t copied = 0;
+        while(copied < curr->count){
+            if(out->count == LINKED_LIST_UNROLLED_CAPACITY && (out = __block_copy_chunk(ll, &copy)) == NULL)
+                return NULL;
+            size_t run = curr->count - copied;
+            if(run > (size_t)(LINKED_LIST_UNROLLED_CAPACITY - out->count))
+                run = LINKED_LIST_UNROLLED_CAPACITY - out->count;
+            memcpy(out->data + out->count, curr->data + copied, run * sizeof(unsigned int));
+            out->count += run;
+            copied += run;
+            filled += run;
+        }
+    }
+    assert(filled == size && copy.left == 0);
+    out->next = NULL;
+    *last = out;
+    return copy.first;
+}
+
+// Packs the values into full unrolled nodes, the last one excepted.
+// Assuming ll != NULL and ll->size > 0
+bool __linked_list_unrolled_compact(struct linked_list* ll){
+    struct block_registry* blocks = __linked_list_blocks(ll);
+    size_t before = blocks->count;
+    struct unrolled_node* last;
+    struct unrolled_node* first = __linked_list_unrolled_copy(ll, blocks, ll->chunk_head, ll->size, &last);
+    if(first == NULL)
+        return false;
+
+    __linked_list_replace_storage(ll, blocks->count - before);
+    ll->chunk_head = first;
+    ll->chunk_tail = last;
+    return true;
+}
+
+// Arena capacity of a compact linked_list rebuilt with size compact nodes.
+//
+static inline size_t __linked_list_arena_copy_capacity(size_t size){
+    return size < COMPACT_ARENA_MIN ? COMPACT_ARENA_MIN : size;
+}
+
+// Copies the compact nodes of ll into a new arena of
+// __linked_list_arena_copy_capacity(ll->size) nodes, in slots 0 to
+// size - 1 linked in order.
+// Returns the new arena, NULL on failure.
+// Assuming ll != NULL and ll->size > 0
+struct compact_node* __linked_list_arena_copy(const struct linked_list* ll){
+    size_t size = ll->size;
+    struct compact_node* nodes = malloc_fptr(__linked_list_arena_copy_capacity(size) * sizeof(struct compact_node));
+    if(nodes == NULL)
+        return NULL;
+
+    const struct compact_node* old = ll->arena.nodes;
+    uint32_t slot = ll->compact_head;
+    for(size_t i = 0; i < size; i++){
+        nodes[i].data = old[slot].data;
+        nodes[i].next = (uint32_t)(i + 1);
+        slot = old[slot].next;
+    }
+    nodes[size - 1].next = LINKED_LIST_COMPACT_NIL;
+    return nodes;
+}
+
+// Rebuilds the arena with the list in slots 0 to size - 1.
+// Assuming ll != NULL and ll->size > 0
+bool __linked_list_arena_compact(struct linked_list* ll){
+    size_t size = ll->size;
+    size_t capacity = __linked_list_arena_copy_capacity(size);
+    struct compact_node* nodes = __linked_list_arena_copy(ll);
+    if(nodes == NULL)
+        return false;
+
+    __linked_list_free_arena_nodes(&ll->arena);
+    ll->arena.nodes = nodes;
+    ll->arena.capacity = (uint32_t)capacity;
+    ll->arena.used = (uint32_t)size;
+    ll->arena.free_stack = LINKED_LIST_COMPACT_NIL;
+    ll->compact_head = 0;
+    ll->compact_tail = (uint32_t)(size - 1);
+    return true;
+}
+
+// Moves every element of a linked_list into one new block, in list order,
+// or blocks of max_block nodes under the alloc_policy, so that iterating
+// over it reads memory sequentially. The blocks holding
+// the elements before are freed, or handed back to the node_pool.
+// Iterators on the linked_list are invalidated.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise. The linked_list is unchanged
+// on failure.
+//
+bool linked_list_compact(struct linked_list * ll){
+    if(ll == NULL)
+        return false;
+
+    if(ll->size == 0)
+        return linked_list_trim(ll);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED)
+        return __linked_list_unrolled_compact(ll);
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT)
+        return __linked_list_arena_compact(ll);
+
+    return __linked_list_nodes_compact(ll);
+}
+
+// Incremental linked_list_compact(): moves the n elements starting with
+// the iterator's current one, no more than max_block of the alloc_policy,
+// into a new block, in list order, and moves the iterator to the element
+// after them. Calling it repeatedly until it returns 0 compacts the rest
+// of the list a bounded step at a time. The old nodes go back to the free
+// stack, linked_list_trim() can then release their blocks.
+// \param iter : Iterator to compact from.
+// \param n    : Maximum number of elements to move.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_NODES or
+//               LINKED_LIST_LAYOUT_DOUBLY.
+// Returns the number of elements moved, 0 past the end or on error.
+//
+size_t linked_list_compact_at_iterator(struct iterator * iter, size_t n){
+    if(iter == NULL)
+        return 0;
+
+    struct linked_list* ll = iter->ll;
+    if((ll->layout != LINKED_LIST_LAYOUT_NODES && ll->layout != LINKED_LIST_LAYOUT_DOUBLY) ||
+       iter->current_index >= ll->size)
+        return 0;
+
+    size_t left = ll->size - iter->current_index;
+    if(n > left)
+        n = left;
+    if(n == 0)
+        return 0;
+    n = __linked_list_capped_block(ll, n, 1);
+
+    size_t node_bytes = __linked_list_node_bytes(ll);
+    struct block_memory memory;
+    char* block = __linked_list_alloc_block_memory(ll, n * node_bytes, &memory);
+    if(block == NULL)
+        return 0;
+    if(!__linked_list_register_block(__linked_list_blocks(ll), block, n, false, &memory)){
+        __linked_list_free_block_memory(&memory);
+        return 0;
+    }
+
+    struct node* first = (struct node*)block;
+    struct node* last = (struct node*)(block + (n - 1) * node_bytes);
+    struct node* curr = iter->current_node;
+    for(size_t i = 0; i < n; i++){
+        struct node* next = curr->next;
+        struct node* node = (struct node*)(block + i * node_bytes);
+        node->data = curr->data;
+        node->next = (struct node*)(block + (i + 1) * node_bytes);
+        node->is_block_head = (i == 0);
+        __linked_list_save_in_free_stack(ll, curr);
+        curr = next;
+    }
+    last->next = curr;
+
+    if(iter->previous_node == NULL)
+        ll->head = first;
+    else
+        iter->previous_node->next = first;
+    if(curr == NULL)
+        ll->tail = last;
+    __linked_list_link_prev(ll, iter->previous_node, first, last);
+
+    iter->previous_node = last;
+    iter->current_node = curr;
+    iter->current_index += n;
+    if(curr != NULL)
+        iter->data = curr->data;
+
+    __linked_list_fingers_clear(ll);
+    if(ll->index != NULL)
+        ll->index->stale = true;
+    return n;
+}
+
+// Copies the values of ll into new blocks of clone, as linked_list_clone()
+// describes.
+// Returns FALSE if allocation failed, clone is then still empty.
+// Assuming ll != NULL, ll->size > 0 and clone is a new, empty linked_list
+// with the layout of ll
+bool __linked_list_clone_storage(struct linked_list* clone, struct linked_list* ll){
+    size_t size = ll->size;
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED){
+        clone->chunk_head = __linked_list_unrolled_copy(clone, &clone->blocks, ll->chunk_head, size,
+                                                        &clone->chunk_tail);
+        if(clone->chunk_head == NULL)
+            return false;
+    }
+    else if(ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        struct compact_node* nodes = __linked_list_arena_copy(ll);
+        if(nodes == NULL)
+            return false;
+        clone->arena.nodes = nodes;
+        clone->arena.capacity = (uint32_t)__linked_list_arena_copy_capacity(size);
+        clone->arena.used = (uint32_t)size;
+        clone->compact_head = 0;
+        clone->compact_tail = (uint32_t)(size - 1);
+    }
+    else{
+        clone->head = __linked_list_nodes_copy(clone, &clone->blocks, ll->head, size, &clone->tail);
+        if(clone->head == NULL)
+            return false;
+    }
+    clone->size = size;
+    return true;
+}
+
+// Creates a copy of the linked_list, with the same layout and policies. Its
+// values sit in one block allocated for exactly that many, or blocks of
+// max_block nodes under its alloc_policy, linked in physical order, as after linked_list_compact(). The copy has private
+// storage, even when ll is attached to a node_pool, and no index.
+// \param ll : Pointer to linked_list.
+// Returns a new linked_list on success, NULL on failure.
+//
+struct linked_list * linked_list_clone(struct linked_list * ll){
+    if(ll == NULL)
+        return NULL;
+
+    struct linked_list* clone = linked_list_create();
+    if(clone == NULL)
+        return NULL;
+    clone->layout = ll->layout;
+    clone->alloc = ll->alloc;
+    clone->trim.ratio = ll->pool == NULL ? ll->trim.ratio : 0;
+    clone->trim.min_capacity = ll->trim.min_capacity;
+    clone->prefetch_distance = ll->prefetch_distance;
+    clone->adaptive.enabled = ll->adaptive.enabled;
+
+    if(ll->size > 0 && !__linked_list_clone_storage(clone, ll)){
+        linked_list_delete(clone);
+        return NULL;
+    }
+    return clone;
+}
+
+// Sorting.
+// Nodes are relinked, never copied or allocated, so a sort costs no memory
+// beyond a few hundred pointers on the stack. Small lists use a bottom-up
+// merge sort: every node is merged into bins of sorted runs of 1, 2, 4, ...
+// nodes, as in a binary counter, then the bins are merged together. Larger
+// lists use an LSD radix sort, distributing the nodes into one chain per
+// digit value on every pass. Each pass walks the whole, by then scattered,
+// list, so very large lists take wider digits and fewer passes. Passes for
+// digits that are the same in every value are skipped. Both are stable.
+//
+#define LINKED_LIST_SORT_BINS 64
+#define LINKED_LIST_SORT_RADIX_MIN 512
+#define LINKED_LIST_SORT_WIDE_MIN (256 * 1024)
+#define LINKED_LIST_SORT_MAX_BITS 11
+
+// Digit width, in bits, of the radix sort of a list of size values.
+static inline unsigned int __linked_list_radix_bits(size_t size){
+    return size >= LINKED_LIST_SORT_WIDE_MIN ? LINKED_LIST_SORT_MAX_BITS : 8;
+}
+
+// Merges the sorted chains a and b, taking from a first among equal values.
+// Assuming a != NULL and b != NULL
+struct node * __linked_list_merge(struct node* a, struct node* b){
+    struct node* head;
+    struct node** link = &head;
+    while(1){
+        if(a->data <= b->data){
+            *link = a;
+            link = &a->next;
+            a = a->next;
+            if(a == NULL){
+                *link = b;
+                return head;
+            }
+        }
+        else {
+            *link = b;
+            link = &b->next;
+            b = b->next;
+            if(b == NULL){
+                *link = a;
+                return head;
+            }
+        }
+    }
+}
+
+// Assuming head != NULL
+struct node * __linked_list_merge_sort(struct node* head){
+    struct node* bins[LINKED_LIST_SORT_BINS];
+    int used = 0;
+    while(head != NULL){
+        struct node* carry = head;
+        head = head->next;
+        carry->next = NULL;
+
+        int i = 0;
+        for(; i < used && bins[i] != NULL; i++){
+            carry = __linked_list_merge(bins[i], carry);
+            bins[i] = NULL;
+        }
+        if(i == used)
+            used++;
+        bins[i] = carry;
+    }
+
+    // Higher bins hold earlier nodes.
+    struct node* result = NULL;
+    for(int i = 0; i < used; i++){
+        if(bins[i] != NULL)
+            result = (result == NULL) ? bins[i] : __linked_list_merge(bins[i], result);
+    }
+    return result;
+}
+
+// differing has a bit set wherever two values of the chain differ.
+// Assuming head != NULL and bits <= LINKED_LIST_SORT_MAX_BITS
+struct node * __linked_list_radix_sort(struct node* head, unsigned int differing, unsigned int bits){
+    struct node* heads[1 << LINKED_LIST_SORT_MAX_BITS];
+    struct node** tails[1 << LINKED_LIST_SORT_MAX_BITS];
+    unsigned int buckets = 1u << bits;
+    for(unsigned int shift = 0; shift < 32; shift += bits){
+        if(((differing >> shift) & (buckets - 1)) == 0)
+            continue;
+
+        for(unsigned int b = 0; b < buckets; b++){
+            tails[b] = &heads[b];
+        }
+        for(struct node* curr = head; curr != NULL; curr = curr->next){
+            unsigned int b = (curr->data >> shift) & (buckets - 1);
+            *tails[b] = curr;
+            tails[b] = &curr->next;
+        }
+
+        struct node** link = &head;
+        for(unsigned int b = 0; b < buckets; b++){
+            if(tails[b] != &heads[b]){
+                *link = heads[b];
+                link = tails[b];
+            }
+        }
+        *link = NULL;
+    }
+    return head;
+}
+
+// Assuming ll != NULL and ll->size > 1
+bool __linked_list_nodes_sort(struct linked_list* ll){
+    unsigned int all_or = 0;
+    unsigned int all_and = UINT_MAX;
+    bool in_order = true;
+    unsigned int last = ll->head->data;
+    for(struct node* curr = ll->head; curr != NULL; curr = curr->next){
+        all_or |= curr->data;
+        all_and &= curr->data;
+        in_order &= (last <= curr->data);
+        last = curr->data;
+    }
+    if(in_order)
+        return true;
+
+    if(ll->size >= LINKED_LIST_SORT_RADIX_MIN)
+        ll->head = __linked_list_radix_sort(ll->head, all_or ^ all_and,
+                                            __linked_list_radix_bits(ll->size));
+    else
+        ll->head = __linked_list_merge_sort(ll->head);
+
+    struct node* prev = NULL;
+    for(struct node* curr = ll->head; curr != NULL; curr = curr->next){
+        __linked_list_set_prev(ll, curr, prev);
+        prev = curr;
+    }
+    ll->tail = prev;
+
+    __linked_list_fingers_clear(ll);
+    if(ll->index != NULL)
+        ll->index->stale = true;
+    if(ll->hash != NULL)
+        ll->hash->valid_end = ll->hash->base;
+    return true;
+}
+
+// Same as __linked_list_merge(), for a compact linked_list.
+// Assuming a != LINKED_LIST_COMPACT_NIL and b != LINKED_LIST_COMPACT_NIL
+uint32_t __linked_list_compact_merge(struct compact_node* nodes, uint32_t a, uint32_t b){
+    uint32_t head;
+    uint32_t* link = &head;
+    while(1){
+        if(nodes[a].data <= nodes[b].data){
+            *link = a;
+            link = &nodes[a].next;
+            a = nodes[a].next;
+            if(a == LINKED_LIST_COMPACT_NIL){
+                *link = b;
+                return head;
+            }
+        }
+        else {
+            *link = b;
+            link = &nodes[b].next;
+            b = nodes[b].next;
+            if(b == LINKED_LIST_COMPACT_NIL){
+                *link = a;
+                return head;
+            }
+        }
+    }
+}
+
+uint32_t __linked_list_compact_merge_sort(struct compact_node* nodes, uint32_t head){
+    uint32_t bins[LINKED_LIST_SORT_BINS];
+    int used = 0;
+    while(head != LINKED_LIST_COMPACT_NIL){
+        uint32_t carry = head;
+        head = nodes[head].next;
+        nodes[carry].next = LINKED_LIST_COMPACT_NIL;
+
+        int i = 0;
+        for(; i < used && bins[i] != LINKED_LIST_COMPACT_NIL; i++){
+            carry = __linked_list_compact_merge(nodes, bins[i], carry);
+            bins[i] = LINKED_LIST_COMPACT_NIL;
+        }
+        if(i == used)
+            used++;
+        bins[i] = carry;
+    }
+
+    uint32_t result = LINKED_LIST_COMPACT_NIL;
+    for(int i = 0; i < used; i++){
+        if(bins[i] != LINKED_LIST_COMPACT_NIL)
+            result = (result == LINKED_LIST_COMPACT_NIL) ? bins[i] :
+                     __linked_list_compact_merge(nodes, bins[i], result);
+    }
+    return result;
+}
+
+uint32_t __linked_list_compact_radix_sort(struct compact_node* nodes, uint32_t head,
+                                          unsigned int differing, unsigned int bits){
+    uint32_t heads[1 << LINKED_LIST_SORT_MAX_BITS];
+    uint32_t* tails[1 << LINKED_LIST_SORT_MAX_BITS];
+    unsigned int buckets = 1u << bits;
+    for(unsigned int shift = 0; shift < 32; shift += bits){
+        if(((differing >> shift) & (buckets - 1)) == 0)
+            continue;
+
+        for(unsigned int b = 0; b < buckets; b++){
+            tails[b] = &heads[b];
+        }
+        for(uint32_t slot = head; slot != LINKED_LIST_COMPACT_NIL; slot = nodes[slot].next){
+            unsigned int b = (nodes[slot].data >> shift) & (buckets - 1);
+            *tails[b] = slot;
+            tails[b] = &nodes[slot].next;
+        }
+
+        uint32_t* link = &head;
+        for(unsigned int b = 0; b < buckets; b++){
+            if(tails[b] != &heads[b]){
+                *link = heads[b];
+                link = tails[b];
+            }
+        }
+        *link = LINKED_LIST_COMPACT_NIL;
+    }
+    return head;
+}
+
+// Assuming ll != NULL and ll->size > 1
+bool __linked_list_arena_sort(struct linked_list* ll){
+    struct compact_node* nodes = ll->arena.nodes;
+    unsigned int all_or = 0;
+    unsigned int all_and = UINT_MAX;
+    bool in_order = true;
+    unsigned int last = nodes[ll->compact_head].data;
+    for(uint32_t slot = ll->compact_head; slot != LINKED_LIST_COMPACT_NIL; slot = nodes[slot].next){
+        all_or |= nodes[slot].data;
+        all_and &= nodes[slot].data;
+        in_order &= (last <= nodes[slot].data);
+        last = nodes[slot].data;
+    }
+    if(in_order)
+        return true;
+
+    if(ll->size >= LINKED_LIST_SORT_RADIX_MIN)
+        ll->compact_head = __linked_list_compact_radix_sort(nodes, ll->compact_head, all_or ^ all_and,
+                                                            __linked_list_radix_bits(ll->size));
+    else
+        ll->compact_head = __linked_list_compact_merge_sort(nodes, ll->compact_head);
+
+    uint32_t slot = ll->compact_head;
+    while(nodes[slot].next != LINKED_LIST_COMPACT_NIL){
+        slot = nodes[slot].next;
+    }
+    ll->compact_tail = slot;
+    return true;
+}
+
+static int __linked_list_value_compare(const void* a, const void* b){
+    unsigned int x = *(const unsigned int*)a;
+    unsigned int y = *(const unsigned int*)b;
+    return (x > y) - (x < y);
+}
+
+// Unrolled nodes hold values rather than links to relink, so the values
+// are sorted in a scratch array and written back into the same nodes.
+// Assuming ll != NULL and ll->size > 1
+bool __linked_list_unrolled_sort(struct linked_list* ll){
+    unsigned int* values = malloc_fptr(ll->size * sizeof(unsigned int));
+    if(values == NULL)
+        return false;
+
+    size_t copied = 0;
+    for(struct unrolled_node* chunk = ll->chunk_head; chunk != NULL; chunk = chunk->next){
+        memcpy(values + copied, chunk->data, chunk->count * sizeof(unsigned int));
+        copied += chunk->count;
+    }
+    qsort(values, copied, sizeof(unsigned int), __linked_list_value_compare);
+
+    copied = 0;
+    for(struct unrolled_node* chunk = ll->chunk_head; chunk != NULL; chunk = chunk->next){
+        memcpy(chunk->data, values + copied, chunk->count * sizeof(unsigned int));
+        copied += chunk->count;
+    }
+    free_fptr(values);
+    return true;
+}
+
+// Sorts a linked_list in ascending order, stably, by relinking its nodes:
+// no node is allocated or copied. An unrolled linked_list sorts its values
+// through a scratch array instead. Iterators on the linked_list are
+// invalidated.
+// \param ll      : Pointer to linked_list.
+// \param compact : Also lay the sorted nodes out in physical order, as
+//                  linked_list_compact() does.
+// Returns TRUE on success, FALSE otherwise. A linked_list that could not be
+// compacted is still sorted.
+//
+bool linked_list_sort(struct linked_list * ll, bool compact){
+    if(ll == NULL)
+        return false;
+
+    if(ll->size > 1){
+        bool sorted;
+        if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED)
+            sorted = __linked_list_unrolled_sort(ll);
+        else if(ll->layout == LINKED_LIST_LAYOUT_COMPACT)
+            sorted = __linked_list_arena_sort(ll);
+        else
+            sorted = __linked_list_nodes_sort(ll);
+        if(!sorted)
+            return false;
+    }
+
+    if(compact)
+        return linked_list_compact(ll);
+    return true;
+}
+
+// Transfers.
+// Nodes move between linked_lists by relinking them, in O(1), when both
+// linked_lists take their nodes from the same node_pool. A private source
+// linked_list also hands its blocks over to the destination, in O(blocks);
+// its free stacks are joined through their bottom nodes in O(1).
+// Splitting is the exception: the nodes of both halves are interleaved in
+// the same blocks, so a private linked_list cannot give its tail away
+// without sharing those blocks, and copies it instead, in O(tail).
+// Compact nodes are indices into their own linked_list's arena and cannot
+// move.
+//
+
+// Returns whether the nodes of src may move into dst. src's storage must be
+// private or already shared with dst.
+// Assuming dst != NULL and src != NULL
+bool __linked_list_can_transfer(struct linked_list* dst, struct linked_list* src){
+    if(dst == src || dst->layout != src->layout || dst->layout == LINKED_LIST_LAYOUT_COMPACT)
+        return false;
+    return src->pool == NULL || src->pool == dst->pool;
+}
+
+// Moves the blocks of a private src, with its free stacks and carves, into
+// the storage of dst.
+// PRECONDITION: src holds no nodes, and the block registry of dst has room
+//               for every block of src.
+// Assuming dst != NULL and src != NULL
+void __linked_list_adopt_storage(struct linked_list* dst, struct linked_list* src){
+    struct block_registry* blocks = __linked_list_blocks(dst);
+    if(src->blocks.count > 0)
+        memcpy(blocks->entries + blocks->count, src->blocks.entries,
+               src->blocks.count * sizeof(struct block_registry_entry));
+    blocks->count += src->blocks.count;
+    blocks->values += src->blocks.values;
+    src->blocks.count = 0;
+    src->blocks.values = 0;
+
+    if(src->free_stack != NULL){
+        __linked_list_push_free_nodes(dst, src->free_stack, src->free_stack_bottom);
+        src->free_stack = NULL;
+    }
+    if(src->chunk_free_stack != NULL){
+        __linked_list_push_free_chunks(dst, src->chunk_free_stack, src->chunk_free_stack_bottom);
+        src->chunk_free_stack = NULL;
+    }
+
+    // The never used nodes of src become spare runs of dst.
+    __block_carve_adopt(__linked_list_carve(dst), &src->carve);
+    __block_carve_adopt(__linked_list_chunk_carve(dst), &src->chunk_carve);
+}
+
+// Completes a transfer once every node of src is linked into dst: moves
+// the size and, for a private src, the storage.
+// Assuming dst != NULL and src != NULL
+void __linked_list_finish_transfer(struct linked_list* dst, struct linked_list* src){
+    dst->size += src->size;
+    src->size = 0;
+    src->head = NULL;
+    src->tail = NULL;
+    src->chunk_head = NULL;
+    src->chunk_tail = NULL;
+
+    if(src->pool == NULL)
+        __linked_list_adopt_storage(dst, src);
+    __linked_list_fingers_clear(dst);
+    __linked_list_fingers_clear(src);
+    if(dst->index != NULL)
+        dst->index->stale = true;
+    if(src->index != NULL)
+        src->index->stale = true;
+    if(dst->hash != NULL)
+        dst->hash->stale = true;
+    if(src->hash != NULL)
+        __hash_index_clear(src->hash);
+}
+
+// Moves the values of chunk from offset on into a new unrolled node linked
+// right after it.
+// Returns the new unrolled node, NULL if it could not be allocated.
+// Assuming ll != NULL and 0 < offset < chunk->count
+struct unrolled_node* __linked_list_unrolled_split(struct linked_list* ll,
+                                                   struct unrolled_node* chunk,
+                                                   size_t offset){
+    struct unrolled_node* rest = __linked_list_get_new_chunk(ll);
+    if(rest == NULL)
+        return NULL;
+
+    rest->count = chunk->count - offset;
+    memcpy(rest->data, chunk->data + offset, rest->count * sizeof(unsigned int));
+    chunk->count = offset;
+
+    rest->next = chunk->next;
+    chunk->next = rest;
+    if(ll->chunk_tail == chunk)
+        ll->chunk_tail = rest;
+    return rest;
+}
+
+// Moves every element of src to the end of dst, leaving src empty.
+// \param dst : Pointer to linked_list receiving the elements.
+// \param src : Pointer to linked_list giving its elements.
+// PRECONDITION: Both linked_lists have the same layout, other than
+//               LINKED_LIST_LAYOUT_COMPACT. src is private or attached to
+//               the node_pool of dst. O(1) when both share a node_pool,
+//               O(blocks of src) when src is private.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_concat(struct linked_list * dst, struct linked_list * src){
+    if(dst == NULL || src == NULL)
+        return false;
+
+    if(!__linked_list_can_transfer(dst, src))
+        return false;
+    if(src->pool == NULL && !__block_registry_reserve(__linked_list_blocks(dst), src->blocks.count))
+        return false;
+
+    if(dst->layout == LINKED_LIST_LAYOUT_UNROLLED){
+        if(src->chunk_head != NULL){
+            if(dst->chunk_tail == NULL)
+                dst->chunk_head = src->chunk_head;
+            else
+                dst->chunk_tail->next = src->chunk_head;
+            dst->chunk_tail = src->chunk_tail;
+        }
+    }
+    else if(src->head != NULL){
+        if(dst->tail == NULL)
+            dst->head = src->head;
+        else
+            dst->tail->next = src->head;
+        __linked_list_set_prev(dst, src->head, dst->tail);
+        dst->tail = src->tail;
+    }
+
+    __linked_list_finish_transfer(dst, src);
+    return true;
+}
+
+// Moves every element of src into dst, right before the current element of
+// iter, or at the end of dst if iter is past its end. src is left empty.
+// iter stays on its element, whose index grows by the size of src.
+// \param dst  : Pointer to linked_list receiving the elements.
+// \param iter : Iterator on dst.
+// \param src  : Pointer to linked_list giving its elements.
+// PRECONDITION: Same as linked_list_concat().
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_splice(struct linked_list * dst, struct iterator * iter, struct linked_list * src){
+    if(dst == NULL || iter == NULL || src == NULL || iter->ll != dst)
+        return false;
+
+    if(!__linked_list_can_transfer(dst, src))
+        return false;
+
+    size_t count = src->size;
+    if(dst->layout == LINKED_LIST_LAYOUT_UNROLLED){
+        struct unrolled_node* chunk = iter->current_chunk;
+        struct unrolled_node* prev = (chunk == NULL) ? dst->chunk_tail : iter->previous_chunk;
+        // The values before iter stay in their unrolled node, src goes
+        // between it and the rest.
+        if(src->chunk_head != NULL && chunk != NULL && iter->current_offset > 0){
+            struct unrolled_node* rest = __linked_list_unrolled_split(dst, chunk, iter->current_offset);
+            if(rest == NULL)
+                return false;
+            prev = chunk;
+            chunk = rest;
+            iter->previous_chunk = prev;
+            iter->current_chunk = chunk;
+            iter->current_offset = 0;
+        }
+        if(src->pool == NULL && !__block_registry_reserve(__linked_list_blocks(dst), src->blocks.count))
+            return false;
+
+        if(src->chunk_head != NULL){
+            if(prev == NULL)
+                dst->chunk_head = src->chunk_head;
+            else
+                prev->next = src->chunk_head;
+            src->chunk_tail->next = chunk;
+            if(chunk == NULL)
+                dst->chunk_tail = src->chunk_tail;
+            iter->previous_chunk = src->chunk_tail;
+        }
+    }
+    else{
+        if(src->pool == NULL && !__block_registry_reserve(__linked_list_blocks(dst), src->blocks.count))
+            return false;
+
+        if(src->head != NULL){
+            struct node* next = iter->current_node;
+            struct node* prev = (next == NULL) ? dst->tail : iter->previous_node;
+            if(prev == NULL)
+                dst->head = src->head;
+            else
+                prev->next = src->head;
+            src->tail->next = next;
+            if(next == NULL)
+                dst->tail = src->tail;
+            __linked_list_set_prev(dst, src->head, prev);
+            __linked_list_set_prev(dst, next, src->tail);
+            iter->previous_node = src->tail;
+        }
+    }
+
+    __linked_list_finish_transfer(dst, src);
+    iter->current_index += count;
+    return true;
+}
+
+// Moves the unrolled nodes from chunk on, which follows prev, to rest.
+// With a node_pool they are relinked as they are, otherwise rest gets a
+// copy in blocks of its own and the originals go back to the free stack
+// of ll, so that both stay private.
+// Returns FALSE if allocation failed, nothing moved then.
+// Assuming ll != NULL, rest is a new, empty linked_list with the layout and
+// node_pool of ll, and chunk != NULL starts the last count values of ll
+bool __linked_list_split_chunks(struct linked_list* ll, struct linked_list* rest,
+                                struct unrolled_node* prev, struct unrolled_node* chunk, size_t count){
+    if(ll->pool != NULL){
+        rest->chunk_head = chunk;
+        rest->chunk_tail = ll->chunk_tail;
+    }
+    else{
+        rest->chunk_head = __linked_list_unrolled_copy(rest, &rest->blocks, chunk, count, &rest->chunk_tail);
+        if(rest->chunk_head == NULL)
+            return false;
+        __linked_list_push_free_chunks(ll, chunk, ll->chunk_tail);
+    }
+
+    if(prev == NULL)
+        ll->chunk_head = NULL;
+    else
+        prev->next = NULL;
+    ll->chunk_tail = prev;
+    return true;
+}
+
+// Same as __linked_list_split_chunks(), for the nodes from node on.
+// Assuming ll != NULL, rest is a new, empty linked_list with the layout and
+// node_pool of ll, and node != NULL starts the last count values of ll
+bool __linked_list_split_nodes(struct linked_list* ll, struct linked_list* rest,
+                               struct node* prev, struct node* node, size_t count){
+    if(ll->pool != NULL){
+        rest->head = node;
+        rest->tail = ll->tail;
+        __linked_list_set_prev(rest, node, NULL);
+    }
+    else{
+        rest->head = __linked_list_nodes_copy(rest, &rest->blocks, node, count, &rest->tail);
+        if(rest->head == NULL)
+            return false;
+        __linked_list_push_free_nodes(ll, node, ll->tail);
+    }
+
+    if(prev == NULL)
+        ll->head = NULL;
+    else
+        prev->next = NULL;
+    ll->tail = prev;
+    return true;
+}
+
+// Splits a linked_list in two: the current element of iter and every one
+// after it move, in order, to a new linked_list. iter is left past the end
+// of its now shorter linked_list.
+// With a node_pool both halves keep sharing it and the elements are
+// relinked in O(1). A private linked_list stays private: the new one gets
+// its elements copied into blocks of its own, as linked_list_clone()
+// does, and the nodes they leave go back to the free stack. This makes
+// splitting a private linked_list the one O(n) transfer: its blocks hold
+// nodes of both halves, and each block has a single owner. Attach both to
+// a node_pool where splits must be O(1).
+// The new linked_list has the layout and policies of the original one and
+// no index.
+// \param iter : Iterator on the linked_list to split.
+// PRECONDITION: linked_list is not LINKED_LIST_LAYOUT_COMPACT.
+// Returns the new linked_list on success, NULL otherwise.
+//
+struct linked_list * linked_list_split_at(struct iterator * iter){
+    if(iter == NULL || iter->ll == NULL)
+        return NULL;
+
+    struct linked_list* ll = iter->ll;
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT || iter->current_index > ll->size)
+        return NULL;
+
+    struct linked_list* rest = linked_list_create();
+    if(rest == NULL)
+        return NULL;
+    rest->layout = ll->layout;
+    rest->alloc = ll->alloc;
+    rest->trim.ratio = ll->pool == NULL ? ll->trim.ratio : 0;
+    rest->trim.min_capacity = ll->trim.min_capacity;
+    rest->prefetch_distance = ll->prefetch_distance;
+    rest->adaptive.enabled = ll->adaptive.enabled;
+    rest->pool = ll->pool;
+    if(rest->pool != NULL)
+        rest->pool->lists += 1;
+
+    size_t count = ll->size - iter->current_index;
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED){
+        struct unrolled_node* chunk = iter->current_chunk;
+        struct unrolled_node* prev = iter->previous_chunk;
+        if(chunk != NULL && iter->current_offset > 0){
+            struct unrolled_node* split = __linked_list_unrolled_split(ll, chunk, iter->current_offset);
+            if(split == NULL){
+                linked_list_delete(rest);
+                return NULL;
+            }
+            prev = chunk;
+            chunk = split;
+        }
+        if(chunk != NULL && !__linked_list_split_chunks(ll, rest, prev, chunk, count)){
+            linked_list_delete(rest);
+            return NULL;
+        }
+        iter->previous_chunk = ll->chunk_tail;
+        iter->current_chunk = NULL;
+        iter->current_offset = 0;
+    }
+    else{
+        struct node* node = iter->current_node;
+        if(node != NULL && !__linked_list_split_nodes(ll, rest, iter->previous_node, node, count)){
+            linked_list_delete(rest);
+            return NULL;
+        }
+        iter->previous_node = ll->tail;
+        iter->current_node = NULL;
+    }
+
+    rest->size = count;
+    ll->size = iter->current_index;
+    __linked_list_fingers_clear(ll);
+    if(ll->index != NULL)
+        ll->index->stale = true;
+    if(ll->hash != NULL)
+        ll->hash->stale = true;
+    __linked_list_auto_trim(ll);
+    return rest;
+}
+
+// Saving and loading.
+// A saved linked_list is a saved_list_header followed by the arena of a
+// compact linked_list holding its values, in slots 0 to size - 1 linked in
+// order. Loading maps that arena as is: nothing is parsed or allocated per
+// value, and a copy-on-write mapping keeps the file untouched.
+//
+
+#define SAVED_LIST_MAGIC "LLARENA1"
+
+// Values converted per write() by linked_list_save().
+//
+#define SAVE_BATCH 1024
+
+struct saved_list_header {
+    char magic[8];
+    uint64_t size;
+};
+
+_Static_assert(sizeof(struct saved_list_header) % _Alignof(struct compact_node) == 0,
+               "saved compact nodes are expected to be aligned");
+
+// Writes bytes from buffer to fd, however many write() calls that takes.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool __linked_list_write_all(int fd, const void* buffer, size_t bytes){
+    const char* next = buffer;
+    while(bytes > 0){
+        ssize_t written = write(fd, next, bytes);
+        if(written < 0){
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+        next += written;
+        bytes -= (size_t)written;
+    }
+    return true;
+}
+
+// Writes the values of the linked_list to fd, in order, as a header
+// followed by the arena of a compact linked_list holding them.
+// linked_list_load_mmap() maps such a file back without copying it.
+// \param ll : Pointer to linked_list.
+// \param fd : File descriptor open for writing.
+// PRECONDITION: linked_list holds less than LINKED_LIST_COMPACT_NIL values.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_save(struct linked_list * ll, int fd){
+    if(ll == NULL || fd < 0)
+        return false;
+
+    if(ll->size >= LINKED_LIST_COMPACT_NIL)
+        return false;
+
+    struct saved_list_header header;
+    memcpy(header.magic, SAVED_LIST_MAGIC, sizeof(header.magic));
+    header.size = ll->size;
+    if(!__linked_list_write_all(fd, &header, sizeof(header)))
+        return false;
+    if(ll->size == 0)
+        return true;
+
+    struct iterator* iter = __linked_list_own_iterator(ll);
+    if(iter == NULL)
+        return false;
+
+    unsigned int values[SAVE_BATCH];
+    struct compact_node nodes[SAVE_BATCH];
+    size_t saved = 0;
+    size_t count;
+    bool written = true;
+    while(written && (count = linked_list_iterate_batch(iter, values, SAVE_BATCH)) != 0){
+        for(size_t i = 0; i < count; i++){
+            nodes[i].data = values[i];
+            nodes[i].next = (uint32_t)(saved + i + 1);
+        }
+        saved += count;
+        if(saved == ll->size)
+            nodes[count - 1].next = LINKED_LIST_COMPACT_NIL;
+        written = __linked_list_write_all(fd, nodes, count * sizeof(struct compact_node));
+    }
+    linked_list_delete_iterator(iter);
+    return written && saved == ll->size;
+}
+
+// Creates a compact linked_list over a private mapping of a file written
+// by linked_list_save(). Nothing is read until the linked_list is used, and
+// pages are copied on their first write, so the file is never modified.
+// The mapping is released once the arena grows, is trimmed, compacted or
+// the linked_list deleted.
+// \param path : Path of the file.
+// PRECONDITION: The file was written by linked_list_save() on a machine of
+//               the same byte order and is not truncated while mapped.
+// Returns a new linked_list on success, NULL on failure.
+//
+struct linked_list * linked_list_load_mmap(const char * path){
+    if(path == NULL)
+        return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return NULL;
+
+    struct saved_list_header header;
+    struct stat file;
+    if(fstat(fd, &file) != 0 || file.st_size < (off_t)sizeof(header) ||
+       pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+       memcmp(header.magic, SAVED_LIST_MAGIC, sizeof(header.magic)) != 0 ||
+       header.size >= LINKED_LIST_COMPACT_NIL ||
+       (uint64_t)file.st_size != sizeof(header) + header.size * sizeof(struct compact_node)){
+        close(fd);
+        return NULL;
+    }
+
+    struct linked_list* ll = linked_list_create();
+    if(ll == NULL){
+        close(fd);
+        return NULL;
+    }
+    ll->layout = LINKED_LIST_LAYOUT_COMPACT;
+    if(header.size == 0){
+        close(fd);
+        return ll;
+    }
+
+    void* mapping = mmap(NULL, (size_t)file.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED){
+        linked_list_delete(ll);
+        return NULL;
+    }
+
+    ll->arena.mapping = mapping;
+    ll->arena.mapping_bytes = (size_t)file.st_size;
+    ll->arena.nodes = (struct compact_node*)((char*)mapping + sizeof(header));
+    ll->arena.capacity = (uint32_t)header.size;
+    ll->arena.used = (uint32_t)header.size;
+    ll->compact_head = 0;
+    ll->compact_tail = (uint32_t)(header.size - 1);
+    ll->size = (size_t)header.size;
+    return ll;
+}
+
+// Parallel scans.
+// linked_list_find_parallel(), linked_list_count() and linked_list_reduce()
+// cut the linked_list into pieces that up to scan_threads threads, the
+// calling one included, take in turns. Pieces come from, in order of
+// preference:
+// 1. Storage: with no node cached on a free stack, every node of a private
+//    block is live but the uncarved rest of the newest block, the same
+//    invariant trimming relies on. Blocks (or the compact arena) are then
+//    read as arrays, in memory rather than list order.
+// 2. The positional index, whose segments give evenly spaced split points
+//    in O(log n) each.
+// Anything else is walked by the calling thread alone. No other split
+// points are kept: insertions and removals would move them, and keeping
+// them placed is the work the positional index already does. A find needs
+// list positions, so storage can only rule a value out, unless the compact
+// arena turns out to be in list order.
+//
+
+#define SCAN_MAX_THREADS 256
+
+// Elements below which starting one more thread does not pay off.
+//
+#define SCAN_MIN_PER_THREAD (1 << 14)
+
+// Elements a find scans between checks of whether it can stop early.
+//
+#define SCAN_CHECK_INTERVAL 1024
+
+// Threads a scan may use, 0 for one per online CPU.
+//
+static size_t scan_threads = 0;
+
+enum scan_op { SCAN_FIND, SCAN_COUNT, SCAN_REDUCE };
+
+// A part of a linked_list scanned by one thread.
+// 1. SCAN_CHAIN  -> length nodes linked from first, the first of them at
+//                   list position start
+// 2. SCAN_NODES  -> length live nodes stored from first on, back to back
+// 3. SCAN_CHUNKS -> length live unrolled nodes stored from first on
+// 4. SCAN_SLOTS  -> the compact nodes in slots start to start + length - 1,
+//                   first pointing at the one in slot start
+//
+enum scan_piece_kind { SCAN_CHAIN, SCAN_NODES, SCAN_CHUNKS, SCAN_SLOTS };
+
+struct scan_piece {
+    enum scan_piece_kind kind;
+    const void * first;
+    size_t start;
+    size_t length;
+};
+
+// What the threads of one scan share. kind is that of every piece. found
+// is the smallest position (SCAN_CHAIN) or slot (SCAN_SLOTS) holding data
+// found so far, or 0 once a piece in memory order holds it, SIZE_MAX until
+// then.
+//
+struct scan {
+    enum scan_op op;
+    enum scan_piece_kind kind;
+    unsigned int data;
+    size_t node_bytes;
+    size_t last_slot;
+    const struct scan_piece * pieces;
+    size_t piece_count;
+    size_t threads;
+    _Atomic size_t found;
+};
+
+// What one thread saw. in_order is cleared by a compact node that does not
+// link to the slot after its own.
+//
+struct scan_result {
+    size_t count;
+    uint64_t sum;
+    unsigned int min;
+    unsigned int max;
+    bool in_order;
+};
+
+struct scan_worker {
+    struct scan * scan;
+    size_t index;
+    struct scan_result result;
+};
+
+// Accounts for value in result. Returns whether a find matched it.
+//
+static inline bool __scan_visit(const struct scan* scan, struct scan_result* result, unsigned int value){
+    if(scan->op == SCAN_FIND)
+        return value == scan->data;
+    if(scan->op == SCAN_COUNT){
+        result->count += (value == scan->data);
+        return false;
+    }
+    result->sum += value;
+    if(value < result->min)
+        result->min = value;
+    if(value > result->max)
+        result->max = value;
+    return false;
+}
+
+// Returns whether a find no longer needs to scan piece: any match will do
+// in memory order, in list order only an earlier one.
+//
+static inline bool __scan_should_stop(struct scan* scan, const struct scan_piece* piece){
+    size_t found = atomic_load_explicit(&scan->found, memory_order_relaxed);
+    if(piece->kind == SCAN_NODES || piece->kind == SCAN_CHUNKS)
+        return found != SIZE_MAX;
+    return found < piece->start;
+}
+
+// Lowers scan->found to position.
+//
+static void __scan_found(struct scan* scan, size_t position){
+    size_t seen = atomic_load_explicit(&scan->found, memory_order_relaxed);
+    while(position < seen &&
+          !atomic_compare_exchange_weak_explicit(&scan->found, &seen, position,
+                                                 memory_order_relaxed, memory_order_relaxed)){
+    }
+}
+
+// Scans piece into result.
+// Returns the offset of the element a find matched, piece->length if there
+// is none or the find stopped early.
+//
+size_t __linked_list_scan_piece(struct scan* scan, const struct scan_piece* piece, struct scan_result* result){
+    bool find = scan->op == SCAN_FIND;
+    if(piece->kind == SCAN_CHAIN){
+        const struct node* node = piece->first;
+        for(size_t i = 0; i < piece->length; i++, node = node->next){
+            if(__scan_visit(scan, result, node->data))
+                return i;
+            if(find && i % SCAN_CHECK_INTERVAL == 0 && __scan_should_stop(scan, piece))
+                break;
+        }
+    }
+    else if(piece->kind == SCAN_NODES){
+        const char* nodes = piece->first;
+        for(size_t i = 0; i < piece->length; i++){
+            if(__scan_visit(scan, result, ((const struct node*)(nodes + i * scan->node_bytes))->data))
+                return i;
+            if(find && i % SCAN_CHECK_INTERVAL == 0 && __scan_should_stop(scan, piece))
+                break;
+        }
+    }
+    else if(piece->kind == SCAN_CHUNKS){
+        const struct unrolled_node* chunks = piece->first;
+        for(size_t i = 0; i < piece->length; i++){
+            for(uint16_t j = 0; j < chunks[i].count; j++){
+                if(__scan_visit(scan, result, chunks[i].data[j]))
+                    return i;
+            }
+            if(find && i % (SCAN_CHECK_INTERVAL / LINKED_LIST_UNROLLED_CAPACITY) == 0 &&
+               __scan_should_stop(scan, piece))
+                break;
+        }
+    }
+    else{
+        const struct compact_node* slots = piece->first;
+        for(size_t i = 0; i < piece->length; i++){
+            size_t slot = piece->start + i;
+            uint32_t next = slot == scan->last_slot ? LINKED_LIST_COMPACT_NIL : (uint32_t)(slot + 1);
+            if(slots[i].next != next)
+                result->in_order = false;
+            if(__scan_visit(scan, result, slots[i].data))
+                return i;
+            if(find && i % SCAN_CHECK_INTERVAL == 0 && __scan_should_stop(scan, piece))
+                break;
+        }
+    }
+    return piece->length;
+}
+
+// Scans every piece whose index is worker->index modulo the thread count.
+//
+static void * __linked_list_scan_worker(void* arg){
+    struct scan_worker* worker = arg;
+    struct scan* scan = worker->scan;
+    for(size_t p = worker->index; p < scan->piece_count; p += scan->threads){
+        const struct scan_piece* piece = &scan->pieces[p];
+        if(scan->op == SCAN_FIND && __scan_should_stop(scan, piece))
+            continue;
+
+        size_t offset = __linked_list_scan_piece(scan, piece, &worker->result);
+        if(offset < piece->length){
+            bool listed = piece->kind == SCAN_CHAIN || piece->kind == SCAN_SLOTS;
+            __scan_found(scan, listed ? piece->start + offset : 0);
+        }
+    }
+    return NULL;
+}
+
+// Runs scan on scan->threads threads, the calling one being the first, and
+// combines what they saw into result. Pieces of a thread that could not be
+// started are scanned by the calling thread.
+//
+void __linked_list_run_scan(struct scan* scan, struct scan_result* result){
+    struct scan_worker workers[SCAN_MAX_THREADS];
+    pthread_t threads[SCAN_MAX_THREADS];
+    bool started[SCAN_MAX_THREADS];
+    for(size_t t = 0; t < scan->threads; t++){
+        workers[t].scan = scan;
+        workers[t].index = t;
+        workers[t].result = (struct scan_result){0, 0, UINT_MAX, 0, true};
+    }
+    for(size_t t = 1; t < scan->threads; t++){
+        started[t] = pthread_create(&threads[t], NULL, __linked_list_scan_worker, &workers[t]) == 0;
+    }
+    __linked_list_scan_worker(&workers[0]);
+
+    *result = workers[0].result;
+    for(size_t t = 1; t < scan->threads; t++){
+        if(started[t])
+            pthread_join(threads[t], NULL);
+        else
+            __linked_list_scan_worker(&workers[t]);
+
+        result->count += workers[t].result.count;
+        result->sum += workers[t].result.sum;
+        if(workers[t].result.min < result->min)
+            result->min = workers[t].result.min;
+        if(workers[t].result.max > result->max)
+            result->max = workers[t].result.max;
+        result->in_order &= workers[t].result.in_order;
+    }
+}
+
+// Returns how many threads should scan size elements.
+//
+size_t __linked_list_scan_thread_count(size_t size){
+    size_t threads = scan_threads;
+    if(threads == 0){
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    if(threads > SCAN_MAX_THREADS)
+        threads = SCAN_MAX_THREADS;
+    if(threads > size / SCAN_MIN_PER_THREAD)
+        threads = size / SCAN_MIN_PER_THREAD;
+    return threads == 0 ? 1 : threads;
+}
+
+// Appends the pieces of length elements from first on, at most per_piece
+// long, to pieces.
+//
+static size_t __scan_cut(struct scan_piece* pieces, enum scan_piece_kind kind, const char* first,
+                         size_t start, size_t length, size_t element_bytes, size_t per_piece){
+    size_t count = 0;
+    for(size_t done = 0; done < length; done += per_piece){
+        pieces[count].kind = kind;
+        pieces[count].first = first + done * element_bytes;
+        pieces[count].start = start + done;
+        pieces[count].length = length - done < per_piece ? length - done : per_piece;
+        count++;
+    }
+    return count;
+}
+
+// Cuts the storage of ll into pieces of about equal size for threads
+// threads, see "Parallel scans". *pieces, with room for threads pieces, is
+// replaced by an array allocated through malloc_fptr() unless ll is
+// compact.
+// Returns the number of pieces, 0 when storage holds nodes that are not in
+// the list or on failure.
+// Assuming ll != NULL and ll->size > 0
+size_t __linked_list_storage_pieces(struct linked_list* ll, size_t threads, struct scan_piece** pieces){
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        if(ll->arena.free_stack != LINKED_LIST_COMPACT_NIL || ll->arena.used != ll->size)
+            return 0;
+        return __scan_cut(*pieces, SCAN_SLOTS, (const char*)ll->arena.nodes, 0, ll->size,
+                          sizeof(struct compact_node), (ll->size + threads - 1) / threads);
+    }
+
+    bool chunks = ll->layout == LINKED_LIST_LAYOUT_UNROLLED;
+    if(ll->pool != NULL || (chunks ? ll->chunk_free_stack != NULL : ll->free_stack != NULL))
+        return 0;
+
+    size_t bytes = chunks ? sizeof(struct unrolled_node) : __linked_list_node_bytes(ll);
+    const struct block_carve* carve = chunks ? &ll->chunk_carve : &ll->carve;
+    if(carve->spare != NULL)
+        return 0;
+    const struct block_registry* blocks = &ll->blocks;
+    size_t live = 0;
+    for(size_t i = 0; i < blocks->count; i++){
+        const struct block_registry_entry* entry = &blocks->entries[i];
+        if(entry->chunks != chunks)
+            continue;
+        if(carve->next != NULL && carve->end == (char*)entry->base + entry->nodes * bytes)
+            live += ((const char*)carve->next - (const char*)entry->base) / bytes;
+        else
+            live += entry->nodes;
+    }
+    if(!chunks && live != ll->size)
+        return 0;
+
+    struct scan_piece* cut = malloc_fptr((blocks->count + threads) * sizeof(struct scan_piece));
+    if(cut == NULL)
+        return 0;
+    *pieces = cut;
+
+    size_t per_piece = (live + threads - 1) / threads;
+    size_t count = 0;
+    for(size_t i = 0; i < blocks->count; i++){
+        const struct block_registry_entry* entry = &blocks->entries[i];
+        if(entry->chunks != chunks)
+            continue;
+        size_t nodes = entry->nodes;
+        if(carve->next != NULL && carve->end == (char*)entry->base + entry->nodes * bytes)
+            nodes = ((const char*)carve->next - (const char*)entry->base) / bytes;
+        count += __scan_cut(cut + count, chunks ? SCAN_CHUNKS : SCAN_NODES, entry->base,
+                            0, nodes, bytes, per_piece);
+    }
+    return count;
+}
+
+// Cuts the list into threads segments of about equal length through the
+// positional index, rebuilding it if it went stale.
+// Returns the number of pieces, 0 on failure.
+// Assuming ll != NULL, ll->size > 0, ll->index != NULL and room for
+// threads pieces
+size_t __linked_list_index_pieces(struct linked_list* ll, size_t threads, struct scan_piece* pieces){
+    if(ll->index->stale && !__skip_index_rebuild(ll))
+        return 0;
+
+    size_t count = 0;
+    for(size_t t = 0; t < threads; t++){
+        size_t start;
+        struct skip_index_entry* entry = __skip_index_seek(ll->index, ll->size / threads * t, NULL, NULL, &start);
+        if(count > 0 && pieces[count - 1].start == start)
+            continue;
+        if(count > 0)
+            pieces[count - 1].length = start - pieces[count - 1].start;
+        pieces[count].kind = SCAN_CHAIN;
+        pieces[count].first = entry->first;
+        pieces[count].start = start;
+        count++;
+    }
+    pieces[count - 1].length = ll->size - pieces[count - 1].start;
+    return count;
+}
+
+// Scans the whole list with one thread, through iterators for the layouts
+// that have no chain of struct node.
+// Returns FALSE if an iterator could not be allocated.
+// Assuming ll != NULL and ll->size > 0
+bool __linked_list_scan_sequential(struct linked_list* ll, struct scan* scan, struct scan_result* result){
+    *result = (struct scan_result){0, 0, UINT_MAX, 0, true};
+    if(ll->layout == LINKED_LIST_LAYOUT_NODES || ll->layout == LINKED_LIST_LAYOUT_DOUBLY){
+        struct scan_piece piece = {SCAN_CHAIN, ll->head, 0, ll->size};
+        __linked_list_scan_piece(scan, &piece, result);
+        return true;
+    }
+
+    struct iterator* iter = __linked_list_own_iterator(ll);
+    if(iter == NULL)
+        return false;
+    unsigned int values[SCAN_CHECK_INTERVAL];
+    size_t count;
+    while((count = linked_list_iterate_batch(iter, values, SCAN_CHECK_INTERVAL)) != 0){
+        for(size_t i = 0; i < count; i++){
+            __scan_visit(scan, result, values[i]);
+        }
+    }
+    linked_list_delete_iterator(iter);
+    return true;
+}
+
+// Scans ll for op, in parallel when it can be cut into pieces.
+// Returns FALSE on failure.
+// Assuming ll != NULL and ll->size > 0
+bool __linked_list_scan(struct linked_list* ll, struct scan* scan, struct scan_result* result){
+    size_t threads = __linked_list_scan_thread_count(ll->size);
+    struct scan_piece stack_pieces[SCAN_MAX_THREADS];
+    struct scan_piece* pieces = stack_pieces;
+    // A find needs pieces that know their list position: those of the
+    // index, or compact slots, which turn out to be in list order or not.
+    bool ordered = scan->op == SCAN_FIND;
+    size_t count = 0;
+    if(ordered && ll->index != NULL)
+        count = __linked_list_index_pieces(ll, threads, pieces);
+    if(count == 0 && (!ordered || ll->layout == LINKED_LIST_LAYOUT_COMPACT))
+        count = __linked_list_storage_pieces(ll, threads, &pieces);
+    if(count == 0 && !ordered && ll->index != NULL)
+        count = __linked_list_index_pieces(ll, threads, pieces);
+    STATS_ADD(ll, scans, 1);
+    STATS_ADD(ll, scan_pieces, count == 0 ? 1 : count);
+    if(count == 0)
+        return !ordered && __linked_list_scan_sequential(ll, scan, result);
+
+    scan->kind = pieces[0].kind;
+    scan->node_bytes = __linked_list_node_bytes(ll);
+    scan->last_slot = ll->size - 1;
+    scan->pieces = pieces;
+    scan->piece_count = count;
+    scan->threads = threads < count ? threads : count;
+    atomic_init(&scan->found, SIZE_MAX);
+    __linked_list_run_scan(scan, result);
+    if(pieces != stack_pieces)
+        free_fptr(pieces);
+    scan->pieces = NULL;
+    return true;
+}
+
+// Sets how many threads linked_list_find_parallel(), linked_list_count()
+// and linked_list_reduce() may use. Lists are only split between threads
+// when each of them gets a sizeable part.
+// \param threads : Most threads per scan, 0 for one per online CPU.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_scan_threads(size_t threads){
+    scan_threads = threads;
+    return true;
+}
+
+// Same as linked_list_find(), scanning the linked_list with several threads
+// when it can be split, see linked_list_set_scan_threads(). Only a compact
+// linked_list in list order, or one with a positional index, can be split
+// into pieces that know their positions. Any other one is searched by
+// linked_list_find() straight away, so a find only scales on a nodes
+// linked_list after linked_list_enable_index(), and never on a doubly or
+// unrolled one.
+// \param ll   : Pointer to linked_list.
+// \param data : Data to find.
+// Returns index of the first index with that data, SIZE_MAX otherwise.
+//
+size_t linked_list_find_parallel(struct linked_list * ll,
+                                 unsigned int data){
+    if(ll == NULL)
+        return SIZE_MAX;
+
+    if(ll->size == 0 || __hash_index_usable(ll))
+        return linked_list_find(ll, data);
+
+    struct scan scan = {.op = SCAN_FIND, .data = data};
+    struct scan_result result;
+    if(!__linked_list_scan(ll, &scan, &result))
+        return linked_list_find(ll, data);
+
+    size_t found = atomic_load(&scan.found);
+    if(found == SIZE_MAX)
+        return SIZE_MAX;
+    if(scan.kind == SCAN_CHAIN || (result.in_order && ll->compact_head == 0))
+        return found;
+    // Slots out of list order only proved data is there, its position
+    // takes a walk.
+    return linked_list_find(ll, data);
+}
+
+// Counts the elements of the linked_list equal to data, with several
+// threads when it can be split. Its blocks are split as they are while
+// every node in them is live, as after a run of insertions or a fresh
+// linked_list_compact(). Once a removal has cached a node for reuse, or on
+// a node_pool, only the positional index of a nodes linked_list, see
+// linked_list_enable_index(), lets it be split. Otherwise the calling
+// thread scans it alone until the next linked_list_compact().
+// \param ll   : Pointer to linked_list.
+// \param data : Data to count.
+// Returns the count on success, SIZE_MAX on failure.
+//
+size_t linked_list_count(struct linked_list * ll,
+                         unsigned int data){
+    if(ll == NULL)
+        return SIZE_MAX;
+
+    if(ll->size == 0)
+        return 0;
+
+    if(__hash_index_usable(ll))
+        return __hash_index_probe(ll->hash, data)->count;
+
+    struct scan scan = {.op = SCAN_COUNT, .data = data};
+    struct scan_result result;
+    if(!__linked_list_scan(ll, &scan, &result))
+        return SIZE_MAX;
+    return result.count;
+}
+
+// Computes the sum, minimum and maximum of the elements of the linked_list,
+// with several threads when it can be split, see linked_list_count().
+// \param ll      : Pointer to linked_list.
+// \param summary : Set to the sum, minimum and maximum. An empty
+//                   linked_list sums to 0, with min UINT_MAX and max 0.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_reduce(struct linked_list * ll,
+                        struct linked_list_summary * summary){
+    if(ll == NULL || summary == NULL)
+        return false;
+
+    struct scan_result result = {0, 0, UINT_MAX, 0, true};
+    struct scan scan = {.op = SCAN_REDUCE};
+    if(ll->size > 0 && !__linked_list_scan(ll, &scan, &result))
+        return false;
+
+    summary->sum = result.sum;
+    summary->min = result.min;
+    summary->max = result.max;
+    return true;
+}
+
+// Writes to every page of [addr, addr + bytes) so that page faults are
+// taken now rather than on first use. Contents are left unchanged.
+//
+void __linked_list_prefault(void* addr, size_t bytes){
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    volatile char* bytes_ptr = addr;
+    for(size_t offset = 0; offset < bytes; offset += page_size){
+        bytes_ptr[offset] = bytes_ptr[offset];
+    }
+}
+
+// Pre-allocates room for extra_nodes more elements in a single allocation,
+// or in blocks of at most max_block nodes under the alloc_policy, so that
+// the next extra_nodes insertions do not call malloc_fptr().
+// \param ll          : Pointer to linked_list.
+// \param extra_nodes : Number of elements to reserve room for.
+// \param prefault    : Touch every page of the reservation up front.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_reserve(struct linked_list * ll,
+                         size_t extra_nodes,
+                         bool prefault){
+    if(ll == NULL)
+        return false;
+
+    if(extra_nodes == 0)
+        return true;
+
+    // Blocks are no bigger than max_block of the alloc_policy.
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED){
+        size_t chunks = (extra_nodes + LINKED_LIST_UNROLLED_CAPACITY - 1) / LINKED_LIST_UNROLLED_CAPACITY;
+        while(chunks != 0){
+            size_t size = __linked_list_capped_block(ll, chunks, LINKED_LIST_UNROLLED_CAPACITY);
+            struct unrolled_node* head = __linked_list_allocate_chunk_block(ll, size);
+            if(head == NULL)
+                return false;
+            if(prefault)
+                __linked_list_prefault(head, size * sizeof(struct unrolled_node));
+            if(!__linked_list_save_chunk_in_free_stack(ll, head))
+                return false;
+            chunks -= size;
+        }
+        return true;
+    }
+
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT){
+        // Every slot below arena.used is either live or recycled.
+        if(!__linked_list_compact_grow(ll, ll->size + extra_nodes))
+            return false;
+        if(prefault)
+            __linked_list_prefault(ll->arena.nodes + ll->arena.used,
+                                   (ll->arena.capacity - ll->arena.used) * sizeof(struct compact_node));
+        return true;
+    }
+
+    while(extra_nodes != 0){
+        size_t size = __linked_list_capped_block(ll, extra_nodes, 1);
+        struct node* head = __linked_list_allocate_block(ll, size);
+        if(head == NULL)
+            return false;
+        if(prefault)
+            __linked_list_prefault(head, size * __linked_list_node_bytes(ll));
+        if(!__linked_list_save_in_free_stack(ll, head))
+            return false;
+        extra_nodes -= size;
+    }
+    return true;
+}
+
+// Same as linked_list_reserve() without pre-faulting.
+// \param ll          : Pointer to linked_list.
+// \param extra_nodes : Number of elements to reserve room for.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_increase_capacity(struct linked_list* ll, size_t extra_nodes){
+    return linked_list_reserve(ll, extra_nodes, false);
+}
+
+// Turns software prefetching on for a linked_list. Iteration, pops from the
+// front and the positional walks then request the next node before it is
+// needed, and inside runs of physically consecutive nodes (fresh blocks,
+// or after linked_list_compact()) the node distance steps ahead too.
+// \param ll       : Pointer to linked_list.
+// \param distance : Look-ahead in nodes, 0 to turn prefetching off.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_prefetch(struct linked_list * ll, size_t distance){
+    if(ll == NULL)
+        return false;
 
+    ll->prefetch_distance = distance;
     return true;
 }
 
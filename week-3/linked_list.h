@@ -20,18 +20,330 @@
 // Feel free to change as desired.
 //
 struct node;
+struct unrolled_node;
+struct compact_node;
+struct skip_index;
+struct hash_index;
 
+// Number of values held by a single unrolled_node. Chosen so that an
+// unrolled_node fills exactly one 64 byte cache line.
+//
+#define LINKED_LIST_UNROLLED_CAPACITY 13
+
+// Index of a compact_node inside its arena that stands for "no node".
+//
+#define LINKED_LIST_COMPACT_NIL UINT32_MAX
+
+// Storage layouts supported by a linked_list.
+// 1. LINKED_LIST_LAYOUT_NODES    -> one value per struct node (default).
+// 2. LINKED_LIST_LAYOUT_UNROLLED -> up to LINKED_LIST_UNROLLED_CAPACITY
+//                                   values per struct unrolled_node.
+// 3. LINKED_LIST_LAYOUT_COMPACT  -> one value per 8 byte struct
+//                                   compact_node, all of them in one arena
+//                                   and linked by 32-bit index.
+// 4. LINKED_LIST_LAYOUT_DOUBLY   -> one value per struct dnode, linked both
+//                                   ways: removals at the tail or of a
+//                                   known node are O(1), iterators can move
+//                                   backwards.
+//
+enum linked_list_layout {
+    LINKED_LIST_LAYOUT_NODES = 0,
+    LINKED_LIST_LAYOUT_UNROLLED,
+    LINKED_LIST_LAYOUT_COMPACT,
+    LINKED_LIST_LAYOUT_DOUBLY,
+};
+
+// Kernels linked_list_find() scans the values of an unrolled linked_list
+// with, see linked_list_set_find_kernel(). The other layouts hold one value
+// per node and are walked node by node whatever the kernel.
+// 1. LINKED_LIST_FIND_KERNEL_AUTO   -> the widest kernel the CPU supports
+//                                      (default).
+// 2. LINKED_LIST_FIND_KERNEL_SCALAR -> one value per compare.
+// 3. LINKED_LIST_FIND_KERNEL_SSE42  -> 4 values per compare, x86 only.
+// 4. LINKED_LIST_FIND_KERNEL_AVX2   -> 8 values per compare, x86 only.
+//
+enum linked_list_find_kernel {
+    LINKED_LIST_FIND_KERNEL_AUTO = 0,
+    LINKED_LIST_FIND_KERNEL_SCALAR,
+    LINKED_LIST_FIND_KERNEL_SSE42,
+    LINKED_LIST_FIND_KERNEL_AVX2,
+};
+
+// Allocator for the blocks of nodes of a linked_list, see
+// linked_list_set_alloc_policy(). allocate returns bytes of memory aligned
+// to alignment, a power of two, or NULL. release gives back what allocate
+// returned, along with the same bytes. context is passed to both.
+//
+struct linked_list_allocator {
+    void * (*allocate)(size_t bytes, size_t alignment, void * context);
+    void   (*release)(void * addr, size_t bytes, void * context);
+    void * context;
+};
+
+// Allocator backing blocks with 2 MB aligned anonymous mappings, advised
+// to use transparent huge pages where the system supports them.
+//
+extern const struct linked_list_allocator linked_list_huge_page_allocator;
+
+// The memory a block of nodes lives in, as handed back to allocator, or to
+// free_fptr() when allocator is NULL. allocation is the start of the block
+// unless malloc_fptr() memory had to be aligned by hand.
+//
+struct block_memory {
+    void * allocation;
+    size_t bytes;
+    const struct linked_list_allocator * allocator;
+};
+
+// A block of nodes obtained from a single allocation. chunks is TRUE for a
+// block of unrolled nodes.
+//
+struct block_registry_entry {
+    void * base;
+    size_t nodes;
+    bool chunks;
+    struct block_memory memory;
+};
+
+// Growable array of the blocks owned by a linked_list. values is the
+// number of elements all of the blocks together can hold.
+//
+struct block_registry {
+    struct block_registry_entry * entries;
+    size_t count;
+    size_t capacity;
+    size_t values;
+};
+
+// The part of the newest block that has not been handed out yet. Nodes
+// (or unrolled nodes) are carved off it one at a time, from next up to end,
+// instead of all being pushed onto the free stack when the block arrives.
+// spare chains the never used ends of older blocks, left behind when a
+// block was allocated before the newest one ran out. Each is carved from
+// in turn once next reaches end.
+//
+struct block_carve {
+    void * next;
+    void * end;
+    void * spare;
+};
+
+// Single growable array holding every compact_node of a linked_list.
+// Nodes refer to each other by index, so the arena can be moved or written
+// out as a whole without fixing up any link.
+// nodes[used..capacity) have never been handed out, free_stack chains the
+// recycled ones.
+// mapping is the private file mapping of mapping_bytes bytes nodes lives
+// in after linked_list_load_mmap(), NULL when nodes came from
+// malloc_fptr().
+//
+struct compact_arena {
+    struct compact_node * nodes;
+    uint32_t capacity;
+    uint32_t used;
+    uint32_t free_stack;
+    void * mapping;
+    size_t mapping_bytes;
+};
+
+// Automatic trimming of a linked_list, see linked_list_set_trim_policy().
+// last_size and last_capacity record the state after the last trim.
+//
+struct trim_policy {
+    size_t ratio;
+    size_t min_capacity;
+    size_t last_size;
+    size_t last_capacity;
+};
+
+// How a linked_list sizes and allocates its blocks of nodes, see
+// linked_list_set_alloc_policy().
+// 1. initial_block  -> nodes per block while the linked_list is small
+// 2. growth_percent -> a larger linked_list allocates blocks of
+//                      growth_percent of its size, so 100 doubles its
+//                      capacity. 0 keeps every block at initial_block.
+// 3. max_block      -> most nodes per block, 0 for no limit. It holds for
+//                      every block, reservations, compaction, clones and
+//                      split halves included. The arena of a compact
+//                      linked_list is one array whatever it says.
+// 4. alignment      -> alignment of every block in bytes, a power of two,
+//                      0 for whatever the allocator returns
+// 5. allocator      -> NULL to use malloc_fptr() and free_fptr()
+//
+struct alloc_policy {
+    size_t initial_block;
+    size_t growth_percent;
+    size_t max_block;
+    size_t alignment;
+    const struct linked_list_allocator * allocator;
+};
+
+// Operation mix of an adaptive linked_list, see linked_list_set_adaptive().
+// 1. enabled    -> whether the linked_list may change its layout by itself
+// 2. sequential -> operations at either end, scans and iterated values since
+//                  the last operation in the middle of the linked_list
+// 3. positional -> operations in the middle since the last sequential one
+// 4. iterators  -> open iterators, the layout never changes under them
+// 5. untracked  -> an iterator was created while not adaptive. It may
+//                  still be open, so the linked_list can no longer become
+//                  adaptive.
+//
+struct adaptive_policy {
+    bool enabled;
+    size_t sequential;
+    size_t positional;
+    size_t iterators;
+    bool untracked;
+};
+
+// Number of fingers a linked_list keeps, see struct linked_list_finger.
+//
+#define LINKED_LIST_FINGERS 4
+
+// A node of a nodes or doubly linked_list and its position, left behind by
+// a positional walk so that the next walk nearby can start from there.
+// node is NULL while the finger is unused.
+//
+struct linked_list_finger {
+    struct node * node;
+    size_t index;
+};
+
+// Number of buckets of the walk length histograms of struct
+// linked_list_stats. Bucket 0 counts the calls that walked no node, bucket b
+// those that took 2^(b-1) to 2^b - 1 steps, the last bucket also counts
+// anything longer.
+//
+#define LINKED_LIST_STATS_BUCKETS 32
+
+// Instrumentation of a linked_list, see linked_list_get_stats().
+// 1. blocks, reserved_bytes -> blocks of nodes and the bytes allocated for
+//                  them, those of the node_pool when attached to one
+// 2. live_bytes -> bytes of the nodes holding elements
+// 3. free_nodes -> nodes of the current layout ready to be handed out,
+//                  either on the free stack or not carved yet
+// 4. node_requests -> nodes (unrolled nodes, compact nodes) asked for
+// 5. free_stack_hits, carve_hits -> node_requests served by the free
+//                  stack, and by the rest of the newest block. Any other
+//                  request had to wait for an allocation.
+// 6. allocations, allocated_bytes -> blocks (or compact arenas) allocated
+//                  through malloc_fptr() or the alloc policy's allocator,
+//                  and the bytes asked for
+// 7. insert_walks, remove_walks, find_walks -> histograms of the nodes
+//                  stepped over per linked_list_insert(),
+//                  linked_list_insert_front(), linked_list_insert_end(),
+//                  linked_list_remove() and linked_list_find() call, see
+//                  LINKED_LIST_STATS_BUCKETS. A find counts the elements it
+//                  compared.
+// 8. scans, scan_pieces -> linked_list_find_parallel(), linked_list_count()
+//                  and linked_list_reduce() calls that read the elements,
+//                  and the pieces they were split into between threads. A
+//                  scan by the calling thread alone is one piece.
+// 1 to 3 describe the linked_list when the stats are read, 4 to 8 count
+// from its creation or the last linked_list_reset_stats().
+//
+struct linked_list_stats {
+    size_t blocks;
+    size_t reserved_bytes;
+    size_t live_bytes;
+    size_t free_nodes;
+    size_t node_requests;
+    size_t free_stack_hits;
+    size_t carve_hits;
+    size_t allocations;
+    size_t allocated_bytes;
+    size_t insert_walks[LINKED_LIST_STATS_BUCKETS];
+    size_t remove_walks[LINKED_LIST_STATS_BUCKETS];
+    size_t find_walks[LINKED_LIST_STATS_BUCKETS];
+    size_t scans;
+    size_t scan_pieces;
+};
+
+// Free nodes and blocks shared by every linked_list attached to it through
+// linked_list_attach_pool(). Nodes removed from one attached linked_list
+// are reused by whichever attached linked_list needs one next.
+// node_bytes is the size of its nodes, sizeof(struct node).
+// Not thread safe: attached linked_lists must be used from one thread.
+//
+struct node_pool {
+    struct node * free_stack;
+    struct unrolled_node * chunk_free_stack;
+    struct block_registry blocks;
+    struct block_carve carve;
+    struct block_carve chunk_carve;
+    size_t node_bytes;
+    size_t lists;
+    bool deleted;
+};
 
 // The linked list structure contains:
 // 1. head -> pointer to the first node of the linkedlist
 // 2. tail -> pointer to the last node of the linkedlist
+//            head and tail stay NULL while the layout is not nodes or
+//            doubly. An adaptive linked_list may be compact at any time,
+//            check layout before reading them directly.
 // 3. free_stack -> A stack of nodes which are deleted from the linkedlist
+//    free_stack_bottom -> last node of free_stack while it is not empty,
+//            so that concat joins private free stacks in O(1)
+// 4. layout -> storage layout, see enum linked_list_layout
+// 5. chunk_head, chunk_tail, chunk_free_stack, chunk_free_stack_bottom ->
+//                  same as head, tail, free_stack and free_stack_bottom
+//                  for an unrolled linked_list. head and tail
+//                  stay NULL while the layout is unrolled.
+// 6. index -> optional positional index, NULL unless enabled through
+//             linked_list_enable_index()
+// 7. blocks -> every block the nodes (or unrolled nodes) were allocated
+//              from, so that they can be freed without walking the nodes
+// 8. pool -> node_pool the linked_list allocates from, NULL when it uses
+//            its own free_stack and blocks
+// 9. compact_head, compact_tail, arena -> head, tail and storage of a
+//            compact linked_list, as indices into arena.nodes
+// 10. carve, chunk_carve -> unused rest of the newest node (unrolled node)
+//            block, handed out once free_stack (chunk_free_stack) is empty
+// 11. trim -> automatic trim policy, disabled by default
+// 12. prefetch_distance -> software prefetch look-ahead in nodes, 0 when
+//            prefetching is off
+// 13. hash -> optional value index, NULL unless enabled through
+//            linked_list_enable_hash_index()
+// 14. alloc -> block sizing and allocation, see
+//            linked_list_set_alloc_policy()
+// 15. adaptive -> operation mix and layout switching, disabled by default,
+//            see linked_list_set_adaptive()
+// 16. fingers, finger_next -> nodes near recent positional accesses,
+//            where walks start, and the finger to replace next
+// 17. stats, walk_steps -> counters of linked_list_get_stats() and the
+//            length of the walk in progress. Always present, so that the
+//            layout does not depend on LINKED_LIST_STATS, but only kept
+//            up to date when built with it defined.
 //                  
 struct linked_list {
     struct node * head;
     struct node * tail;
     struct node * free_stack;
+    struct node * free_stack_bottom;
     size_t size;
+    enum linked_list_layout layout;
+    struct unrolled_node * chunk_head;
+    struct unrolled_node * chunk_tail;
+    struct unrolled_node * chunk_free_stack;
+    struct unrolled_node * chunk_free_stack_bottom;
+    struct skip_index * index;
+    struct block_registry blocks;
+    struct node_pool * pool;
+    uint32_t compact_head;
+    uint32_t compact_tail;
+    struct compact_arena arena;
+    struct block_carve carve;
+    struct block_carve chunk_carve;
+    struct trim_policy trim;
+    size_t prefetch_distance;
+    struct hash_index * hash;
+    struct alloc_policy alloc;
+    struct adaptive_policy adaptive;
+    struct linked_list_finger fingers[LINKED_LIST_FINGERS];
+    size_t finger_next;
+    struct linked_list_stats stats;
+    size_t walk_steps;
 };
 
 // A node in the linked_list structure.
@@ -43,13 +355,55 @@ struct node {
     bool is_block_head;
 };
 
+// A node of a doubly linked_list. It starts with a struct node, so that a
+// struct node * may point at it. prev is NULL at the head.
+//
+struct dnode {
+    struct node node;
+    struct node * prev;
+};
+
+// A node of an unrolled linked_list, holding count values in data.
+//
+struct unrolled_node {
+    struct unrolled_node * next;
+    uint16_t count;
+    bool is_block_head;
+    unsigned int data[LINKED_LIST_UNROLLED_CAPACITY];
+};
+
+// A node of a compact linked_list. next is the index of the following
+// node in the arena, LINKED_LIST_COMPACT_NIL at the tail.
+//
+struct compact_node {
+    uint32_t next;
+    unsigned int data;
+};
+
 // Very simple, not thread safe, iterator.
+// For an unrolled linked_list current_node is NULL and the position is
+// tracked by current_chunk and current_offset instead. For a compact
+// linked_list both are unused and current_slot, previous_slot hold the
+// arena indices of the current and previous nodes.
+// previous_node (previous_chunk) is the node before the current one, NULL
+// at the head. It lets the cursor functions below unlink in O(1).
+// Once the last element has been removed through the iterator, or read by
+// linked_list_iterate_batch(), it points past the end: current_index equals
+// the size of the linked_list.
+// adaptive is TRUE when the iterator is counted in ll->adaptive.iterators.
 //
 struct iterator {
     struct linked_list * ll;
     struct node * current_node;
     size_t current_index;
     unsigned int data;
+    struct unrolled_node * current_chunk;
+    size_t current_offset;
+    struct node * previous_node;
+    struct unrolled_node * previous_chunk;
+    uint32_t current_slot;
+    uint32_t previous_slot;
+    bool adaptive;
 };
 
 // Creates a new linked_list.
@@ -63,6 +417,184 @@ struct linked_list * linked_list_create(void);
 
 bool linked_list_create_in_place(struct linked_list* ll);
 
+// Frees everything owned by a linked_list created with
+// linked_list_create_in_place(), but not the linked_list itself.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_delete_in_place(struct linked_list * ll);
+
+// Changes the storage layout of an empty linked_list.
+// \param ll     : Pointer to linked_list.
+// \param layout : Layout to switch to.
+// PRECONDITION: linked_list is empty. Any cached nodes are released.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_layout(struct linked_list * ll,
+                            enum linked_list_layout layout);
+
+// Lets the linked_list pick its layout from the way it is used. A
+// linked_list that mostly sees insertions and removals at its ends, scans
+// and iteration moves its values, in order, into a compact arena: one
+// contiguous array that is walked sequentially. Once operations in the
+// middle dominate it moves back to nodes. Switching copies the values once
+// and never happens while an iterator created since is open, delete those
+// before the linked_list. Iterators created before are not tracked, so a
+// linked_list that ever had one cannot be made adaptive. Disabling it
+// moves the linked_list back to nodes.
+// \param ll      : Pointer to linked_list.
+// \param enabled : TRUE to switch layouts automatically.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_NODES and never had an
+//               iterator, or is already adaptive. It does not switch
+//               while it has an index or a node_pool, and functions taking
+//               two linked_lists need both in the same layout.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_adaptive(struct linked_list * ll, bool enabled);
+
+// Creates an empty node_pool.
+// Returns a new node_pool on success, NULL on failure.
+//
+struct node_pool * node_pool_create(void);
+
+// Deletes a node_pool. If linked_lists are still attached, the pool is
+// only freed once the last of them is deleted or detached.
+// \param pool : Pointer to node_pool.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool node_pool_delete(struct node_pool * pool);
+
+// Makes an empty linked_list take its nodes from pool, and give removed
+// nodes back to it. A NULL pool switches back to private allocation.
+// \param ll   : Pointer to linked_list.
+// \param pool : Pointer to node_pool, or NULL.
+// PRECONDITION: linked_list is empty and neither LINKED_LIST_LAYOUT_COMPACT
+//               nor LINKED_LIST_LAYOUT_DOUBLY. Any cached nodes are
+//               released.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_attach_pool(struct linked_list * ll,
+                             struct node_pool * pool);
+
+// Gives every block of the node_pool that holds no live node back through
+// free_fptr().
+// \param pool : Pointer to node_pool.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool node_pool_trim(struct node_pool * pool);
+
+// Gives every block of the linked_list that holds no live element back
+// through free_fptr(). Live elements do not move, so iterators stay valid.
+// A linked_list attached to a node_pool trims the node_pool.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_trim(struct linked_list * ll);
+
+// Makes removals trim the linked_list once its capacity exceeds both ratio
+// times its size and min_capacity. After a trim, the next one waits until
+// the linked_list has allocated more or shrunk to half its size, so a list
+// whose free blocks cannot be released is not trimmed on every removal.
+// \param ll           : Pointer to linked_list.
+// \param ratio        : Capacity to size ratio that triggers a trim, 0 to
+//                       disable automatic trimming.
+// \param min_capacity : Capacity, in elements, below which nothing is
+//                       trimmed.
+// PRECONDITION: linked_list is not attached to a node_pool.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_trim_policy(struct linked_list * ll,
+                                 size_t ratio,
+                                 size_t min_capacity);
+
+// Sets how the linked_list sizes and allocates its blocks of nodes, for
+// the blocks allocated from now on. Blocks keep the allocator they were
+// allocated with, which must outlive them. The compact layout's arena is
+// resized by copying and always uses malloc_fptr().
+// \param ll     : Pointer to linked_list.
+// \param policy : Policy to follow, NULL for the default one.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_alloc_policy(struct linked_list * ll,
+                                  const struct alloc_policy * policy);
+
+// Copies the alloc policy of the linked_list into policy.
+// \param ll     : Pointer to linked_list.
+// \param policy : Policy to fill in.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_get_alloc_policy(struct linked_list * ll,
+                                  struct alloc_policy * policy);
+
+// Fills in stats for the linked_list, see struct linked_list_stats.
+// \param ll    : Pointer to linked_list.
+// \param stats : Stats to fill in.
+// PRECONDITION: The library was built with LINKED_LIST_STATS defined.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_get_stats(struct linked_list * ll,
+                           struct linked_list_stats * stats);
+
+// Sets the counters and histograms of the linked_list back to zero.
+// \param ll : Pointer to linked_list.
+// PRECONDITION: The library was built with LINKED_LIST_STATS defined.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_reset_stats(struct linked_list * ll);
+
+// Turns software prefetching on for a linked_list. Iteration, pops from the
+// front and the positional walks then request the next node before it is
+// needed, and inside runs of physically consecutive nodes (fresh blocks,
+// or after linked_list_compact()) the node distance steps ahead too.
+// \param ll       : Pointer to linked_list.
+// \param distance : Look-ahead in nodes, 0 to turn prefetching off.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_prefetch(struct linked_list * ll, size_t distance);
+
+// Enables the positional index of a linked_list. While enabled,
+// linked_list_insert(), linked_list_remove() and
+// linked_list_create_iterator() reach any index in O(log n), at the cost
+// of O(log n) bookkeeping on every insertion and removal.
+// \param ll : Pointer to linked_list.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_NODES.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_enable_index(struct linked_list * ll);
+
+// Disables and frees the positional index of a linked_list.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_disable_index(struct linked_list * ll);
+
+// Enables the hash index of a linked_list. While enabled,
+// linked_list_contains() is O(1) and linked_list_find() O(1) expected:
+// first positions moved by insertions or removals other than at the front
+// or the end are recomputed, with one walk, by the next lookup that needs
+// one. Every insertion and removal updates the index in O(1).
+// \param ll : Pointer to linked_list.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_NODES or
+//               LINKED_LIST_LAYOUT_DOUBLY.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_enable_hash_index(struct linked_list * ll);
+
+// Disables and frees the hash index of a linked_list.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_disable_hash_index(struct linked_list * ll);
+
+// Returns whether data is in the linked_list. O(1) with the hash index
+// enabled, a linked_list_find() otherwise.
+// \param ll   : Pointer to linked_list.
+// \param data : Data to look for.
+// Returns TRUE if data is in the linked_list, FALSE otherwise.
+//
+bool linked_list_contains(struct linked_list * ll,
+                          unsigned int data);
+
 // Deletes a linked_list.
 // \param ll : Pointer to linked_list to delete
 // POSTCONDITION : An empty linked_list has its head point to NULL.
@@ -92,6 +624,27 @@ bool linked_list_insert_end(struct linked_list * ll,
 bool linked_list_insert_front(struct linked_list * ll,
                               unsigned int data);
 
+// Inserts count elements at the end of the linked_list, in order.
+// \param ll    : Pointer to linked_list.
+// \param data  : Data to insert.
+// \param count : Number of elements in data.
+// Returns TRUE on success, FALSE otherwise. Nothing is inserted on failure.
+//
+bool linked_list_insert_end_n(struct linked_list * ll,
+                              const unsigned int * data,
+                              size_t count);
+
+// Inserts count elements at the front of the linked_list, so that it
+// starts with data[0], data[1], ..., data[count - 1].
+// \param ll    : Pointer to linked_list.
+// \param data  : Data to insert.
+// \param count : Number of elements in data.
+// Returns TRUE on success, FALSE otherwise. Nothing is inserted on failure.
+//
+bool linked_list_insert_front_n(struct linked_list * ll,
+                                const unsigned int * data,
+                                size_t count);
+
 // Inserts an element at a specified index in the linked_list.
 // \param ll    : Pointer to linked_list.
 // \param index : Index to insert data at.
@@ -110,6 +663,14 @@ bool linked_list_insert(struct linked_list * ll,
 size_t linked_list_find(struct linked_list * ll,
                         unsigned int data);
 
+// Sets the kernel linked_list_find() scans unrolled linked_lists with, for
+// every linked_list. Every kernel returns the same index.
+// \param kernel : Kernel to use, see enum linked_list_find_kernel.
+// Returns TRUE on success, FALSE if the CPU does not support kernel, the
+// kernel in use is kept then.
+//
+bool linked_list_set_find_kernel(enum linked_list_find_kernel kernel);
+
 // Removes a node from the linked_list at a specific index.
 // \param ll    : Pointer to linked_list.
 // \param index : Index to remove node.
@@ -118,6 +679,24 @@ size_t linked_list_find(struct linked_list * ll,
 bool linked_list_remove(struct linked_list * ll,
                         size_t index);
 
+// Removes the last element of the linked_list. O(1) with
+// LINKED_LIST_LAYOUT_DOUBLY, the other layouts walk to the tail.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_remove_end(struct linked_list * ll);
+
+// Removes node from the linked_list in O(1), without knowing its index.
+// \param ll   : Pointer to linked_list.
+// \param node : Node of ll to remove, such as the current_node of an
+//               iterator.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_DOUBLY. Iterators on
+//               node are invalidated.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_remove_node(struct linked_list * ll,
+                             struct node * node);
+
 // Removes all elements from linked list
 // Returns TRUE on success, FALSE otherwise
 bool linked_list_remove_all(struct linked_list * ll);
@@ -142,7 +721,234 @@ bool linked_list_delete_iterator(struct iterator * iter);
 //
 bool linked_list_iterate(struct iterator * iter);
 
+// Moves an iterator back to the previous node in the linked_list. An
+// iterator past the end moves to the last element.
+// \param iterator: Iterator to iterate on.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_DOUBLY.
+// Returns TRUE when previous node is present, FALSE once start of list is
+// reached.
+//
+bool linked_list_iterate_reverse(struct iterator * iter);
+
+// Copies up to n consecutive values, starting with the iterator's current
+// element, into buf and moves the iterator to the element after the last
+// one copied. Once the last element has been copied the iterator points
+// past the end.
+// \param iter : Iterator to read from.
+// \param buf  : Caller owned array with room for n values.
+// \param n    : Maximum number of values to copy.
+// Returns the number of values copied, 0 past the end or on error.
+//
+size_t linked_list_iterate_batch(struct iterator * iter,
+                                 unsigned int * buf,
+                                 size_t n);
+
+// Inserts an element right after the iterator's current element.
+// The iterator stays on its current element.
+// \param iter : Iterator to insert after.
+// \param data : Data to insert.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_insert_after_iterator(struct iterator * iter,
+                                       unsigned int data);
+
+// Inserts an element right before the iterator's current element, or at
+// the end of the linked_list if the iterator points past the end.
+// The iterator stays on its current element, whose index grows by one.
+// \param iter : Iterator to insert before.
+// \param data : Data to insert.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_insert_before_iterator(struct iterator * iter,
+                                        unsigned int data);
+
+// Removes the iterator's current element. The iterator moves on to the
+// element that followed it, keeping the same index.
+// \param iter : Iterator to remove at.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_remove_at_iterator(struct iterator * iter);
+
+// Moves every element of a linked_list into one new block, in list order,
+// or blocks of max_block nodes under the alloc_policy, so that iterating
+// over it reads memory sequentially. The blocks holding
+// the elements before are freed, or handed back to the node_pool.
+// Iterators on the linked_list are invalidated.
+// \param ll : Pointer to linked_list.
+// Returns TRUE on success, FALSE otherwise. The linked_list is unchanged
+// on failure.
+//
+bool linked_list_compact(struct linked_list * ll);
+
+// Incremental linked_list_compact(): moves the n elements starting with
+// the iterator's current one, no more than max_block of the alloc_policy,
+// into a new block, in list order, and moves the iterator to the element
+// after them. Calling it repeatedly until it returns 0 compacts the rest
+// of the list a bounded step at a time. The old nodes go back to the free
+// stack, linked_list_trim() can then release their blocks.
+// \param iter : Iterator to compact from.
+// \param n    : Maximum number of elements to move.
+// PRECONDITION: linked_list uses LINKED_LIST_LAYOUT_NODES or
+//               LINKED_LIST_LAYOUT_DOUBLY.
+// Returns the number of elements moved, 0 past the end or on error.
+//
+size_t linked_list_compact_at_iterator(struct iterator * iter, size_t n);
+
+// Creates a copy of the linked_list, with the same layout and policies. Its
+// values sit in one block allocated for exactly that many, or blocks of
+// max_block nodes under its alloc_policy, linked in physical order, as after linked_list_compact(). The copy has private
+// storage, even when ll is attached to a node_pool, and no index.
+// \param ll : Pointer to linked_list.
+// Returns a new linked_list on success, NULL on failure.
+//
+struct linked_list * linked_list_clone(struct linked_list * ll);
+
+// Sorts a linked_list in ascending order, stably, by relinking its nodes:
+// no node is allocated or copied. An unrolled linked_list sorts its values
+// through a scratch array instead. Iterators on the linked_list are
+// invalidated.
+// \param ll      : Pointer to linked_list.
+// \param compact : Also lay the sorted nodes out in physical order, as
+//                  linked_list_compact() does.
+// Returns TRUE on success, FALSE otherwise. A linked_list that could not be
+// compacted is still sorted.
+//
+bool linked_list_sort(struct linked_list * ll, bool compact);
+
+// Moves every element of src to the end of dst, leaving src empty.
+// \param dst : Pointer to linked_list receiving the elements.
+// \param src : Pointer to linked_list giving its elements.
+// PRECONDITION: Both linked_lists have the same layout, other than
+//               LINKED_LIST_LAYOUT_COMPACT. src is private or attached to
+//               the node_pool of dst. O(1) when both share a node_pool,
+//               O(blocks of src) when src is private.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_concat(struct linked_list * dst, struct linked_list * src);
+
+// Moves every element of src into dst, right before the current element of
+// iter, or at the end of dst if iter is past its end. src is left empty.
+// iter stays on its element, whose index grows by the size of src.
+// \param dst  : Pointer to linked_list receiving the elements.
+// \param iter : Iterator on dst.
+// \param src  : Pointer to linked_list giving its elements.
+// PRECONDITION: Same as linked_list_concat().
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_splice(struct linked_list * dst, struct iterator * iter, struct linked_list * src);
+
+// Splits a linked_list in two: the current element of iter and every one
+// after it move, in order, to a new linked_list. iter is left past the end
+// of its now shorter linked_list.
+// With a node_pool both halves keep sharing it and the elements are
+// relinked in O(1). A private linked_list stays private: the new one gets
+// its elements copied into blocks of its own, as linked_list_clone()
+// does, and the nodes they leave go back to the free stack. This makes
+// splitting a private linked_list the one O(n) transfer: its blocks hold
+// nodes of both halves, and each block has a single owner. Attach both to
+// a node_pool where splits must be O(1).
+// The new linked_list has the layout and policies of the original one and
+// no index.
+// \param iter : Iterator on the linked_list to split.
+// PRECONDITION: linked_list is not LINKED_LIST_LAYOUT_COMPACT.
+// Returns the new linked_list on success, NULL otherwise.
+//
+struct linked_list * linked_list_split_at(struct iterator * iter);
+
+// Writes the values of the linked_list to fd, in order, as a header
+// followed by the arena of a compact linked_list holding them.
+// linked_list_load_mmap() maps such a file back without copying it.
+// \param ll : Pointer to linked_list.
+// \param fd : File descriptor open for writing.
+// PRECONDITION: linked_list holds less than LINKED_LIST_COMPACT_NIL values.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_save(struct linked_list * ll, int fd);
+
+// Creates a compact linked_list over a private mapping of a file written
+// by linked_list_save(). Nothing is read until the linked_list is used, and
+// pages are copied on their first write, so the file is never modified.
+// The mapping is released once the arena grows, is trimmed, compacted or
+// the linked_list deleted.
+// \param path : Path of the file.
+// PRECONDITION: The file was written by linked_list_save() on a machine of
+//               the same byte order and is not truncated while mapped.
+// Returns a new linked_list on success, NULL on failure.
+//
+struct linked_list * linked_list_load_mmap(const char * path);
+
+// Sum, minimum and maximum of the elements of a linked_list, see
+// linked_list_reduce().
+//
+struct linked_list_summary {
+    uint64_t sum;
+    unsigned int min;
+    unsigned int max;
+};
+
+// Sets how many threads linked_list_find_parallel(), linked_list_count()
+// and linked_list_reduce() may use. Lists are only split between threads
+// when each of them gets a sizeable part.
+// \param threads : Most threads per scan, 0 for one per online CPU.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_set_scan_threads(size_t threads);
+
+// Same as linked_list_find(), scanning the linked_list with several threads
+// when it can be split, see linked_list_set_scan_threads(). Only a compact
+// linked_list in list order, or one with a positional index, can be split
+// into pieces that know their positions. Any other one is searched by
+// linked_list_find() straight away, so a find only scales on a nodes
+// linked_list after linked_list_enable_index(), and never on a doubly or
+// unrolled one.
+// \param ll   : Pointer to linked_list.
+// \param data : Data to find.
+// Returns index of the first index with that data, SIZE_MAX otherwise.
+//
+size_t linked_list_find_parallel(struct linked_list * ll,
+                                 unsigned int data);
+
+// Counts the elements of the linked_list equal to data, with several
+// threads when it can be split. Its blocks are split as they are while
+// every node in them is live, as after a run of insertions or a fresh
+// linked_list_compact(). Once a removal has cached a node for reuse, or on
+// a node_pool, only the positional index of a nodes linked_list, see
+// linked_list_enable_index(), lets it be split. Otherwise the calling
+// thread scans it alone until the next linked_list_compact().
+// \param ll   : Pointer to linked_list.
+// \param data : Data to count.
+// Returns the count on success, SIZE_MAX on failure.
+//
+size_t linked_list_count(struct linked_list * ll,
+                         unsigned int data);
 
+// Computes the sum, minimum and maximum of the elements of the linked_list,
+// with several threads when it can be split, see linked_list_count().
+// \param ll      : Pointer to linked_list.
+// \param summary : Set to the sum, minimum and maximum. An empty
+//                   linked_list sums to 0, with min UINT_MAX and max 0.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_reduce(struct linked_list * ll,
+                        struct linked_list_summary * summary);
+
+// Pre-allocates room for extra_nodes more elements in a single allocation,
+// or in blocks of at most max_block nodes under the alloc_policy, so that
+// the next extra_nodes insertions do not call malloc_fptr().
+// \param ll          : Pointer to linked_list.
+// \param extra_nodes : Number of elements to reserve room for.
+// \param prefault    : Touch every page of the reservation up front.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool linked_list_reserve(struct linked_list * ll,
+                         size_t extra_nodes,
+                         bool prefault);
+
+// Same as linked_list_reserve() without pre-faulting.
+// \param ll          : Pointer to linked_list.
+// \param extra_nodes : Number of elements to reserve room for.
+// Returns TRUE on success, FALSE otherwise.
+//
 bool linked_list_increase_capacity(struct linked_list* ll, size_t extra_nodes);
 
 // Registers malloc() function.
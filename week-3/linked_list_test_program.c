@@ -1,3 +1,4 @@
+#include <limits.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -561,6 +562,3250 @@ void check_linked_list_additional_delete_tests(void) {
 #endif 
 }
 
+// Compares a linked_list against an array of expected values.
+//
+bool linked_list_matches(struct linked_list * ll,
+                         const unsigned int * expected,
+                         size_t size) {
+    if (linked_list_size(ll) != size) {
+        return false;
+    }
+    if (size == 0) {
+        return linked_list_create_iterator(ll, 0) == NULL;
+    }
+
+    struct iterator * iter = linked_list_create_iterator(ll, 0);
+    if (iter == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < size; i++) {
+        if (iter->data != expected[i] || iter->current_index != i) {
+            linked_list_delete_iterator(iter);
+            return false;
+        }
+        if (linked_list_iterate(iter) != (i + 1 < size)) {
+            linked_list_delete_iterator(iter);
+            return false;
+        }
+    }
+    linked_list_delete_iterator(iter);
+
+    // Doubly linked lists must read the same backwards.
+    //
+    if (ll->layout == LINKED_LIST_LAYOUT_DOUBLY) {
+        struct node * prev = NULL;
+        for (struct node * curr = ll->head; curr != NULL; curr = curr->next) {
+            if (((struct dnode *)curr)->prev != prev) {
+                return false;
+            }
+            prev = curr;
+        }
+        if (prev != ll->tail) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void check_linked_list_unrolled_functionality(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_unrolled_functionality)
+
+    SUBTEST(set_layout)
+    struct linked_list * ll = linked_list_create();
+    FAIL(ll == NULL,
+         "Failed to create new linked_list")
+    linked_list_insert_end(ll, 1);
+    FAIL(linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED) != false,
+         "linked_list_set_layout() changed the layout of a non-empty linked_list")
+    linked_list_remove(ll, 0);
+    FAIL(linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED) != true,
+         "linked_list_set_layout() failed on an empty linked_list")
+
+    // Mix of insertions and removals spanning many unrolled nodes, checked
+    // against a plain array.
+    //
+    SUBTEST(unrolled_random_operations)
+    static unsigned int expected[2048];
+    size_t size = 0;
+    unsigned int seed = 12345;
+    for (size_t op = 0; op < 6000; op++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned int choice = (seed >> 16) % 8;
+        unsigned int value  = seed >> 20;
+        if (size > 0 && (choice < 3 || size == 2048)) {
+            size_t index = (seed >> 8) % size;
+            FAIL(linked_list_remove(ll, index) != true,
+                 "linked_list_remove() failed on unrolled linked_list")
+            memmove(expected + index, expected + index + 1,
+                    (size - index - 1) * sizeof(unsigned int));
+            size--;
+        } else {
+            size_t index = (choice == 3) ? 0 :
+                           (choice == 4) ? size : (seed >> 8) % (size + 1);
+            FAIL(linked_list_insert(ll, index, value) != true,
+                 "linked_list_insert() failed on unrolled linked_list")
+            memmove(expected + index + 1, expected + index,
+                    (size - index) * sizeof(unsigned int));
+            expected[index] = value;
+            size++;
+        }
+    }
+    FAIL(!linked_list_matches(ll, expected, size),
+         "Unrolled linked_list contents differ from expected values")
+
+    SUBTEST(unrolled_find)
+    for (size_t i = 0; i < size; i += 97) {
+        size_t index = linked_list_find(ll, expected[i]);
+        FAIL(index > i || expected[index] != expected[i],
+             "linked_list_find() returned wrong index on unrolled linked_list")
+    }
+
+    SUBTEST(unrolled_iterator_at_index)
+    struct iterator * iter = linked_list_create_iterator(ll, size / 2);
+    FAIL(iter == NULL || iter->data != expected[size / 2],
+         "Iterator created in the middle of an unrolled linked_list has wrong data")
+    linked_list_delete_iterator(iter);
+
+    SUBTEST(unrolled_remove_all)
+    FAIL(linked_list_remove_all(ll) != true,
+         "linked_list_remove_all() failed on unrolled linked_list")
+    FAIL(!linked_list_matches(ll, expected, 0),
+         "Unrolled linked_list not empty after linked_list_remove_all()")
+    for (size_t i = 0; i < 100; i++) {
+        linked_list_insert_front(ll, 100 - i);
+        expected[i] = i + 1;
+    }
+    FAIL(!linked_list_matches(ll, expected, 100),
+         "Unrolled linked_list wrong after linked_list_insert_front()")
+
+    linked_list_delete(ll);
+    PASS(check_linked_list_unrolled_functionality)
+#endif
+}
+
+void check_linked_list_find_layouts(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_find_layouts)
+
+    // Values 1 to 1000, so that a zero filled vector lane never matches.
+    // Every fifth value is inserted out of order to break up the physically
+    // contiguous runs of nodes.
+    //
+    for (int layout = 0; layout < 4; layout++) {
+        struct linked_list * ll = linked_list_create();
+        FAIL(ll == NULL,
+             "Failed to create new linked_list")
+        linked_list_set_layout(ll, (enum linked_list_layout)layout);
+        for (size_t i = 1; i <= 1000; i++) {
+            if (i % 5 != 0) {
+                linked_list_insert_end(ll, i);
+            }
+        }
+        for (size_t i = 5; i <= 1000; i += 5) {
+            linked_list_insert(ll, i - 1, i);
+        }
+
+        SUBTEST(find_every_value)
+        for (size_t i = 1; i <= 1000; i++) {
+            FAIL(linked_list_find(ll, i) != i - 1,
+                 "linked_list_find() returned the wrong index")
+        }
+
+        SUBTEST(find_missing_values)
+        FAIL(linked_list_find(ll, 0) != SIZE_MAX,
+             "linked_list_find() found 0 when it is not in the linked_list")
+        FAIL(linked_list_find(ll, 1001) != SIZE_MAX,
+             "linked_list_find() found 1001 when it is not in the linked_list")
+
+        linked_list_delete(ll);
+    }
+
+    // Every kernel the CPU supports agrees with the scalar one on unrolled
+    // nodes of every fill, for values 1 to 700, and for 0, which masked out
+    // lanes read as, first missing and then present.
+    //
+    SUBTEST(find_kernels)
+    FAIL(linked_list_set_find_kernel(LINKED_LIST_FIND_KERNEL_SCALAR) != true ||
+         linked_list_set_find_kernel(LINKED_LIST_FIND_KERNEL_AUTO) != true,
+         "linked_list_set_find_kernel() refused the scalar kernel")
+    FAIL(linked_list_set_find_kernel((enum linked_list_find_kernel)99) != false,
+         "linked_list_set_find_kernel() accepted an unknown kernel")
+    struct linked_list * ll = linked_list_create();
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+    static unsigned int values[3001];
+    size_t size = 0;
+    unsigned int seed = 7;
+    for (size_t i = 0; i < 4000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        size_t index = (seed >> 8) % (size + 1);
+        if (i % 4 == 3) {
+            index = index == size ? 0 : index;
+            linked_list_remove(ll, index);
+            memmove(values + index, values + index + 1, (size - index - 1) * sizeof(unsigned int));
+            size--;
+            continue;
+        }
+        memmove(values + index + 1, values + index, (size - index) * sizeof(unsigned int));
+        values[index] = (seed >> 4) % 700 + 1;
+        linked_list_insert(ll, index, values[index]);
+        size++;
+    }
+    FAIL(!linked_list_matches(ll, values, size),
+         "Unrolled linked_list contents differ from expected values")
+    static size_t first[701];
+    for (int round = 0; round < 2; round++) {
+        if (round == 1) {
+            linked_list_insert(ll, size - 5, 0);
+            memmove(values + size - 4, values + size - 5, 5 * sizeof(unsigned int));
+            values[size - 5] = 0;
+            size++;
+        }
+        linked_list_set_find_kernel(LINKED_LIST_FIND_KERNEL_SCALAR);
+        for (unsigned int v = 0; v <= 700; v++) {
+            size_t index = 0;
+            while (index < size && values[index] != v) {
+                index++;
+            }
+            first[v] = index == size ? SIZE_MAX : index;
+            FAIL(linked_list_find(ll, v) != first[v],
+                 "Scalar find kernel returned the wrong index")
+        }
+        for (int kernel = LINKED_LIST_FIND_KERNEL_SSE42; kernel <= LINKED_LIST_FIND_KERNEL_AVX2; kernel++) {
+            if (!linked_list_set_find_kernel((enum linked_list_find_kernel)kernel)) {
+                continue;
+            }
+            for (unsigned int v = 0; v <= 700; v++) {
+                FAIL(linked_list_find(ll, v) != first[v],
+                     "Find kernel disagrees with the scalar one")
+            }
+        }
+    }
+    linked_list_set_find_kernel(LINKED_LIST_FIND_KERNEL_AUTO);
+    linked_list_delete(ll);
+
+    PASS(check_linked_list_find_layouts)
+#endif
+}
+
+void check_linked_list_reserve(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_reserve)
+
+    SUBTEST(reserve_null)
+    FAIL(linked_list_reserve(NULL, 10, false) != false,
+         "linked_list_reserve(NULL, 10, false) did not return false")
+
+    // After reserving, insertions must not reach the allocator. Arm the
+    // instrumented allocator to fail and check it is never consumed.
+    //
+    for (int layout = 0; layout < 4; layout++) {
+        SUBTEST(reserve_then_insert)
+        struct linked_list * ll = linked_list_create();
+        linked_list_set_layout(ll, (enum linked_list_layout)layout);
+        FAIL(linked_list_reserve(ll, 1000, layout == 0) != true,
+             "linked_list_reserve() failed")
+        instrumented_malloc_fail_next = true;
+        for (size_t i = 0; i < 1000; i++) {
+            FAIL(linked_list_insert_end(ll, i) != true,
+                 "linked_list_insert_end() failed after linked_list_reserve()")
+        }
+        FAIL(instrumented_malloc_fail_next != true,
+             "Insertion into reserved capacity called malloc()")
+        instrumented_malloc_fail_next = false;
+        linked_list_delete(ll);
+    }
+
+    SUBTEST(reserve_exact_count)
+    struct linked_list * ll = linked_list_create();
+    FAIL(linked_list_increase_capacity(ll, 10) != true,
+         "linked_list_increase_capacity() failed")
+    for (size_t i = 0; i < 10; i++) {
+        linked_list_insert_front(ll, i);
+    }
+    instrumented_malloc_fail_next = true;
+    FAIL(linked_list_insert_front(ll, 10) != false,
+         "linked_list_increase_capacity() reserved more than requested")
+    FAIL(linked_list_size(ll) != 10,
+         "Failed insertion changed the size of the linked_list")
+    linked_list_delete(ll);
+    PASS(check_linked_list_reserve)
+#endif
+
+#ifdef TEST_QUEUE
+    TEST(check_queue_reserve)
+    SUBTEST(queue_reserve_then_push)
+    struct queue * queue = queue_create();
+    FAIL(queue_reserve(queue, 64, true) != true,
+         "queue_reserve() failed")
+    instrumented_malloc_fail_next = true;
+    for (size_t i = 0; i < 64; i++) {
+        FAIL(queue_push(queue, i) != true,
+             "queue_push() failed after queue_reserve()")
+    }
+    FAIL(instrumented_malloc_fail_next != true,
+         "queue_push() into reserved capacity called malloc()")
+    instrumented_malloc_fail_next = false;
+    queue_delete(queue);
+    PASS(check_queue_reserve)
+#endif
+}
+
+void check_linked_list_index(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_index)
+
+    SUBTEST(index_null_and_layout)
+    FAIL(linked_list_enable_index(NULL) != false,
+         "linked_list_enable_index(NULL) did not return false")
+    struct linked_list * ll = linked_list_create();
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+    FAIL(linked_list_enable_index(ll) != false,
+         "linked_list_enable_index() accepted an unrolled linked_list")
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_NODES);
+
+    // Enable the index half way through to exercise the initial build, then
+    // keep mixing positional operations and check against a plain array.
+    //
+    SUBTEST(index_random_operations)
+    static unsigned int expected[4096];
+    size_t size = 0;
+    unsigned int seed = 777;
+    for (size_t op = 0; op < 40000; op++) {
+        if (op == 1000) {
+            FAIL(linked_list_enable_index(ll) != true,
+                 "linked_list_enable_index() failed")
+        }
+        seed = seed * 1103515245u + 12345u;
+        unsigned int choice = (seed >> 16) % 8;
+        if (size > 0 && (choice < 3 || size == 4096)) {
+            size_t index = (choice == 0) ? 0 :
+                           (choice == 1) ? size - 1 : (seed >> 4) % size;
+            FAIL(linked_list_remove(ll, index) != true,
+                 "linked_list_remove() failed on indexed linked_list")
+            memmove(expected + index, expected + index + 1,
+                    (size - index - 1) * sizeof(unsigned int));
+            size--;
+        } else {
+            size_t index = (choice == 3) ? 0 :
+                           (choice == 4) ? size : (seed >> 4) % (size + 1);
+            FAIL(linked_list_insert(ll, index, op) != true,
+                 "linked_list_insert() failed on indexed linked_list")
+            memmove(expected + index + 1, expected + index,
+                    (size - index) * sizeof(unsigned int));
+            expected[index] = op;
+            size++;
+        }
+        if (op % 97 == 0 && size > 0) {
+            size_t index = (seed >> 3) % size;
+            struct iterator * iter = linked_list_create_iterator(ll, index);
+            FAIL(iter == NULL || iter->data != expected[index],
+                 "Iterator from indexed linked_list has wrong data")
+            linked_list_delete_iterator(iter);
+        }
+    }
+    FAIL(!linked_list_matches(ll, expected, size),
+         "Indexed linked_list contents differ from expected values")
+
+    // Drain from the front so that every segment empties out.
+    //
+    SUBTEST(index_drain)
+    while (size > 0) {
+        FAIL(linked_list_remove(ll, 0) != true,
+             "linked_list_remove() failed while draining indexed linked_list")
+        size--;
+        if (size > 0) {
+            // expected still holds the removed value in front.
+            //
+            struct iterator * iter = linked_list_create_iterator(ll, size - 1);
+            FAIL(iter == NULL || iter->data != expected[size] ||
+                 linked_list_iterate(iter) != false,
+                 "Iterator at the end of a drained indexed linked_list is wrong")
+            linked_list_delete_iterator(iter);
+        }
+        memmove(expected, expected + 1, size * sizeof(unsigned int));
+    }
+
+    // Positional operations on a large list must not walk from the head.
+    //
+    SUBTEST(index_large_list)
+    for (size_t i = 0; i < 200000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    for (size_t i = 0; i < 200000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        size_t index = (seed >> 4) % linked_list_size(ll);
+        FAIL(linked_list_insert(ll, index, 7) != true,
+             "linked_list_insert() failed on large indexed linked_list")
+        seed = seed * 1103515245u + 12345u;
+        index = (seed >> 4) % linked_list_size(ll);
+        FAIL(linked_list_remove(ll, index) != true,
+             "linked_list_remove() failed on large indexed linked_list")
+    }
+    FAIL(linked_list_size(ll) != 200000,
+         "Large indexed linked_list has the wrong size")
+
+    SUBTEST(index_disable)
+    FAIL(linked_list_disable_index(ll) != true,
+         "linked_list_disable_index() failed")
+    linked_list_delete(ll);
+    PASS(check_linked_list_index)
+#endif
+}
+
+void check_linked_list_cursor(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_cursor)
+
+    SUBTEST(cursor_null)
+    FAIL(linked_list_insert_after_iterator(NULL, 0) != false,
+         "linked_list_insert_after_iterator(NULL, 0) did not return false")
+    FAIL(linked_list_insert_before_iterator(NULL, 0) != false,
+         "linked_list_insert_before_iterator(NULL, 0) did not return false")
+    FAIL(linked_list_remove_at_iterator(NULL) != false,
+         "linked_list_remove_at_iterator(NULL) did not return false")
+
+    // Nodes, nodes with the positional index, unrolled, compact and doubly
+    // linked.
+    //
+    static unsigned int expected[400000];
+    for (int variant = 0; variant < 5; variant++) {
+        struct linked_list * ll = linked_list_create();
+        if (variant == 1) {
+            linked_list_enable_index(ll);
+        }
+        if (variant == 2) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+        }
+        if (variant == 3) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT);
+        }
+        if (variant == 4) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+        }
+        for (size_t i = 1; i <= 200000; i++) {
+            linked_list_insert_end(ll, i);
+        }
+
+        // Drop the even values in a single pass.
+        //
+        SUBTEST(cursor_filter)
+        struct iterator * iter = linked_list_create_iterator(ll, 0);
+        while (iter->current_index < linked_list_size(ll)) {
+            if (iter->data % 2 == 0) {
+                FAIL(linked_list_remove_at_iterator(iter) != true,
+                     "linked_list_remove_at_iterator() failed")
+            } else if (!linked_list_iterate(iter)) {
+                break;
+            }
+        }
+        linked_list_delete_iterator(iter);
+        for (size_t i = 0; i < 100000; i++) {
+            expected[i] = 2 * i + 1;
+        }
+        FAIL(!linked_list_matches(ll, expected, 100000),
+             "linked_list contents wrong after filtering through an iterator")
+
+        // Put the even values back with insert_after, and check the tail by
+        // appending one more value.
+        //
+        SUBTEST(cursor_insert_after)
+        iter = linked_list_create_iterator(ll, 0);
+        do {
+            FAIL(linked_list_insert_after_iterator(iter, iter->data + 1) != true,
+                 "linked_list_insert_after_iterator() failed")
+            linked_list_iterate(iter);
+        } while (linked_list_iterate(iter));
+        linked_list_delete_iterator(iter);
+        linked_list_insert_end(ll, 200001);
+        for (size_t i = 0; i <= 200000; i++) {
+            expected[i] = i + 1;
+        }
+        FAIL(!linked_list_matches(ll, expected, 200001),
+             "linked_list contents wrong after inserting through an iterator")
+
+        // Merge the multiples of 3 in front of every matching value.
+        //
+        SUBTEST(cursor_insert_before)
+        iter = linked_list_create_iterator(ll, 0);
+        do {
+            if (iter->data % 3 == 0) {
+                size_t index = iter->current_index;
+                FAIL(linked_list_insert_before_iterator(iter, iter->data) != true,
+                     "linked_list_insert_before_iterator() failed")
+                FAIL(iter->current_index != index + 1,
+                     "linked_list_insert_before_iterator() did not move the index")
+            }
+        } while (linked_list_iterate(iter));
+        linked_list_delete_iterator(iter);
+        size_t size = 0;
+        for (size_t i = 1; i <= 200001; i++) {
+            if (i % 3 == 0) {
+                expected[size++] = i;
+            }
+            expected[size++] = i;
+        }
+        FAIL(!linked_list_matches(ll, expected, size),
+             "linked_list contents wrong after inserting before an iterator")
+
+        // Remove everything from the middle onwards, then append through the
+        // iterator that now points past the end.
+        //
+        SUBTEST(cursor_remove_to_end)
+        iter = linked_list_create_iterator(ll, size / 2);
+        while (linked_list_remove_at_iterator(iter)) {
+        }
+        FAIL(linked_list_size(ll) != size / 2 || iter->current_index != size / 2,
+             "Removing through an iterator up to the end left the wrong size")
+        FAIL(linked_list_insert_before_iterator(iter, 42) != true,
+             "linked_list_insert_before_iterator() failed past the end")
+        linked_list_insert_end(ll, 43);
+        expected[size / 2]     = 42;
+        expected[size / 2 + 1] = 43;
+        FAIL(!linked_list_matches(ll, expected, size / 2 + 2),
+             "linked_list contents wrong after appending through an iterator")
+        linked_list_delete_iterator(iter);
+
+        linked_list_delete(ll);
+    }
+
+    PASS(check_linked_list_cursor)
+#endif
+}
+
+void check_linked_list_bulk_insert(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_bulk_insert)
+
+    SUBTEST(bulk_insert_null)
+    unsigned int value = 7;
+    FAIL(linked_list_insert_end_n(NULL, &value, 1) != false,
+         "linked_list_insert_end_n(NULL, ...) did not return false")
+    FAIL(linked_list_insert_front_n(NULL, &value, 1) != false,
+         "linked_list_insert_front_n(NULL, ...) did not return false")
+    struct linked_list * ll = linked_list_create();
+    FAIL(linked_list_insert_end_n(ll, NULL, 1) != false,
+         "linked_list_insert_end_n(ll, NULL, 1) did not return false")
+    FAIL(linked_list_insert_end_n(ll, NULL, 0) != true ||
+         linked_list_insert_front_n(ll, NULL, 0) != true,
+         "Bulk inserting zero elements did not return true")
+    FAIL(linked_list_size(ll) != 0,
+         "Bulk inserting zero elements changed the size")
+    linked_list_delete(ll);
+
+    // Nodes, nodes with the positional index, unrolled, compact and doubly
+    // linked.
+    //
+    static unsigned int data[100000];
+    static unsigned int expected[300000];
+    for (size_t i = 0; i < 100000; i++) {
+        data[i] = i;
+    }
+    for (int variant = 0; variant < 5; variant++) {
+        ll = linked_list_create();
+        if (variant == 1) {
+            linked_list_enable_index(ll);
+        }
+        if (variant == 2) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+        }
+        if (variant == 3) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT);
+        }
+        if (variant == 4) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+        }
+
+        // Mix single and bulk inserts so that partially filled unrolled
+        // nodes and a non-empty free stack are both exercised.
+        //
+        SUBTEST(bulk_insert_mixed)
+        size_t size = 0;
+        linked_list_insert_end(ll, 1000000);
+        linked_list_insert_end(ll, 1000001);
+        linked_list_remove(ll, 1);
+        FAIL(linked_list_insert_end_n(ll, data, 5) != true,
+             "linked_list_insert_end_n() failed")
+        FAIL(linked_list_insert_front_n(ll, data + 5, 20) != true,
+             "linked_list_insert_front_n() failed")
+        FAIL(linked_list_insert_end_n(ll, data, 100000) != true,
+             "linked_list_insert_end_n() failed")
+        FAIL(linked_list_insert_front_n(ll, data, 100000) != true,
+             "linked_list_insert_front_n() failed")
+        for (size_t i = 0; i < 100000; i++) {
+            expected[size++] = i;
+        }
+        for (size_t i = 5; i < 25; i++) {
+            expected[size++] = i;
+        }
+        expected[size++] = 1000000;
+        for (size_t i = 0; i < 5; i++) {
+            expected[size++] = i;
+        }
+        for (size_t i = 0; i < 100000; i++) {
+            expected[size++] = i;
+        }
+        FAIL(!linked_list_matches(ll, expected, size),
+             "linked_list contents wrong after bulk inserts")
+        FAIL(linked_list_find(ll, 1000000) != 100020,
+             "linked_list_find() wrong after bulk inserts")
+
+        SUBTEST(bulk_insert_then_single)
+        linked_list_insert(ll, 100021, 42);
+        linked_list_remove(ll, 0);
+        memmove(expected + 100022, expected + 100021,
+                (size - 100021) * sizeof(unsigned int));
+        expected[100021] = 42;
+        memmove(expected, expected + 1, size * sizeof(unsigned int));
+        FAIL(!linked_list_matches(ll, expected, size),
+             "linked_list contents wrong after mixing bulk and single inserts")
+
+        SUBTEST(bulk_insert_alloc_fail)
+        linked_list_delete(ll);
+        ll = linked_list_create();
+        if (variant == 2) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+        }
+        if (variant == 3) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT);
+        }
+        if (variant == 4) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+        }
+        linked_list_insert_end(ll, 5);
+        instrumented_malloc_fail_next = true;
+        FAIL(linked_list_insert_end_n(ll, data, 100000) != false,
+             "linked_list_insert_end_n() did not fail when malloc failed")
+        expected[0] = 5;
+        FAIL(!linked_list_matches(ll, expected, 1),
+             "A failed linked_list_insert_end_n() changed the list")
+
+        linked_list_delete(ll);
+    }
+
+    PASS(check_linked_list_bulk_insert)
+#endif
+}
+
+void check_linked_list_iterate_batch(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_iterate_batch)
+
+    SUBTEST(iterate_batch_null)
+    unsigned int buf[64];
+    FAIL(linked_list_iterate_batch(NULL, buf, 64) != 0,
+         "linked_list_iterate_batch(NULL, ...) did not return 0")
+
+    // Nodes, unrolled, compact and doubly linked.
+    //
+    static unsigned int values[100000];
+    for (int variant = 0; variant < 4; variant++) {
+        struct linked_list * ll = linked_list_create();
+        if (variant == 1) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+        }
+        if (variant == 2) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT);
+        }
+        if (variant == 3) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+        }
+        for (size_t i = 0; i < 100000; i++) {
+            linked_list_insert_end(ll, i * 3);
+        }
+
+        // Odd batch sizes so that batches straddle unrolled nodes.
+        //
+        SUBTEST(iterate_batch_all)
+        struct iterator * iter = linked_list_create_iterator(ll, 7);
+        size_t read = 7;
+        size_t copied;
+        size_t batch = 1;
+        while ((copied = linked_list_iterate_batch(iter, values + read, batch)) != 0) {
+            read += copied;
+            FAIL(iter->current_index != read,
+                 "linked_list_iterate_batch() did not advance the iterator")
+            if (read < 100000) {
+                FAIL(iter->data != read * 3,
+                     "linked_list_iterate_batch() left the wrong current value")
+            }
+            batch = batch % 37 + 5;
+        }
+        FAIL(read != 100000,
+             "linked_list_iterate_batch() did not read up to the end")
+        for (size_t i = 7; i < 100000; i++) {
+            FAIL(values[i] != i * 3,
+                 "linked_list_iterate_batch() copied the wrong values")
+        }
+        FAIL(linked_list_iterate(iter) != false,
+             "linked_list_iterate() did not return false past the end")
+
+        // The iterator past the end still appends through the cursor API.
+        //
+        SUBTEST(iterate_batch_then_insert)
+        FAIL(linked_list_insert_before_iterator(iter, 1) != true,
+             "linked_list_insert_before_iterator() failed after a batch read")
+        linked_list_delete_iterator(iter);
+        FAIL(linked_list_find(ll, 1) != 100000,
+             "Inserting past the end after a batch read went wrong")
+
+        SUBTEST(iterate_batch_then_remove)
+        iter = linked_list_create_iterator(ll, 0);
+        FAIL(linked_list_iterate_batch(iter, buf, 64) != 64,
+             "linked_list_iterate_batch() copied the wrong count")
+        FAIL(linked_list_remove_at_iterator(iter) != true,
+             "linked_list_remove_at_iterator() failed after a batch read")
+        FAIL(iter->data != 65 * 3 || linked_list_find(ll, 64 * 3) != SIZE_MAX ||
+             linked_list_find(ll, 63 * 3) != 63,
+             "Removing after a batch read went wrong")
+        linked_list_delete_iterator(iter);
+
+        linked_list_delete(ll);
+    }
+
+    PASS(check_linked_list_iterate_batch)
+#endif
+}
+
+void check_linked_list_block_registry(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_block_registry)
+
+    // Many small reservations make the registry grow several times.
+    //
+    SUBTEST(registry_many_blocks)
+    struct linked_list * ll = linked_list_create();
+    for (size_t i = 0; i < 100; i++) {
+        FAIL(linked_list_reserve(ll, 1 + i % 3, false) != true,
+             "linked_list_reserve() failed")
+    }
+    FAIL(ll->blocks.count != 100,
+         "Every reservation should have registered one block")
+    for (size_t i = 0; i < 1000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+
+    SUBTEST(registry_remove_all_and_reuse)
+    FAIL(linked_list_remove_all(ll) != true,
+         "linked_list_remove_all() failed")
+    FAIL(ll->blocks.count != 0 || ll->free_stack != NULL,
+         "linked_list_remove_all() did not release every block")
+    static unsigned int expected[1000];
+    for (size_t i = 0; i < 1000; i++) {
+        linked_list_insert_front(ll, i);
+        expected[999 - i] = i;
+    }
+    FAIL(!linked_list_matches(ll, expected, 1000),
+         "linked_list contents wrong after reuse following remove_all")
+
+    SUBTEST(registry_alloc_fail)
+    size_t blocks = ll->blocks.count;
+    instrumented_malloc_fail_next = true;
+    FAIL(linked_list_reserve(ll, 100000, false) != false,
+         "linked_list_reserve() did not fail when malloc failed")
+    FAIL(ll->blocks.count != blocks,
+         "A failed allocation was recorded in the block registry")
+    linked_list_delete(ll);
+    PASS(check_linked_list_block_registry)
+#endif
+}
+
+void check_linked_list_node_pool(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_node_pool)
+
+    SUBTEST(pool_attach_rules)
+    struct node_pool * pool = node_pool_create();
+    FAIL(pool == NULL,
+         "node_pool_create() failed")
+    FAIL(linked_list_attach_pool(NULL, pool) != false,
+         "linked_list_attach_pool(NULL, ...) did not fail")
+    struct linked_list * a = linked_list_create();
+    struct linked_list * b = linked_list_create();
+    linked_list_insert_end(a, 1);
+    FAIL(linked_list_attach_pool(a, pool) != false,
+         "linked_list_attach_pool() accepted a non-empty linked_list")
+    linked_list_remove(a, 0);
+    FAIL(linked_list_attach_pool(a, pool) != true ||
+         linked_list_attach_pool(b, pool) != true,
+         "linked_list_attach_pool() failed")
+    FAIL(a->blocks.count != 0 || a->free_stack != NULL,
+         "Attaching to a node_pool did not release the private nodes")
+
+    // Nodes removed from one list are reused by the other.
+    //
+    SUBTEST(pool_shared_reuse)
+    for (size_t i = 0; i < 1000; i++) {
+        linked_list_insert_end(a, i);
+    }
+    size_t blocks = pool->blocks.count;
+    for (size_t i = 0; i < 1000; i++) {
+        linked_list_remove(a, 0);
+    }
+    linked_list_set_layout(b, LINKED_LIST_LAYOUT_UNROLLED);
+    linked_list_set_layout(b, LINKED_LIST_LAYOUT_NODES);
+    instrumented_malloc_fail_next = true;
+    static unsigned int expected[1000];
+    for (size_t i = 0; i < 1000; i++) {
+        FAIL(linked_list_insert_front(b, i) != true,
+             "Insertion into a pooled linked_list failed")
+        expected[999 - i] = i;
+    }
+    FAIL(instrumented_malloc_fail_next != true,
+         "Insertion called malloc() with free nodes in the node_pool")
+    instrumented_malloc_fail_next = false;
+    FAIL(pool->blocks.count != blocks || b->blocks.count != 0,
+         "Pooled linked_lists allocated blocks of their own")
+    FAIL(!linked_list_matches(b, expected, 1000),
+         "Pooled linked_list contents wrong")
+
+    // Deleting a list hands its nodes back to the pool.
+    //
+    SUBTEST(pool_delete_list)
+    linked_list_delete(b);
+    instrumented_malloc_fail_next = true;
+    for (size_t i = 0; i < 1000; i++) {
+        FAIL(linked_list_insert_end(a, i) != true,
+             "Insertion failed after another pooled list was deleted")
+    }
+    instrumented_malloc_fail_next = false;
+    FAIL(linked_list_size(a) != 1000 || linked_list_find(a, 999) != 999,
+         "Pooled linked_list contents wrong after reuse")
+
+    SUBTEST(pool_unrolled)
+    struct linked_list * c = linked_list_create();
+    linked_list_attach_pool(c, pool);
+    linked_list_set_layout(c, LINKED_LIST_LAYOUT_UNROLLED);
+    for (size_t i = 0; i < 1000; i++) {
+        linked_list_insert_end(c, i);
+    }
+    FAIL(c->blocks.count != 0 || linked_list_find(c, 500) != 500,
+         "Pooled unrolled linked_list went wrong")
+
+    // The pool outlives node_pool_delete() until its last list is gone.
+    //
+    SUBTEST(pool_deferred_delete)
+    FAIL(node_pool_delete(pool) != true,
+         "node_pool_delete() failed")
+    struct linked_list * late = linked_list_create();
+    FAIL(linked_list_attach_pool(late, pool) != false,
+         "linked_list_attach_pool() accepted a deleted node_pool")
+    linked_list_delete(late);
+    linked_list_delete(c);
+    FAIL(linked_list_attach_pool(a, NULL) != false,
+         "linked_list_attach_pool() detached a non-empty linked_list")
+    linked_list_remove_all(a);
+    FAIL(linked_list_attach_pool(a, NULL) != true || a->pool != NULL,
+         "linked_list_attach_pool(ll, NULL) did not detach")
+    linked_list_insert_end(a, 7);
+    FAIL(a->blocks.count != 1 || linked_list_find(a, 7) != 0,
+         "Detached linked_list did not go back to private allocation")
+    linked_list_delete(a);
+    PASS(check_linked_list_node_pool)
+#endif
+
+#ifdef TEST_QUEUE
+    TEST(check_queue_node_pool)
+    SUBTEST(queue_shared_pool)
+    struct node_pool * queue_pool = node_pool_create();
+    struct queue * q0 = queue_create();
+    struct queue * q1 = queue_create();
+    FAIL(queue_attach_pool(q0, queue_pool) != true ||
+         queue_attach_pool(q1, queue_pool) != true,
+         "queue_attach_pool() failed")
+    for (size_t i = 0; i < 100; i++) {
+        queue_push(q0, i);
+    }
+    unsigned int popped = 0;
+    for (size_t i = 0; i < 100; i++) {
+        FAIL(queue_pop(q0, &popped) != true || popped != i,
+             "queue_pop() from a pooled queue went wrong")
+        FAIL(queue_push(q1, popped) != true,
+             "queue_push() into a pooled queue failed")
+    }
+    FAIL(queue_size(q1) != 100 || queue_pool->blocks.count != 1,
+         "Pooled queues did not share their nodes")
+    node_pool_delete(queue_pool);
+    queue_delete(q0);
+    queue_delete(q1);
+    PASS(check_queue_node_pool)
+#endif
+}
+
+void check_linked_list_compact_functionality(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_compact_functionality)
+
+    SUBTEST(compact_set_layout)
+    FAIL(sizeof(struct compact_node) != 8,
+         "compact_node is not 8 bytes")
+    struct node_pool * pool = node_pool_create();
+    struct linked_list * ll = linked_list_create();
+    linked_list_attach_pool(ll, pool);
+    FAIL(linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT) != false,
+         "linked_list_set_layout() made a pooled linked_list compact")
+    linked_list_attach_pool(ll, NULL);
+    node_pool_delete(pool);
+    FAIL(linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT) != true,
+         "linked_list_set_layout() failed on an empty linked_list")
+    FAIL(linked_list_enable_index(ll) != false,
+         "linked_list_enable_index() accepted a compact linked_list")
+
+    // Same mix as the unrolled test; the arena moves several times while
+    // it grows.
+    //
+    SUBTEST(compact_random_operations)
+    static unsigned int expected[2048];
+    size_t size = 0;
+    unsigned int seed = 54321;
+    for (size_t op = 0; op < 6000; op++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned int choice = (seed >> 16) % 8;
+        unsigned int value  = seed >> 20;
+        if (size > 0 && (choice < 3 || size == 2048)) {
+            size_t index = (seed >> 8) % size;
+            FAIL(linked_list_remove(ll, index) != true,
+                 "linked_list_remove() failed on compact linked_list")
+            memmove(expected + index, expected + index + 1,
+                    (size - index - 1) * sizeof(unsigned int));
+            size--;
+        } else {
+            size_t index = (choice == 3) ? 0 :
+                           (choice == 4) ? size : (seed >> 8) % (size + 1);
+            FAIL(linked_list_insert(ll, index, value) != true,
+                 "linked_list_insert() failed on compact linked_list")
+            memmove(expected + index + 1, expected + index,
+                    (size - index) * sizeof(unsigned int));
+            expected[index] = value;
+            size++;
+        }
+    }
+    FAIL(!linked_list_matches(ll, expected, size),
+         "Compact linked_list contents differ from expected values")
+    FAIL(ll->arena.used > 2048,
+         "Compact linked_list did not recycle removed slots")
+
+    SUBTEST(compact_reserve)
+    FAIL(linked_list_reserve(ll, 100000, true) != true,
+         "linked_list_reserve() failed on compact linked_list")
+    instrumented_malloc_fail_next = true;
+    for (size_t i = 0; i < 100000; i++) {
+        FAIL(linked_list_insert_end(ll, i) != true,
+             "Insertion into reserved compact arena failed")
+    }
+    FAIL(instrumented_malloc_fail_next != true,
+         "Insertion into reserved compact arena called malloc()")
+    instrumented_malloc_fail_next = false;
+    FAIL(linked_list_find(ll, 99999) != size + 99999,
+         "linked_list_find() wrong on compact linked_list")
+
+    SUBTEST(compact_remove_all)
+    FAIL(linked_list_remove_all(ll) != true || ll->arena.nodes != NULL,
+         "linked_list_remove_all() did not release the compact arena")
+    FAIL(!linked_list_matches(ll, expected, 0),
+         "Compact linked_list not empty after linked_list_remove_all()")
+    linked_list_insert_front(ll, 3);
+    FAIL(linked_list_find(ll, 3) != 0,
+         "Compact linked_list wrong after reuse")
+    linked_list_delete(ll);
+    PASS(check_linked_list_compact_functionality)
+#endif
+
+#ifdef TEST_QUEUE
+    TEST(check_queue_compact)
+    SUBTEST(queue_compact_fifo)
+    struct queue * queue = queue_create();
+    FAIL(queue_set_layout(queue, LINKED_LIST_LAYOUT_COMPACT) != true,
+         "queue_set_layout() failed")
+    unsigned int popped = 0;
+    for (size_t i = 0; i < 10000; i++) {
+        queue_push(queue, i);
+        if (i % 3 == 0) {
+            FAIL(queue_next(queue, &popped) != true || popped != i / 3,
+                 "queue_next() on a compact queue went wrong")
+            FAIL(queue_pop(queue, &popped) != true || popped != i / 3,
+                 "queue_pop() on a compact queue went wrong")
+        }
+    }
+    FAIL(queue_size(queue) != 10000 - 3334,
+         "Compact queue has the wrong size")
+    queue_delete(queue);
+    PASS(check_queue_compact)
+#endif
+}
+
+void check_linked_list_lazy_blocks(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_lazy_blocks)
+
+    // A new block is carved on demand rather than pushed onto free_stack.
+    //
+    SUBTEST(lazy_first_block)
+    struct linked_list * ll = linked_list_create();
+    linked_list_insert_end(ll, 0);
+    FAIL(ll->blocks.count != 1 || ll->free_stack != NULL,
+         "The first block was linked into free_stack up front")
+    size_t carved = (struct node *)ll->carve.end - (struct node *)ll->carve.next;
+    FAIL(carved + 1 != ll->blocks.entries[0].nodes,
+         "The rest of the first block is not left to be carved")
+
+    // A reservation keeps the rest of the current block as a spare run,
+    // without touching its nodes, so both are used up before malloc() is
+    // called again.
+    //
+    SUBTEST(lazy_reserve_keeps_rest)
+    FAIL(linked_list_reserve(ll, 10, false) != true,
+         "linked_list_reserve() failed")
+    FAIL(ll->carve.spare == NULL || ll->free_stack == NULL || ll->free_stack->next != NULL,
+         "The rest of the current block was threaded onto free_stack")
+    instrumented_malloc_fail_next = true;
+    for (size_t i = 1; i <= carved + 10; i++) {
+        FAIL(linked_list_insert_front(ll, i) != true,
+             "Insertion into carved or reserved nodes failed")
+    }
+    FAIL(instrumented_malloc_fail_next != true,
+         "Insertion called malloc() with nodes left to carve")
+    FAIL(linked_list_insert_front(ll, 0) != false,
+         "Insertion past every carved node did not call malloc()")
+    instrumented_malloc_fail_next = false;
+    FAIL(linked_list_size(ll) != carved + 11 ||
+         linked_list_find(ll, carved + 10) != 0,
+         "linked_list contents wrong after carving")
+
+    SUBTEST(lazy_remove_all)
+    linked_list_remove_all(ll);
+    FAIL(ll->carve.next != NULL || ll->carve.end != NULL || ll->carve.spare != NULL,
+         "linked_list_remove_all() left a block to carve from")
+    linked_list_insert_end(ll, 1);
+    FAIL(linked_list_find(ll, 1) != 0,
+         "linked_list wrong after reuse following remove_all")
+
+    // Trimming releases blocks with a spare run in them.
+    //
+    SUBTEST(lazy_trim_spare)
+    linked_list_reserve(ll, 1000, false);
+    linked_list_remove(ll, 0);
+    FAIL(linked_list_trim(ll) != true || ll->blocks.count != 0 || ll->carve.spare != NULL,
+         "linked_list_trim() kept a block of spare nodes")
+    linked_list_insert_end(ll, 2);
+    FAIL(linked_list_find(ll, 2) != 0, "linked_list wrong after trimming a spare run")
+
+    SUBTEST(lazy_unrolled)
+    linked_list_remove_all(ll);
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+    for (size_t i = 0; i < 1000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    FAIL(ll->chunk_free_stack != NULL || ll->blocks.count != 1 ||
+         linked_list_find(ll, 999) != 999,
+         "Unrolled nodes were not carved from their block")
+    linked_list_delete(ll);
+    PASS(check_linked_list_lazy_blocks)
+#endif
+}
+
+void check_linked_list_trim(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_trim)
+
+    SUBTEST(trim_null)
+    FAIL(linked_list_trim(NULL) != false || node_pool_trim(NULL) != false,
+         "Trimming NULL did not return false")
+
+    // Removing from the front leaves only the newest block in use.
+    //
+    for (int layout = 0; layout < 2; layout++) {
+        SUBTEST(trim_drained_blocks)
+        struct linked_list * ll = linked_list_create();
+        linked_list_set_layout(ll, (enum linked_list_layout)layout);
+        for (size_t i = 0; i < 200000; i++) {
+            linked_list_insert_end(ll, i);
+        }
+        size_t blocks = ll->blocks.count;
+        for (size_t i = 0; i < 199990; i++) {
+            linked_list_remove(ll, 0);
+        }
+        struct iterator * iter = linked_list_create_iterator(ll, 3);
+        FAIL(linked_list_trim(ll) != true,
+             "linked_list_trim() failed")
+        FAIL(blocks < 2 || ll->blocks.count != 1,
+             "linked_list_trim() did not release the drained blocks")
+        FAIL(linked_list_iterate(iter) != true || iter->data != 199994,
+             "linked_list_trim() moved a live element")
+        linked_list_delete_iterator(iter);
+
+        SUBTEST(trim_then_insert)
+        for (size_t i = 0; i < 10000; i++) {
+            linked_list_insert_end(ll, 200000 + i);
+        }
+        FAIL(linked_list_size(ll) != 10010 || linked_list_find(ll, 209999) != 10009 ||
+             linked_list_find(ll, 199990) != 0,
+             "linked_list contents wrong after trimming")
+        linked_list_delete(ll);
+    }
+
+    SUBTEST(trim_compact)
+    struct linked_list * ll = linked_list_create();
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT);
+    for (size_t i = 0; i < 1000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    linked_list_remove(ll, 0);
+    FAIL(linked_list_trim(ll) != true || ll->arena.capacity != 1000,
+         "linked_list_trim() did not shrink the compact arena")
+    FAIL(linked_list_find(ll, 999) != 998,
+         "Compact linked_list wrong after trimming")
+    linked_list_remove_all(ll);
+    linked_list_insert_end(ll, 1);
+    linked_list_remove(ll, 0);
+    FAIL(linked_list_trim(ll) != true || ll->arena.nodes != NULL,
+         "linked_list_trim() did not free the arena of an empty compact list")
+    linked_list_delete(ll);
+
+    SUBTEST(trim_pool)
+    struct node_pool * pool = node_pool_create();
+    struct linked_list * a = linked_list_create();
+    struct linked_list * b = linked_list_create();
+    linked_list_attach_pool(a, pool);
+    linked_list_attach_pool(b, pool);
+    FAIL(linked_list_set_trim_policy(a, 2, 0) != false,
+         "linked_list_set_trim_policy() accepted a pooled linked_list")
+    linked_list_insert_end(a, 1);
+    for (size_t i = 0; i < 100000; i++) {
+        linked_list_insert_end(b, i);
+    }
+    linked_list_remove_all(b);
+    FAIL(node_pool_trim(pool) != true || pool->blocks.count != 1,
+         "node_pool_trim() did not release the unused blocks")
+    FAIL(linked_list_insert_end(b, 2) != true || linked_list_find(a, 1) != 0,
+         "Pooled linked_lists wrong after trimming")
+    linked_list_delete(a);
+    linked_list_delete(b);
+    node_pool_delete(pool);
+    PASS(check_linked_list_trim)
+#endif
+
+#ifdef TEST_QUEUE
+    TEST(check_queue_trim)
+
+    // A spike followed by a drain gives memory back without a manual call.
+    //
+    SUBTEST(queue_auto_trim)
+    struct queue * queue = queue_create();
+    FAIL(queue_set_trim_policy(queue, 4, 0) != true,
+         "queue_set_trim_policy() failed")
+    for (size_t i = 0; i < 500000; i++) {
+        queue_push(queue, i);
+    }
+    size_t peak = queue->ll.blocks.values;
+    unsigned int popped = 0;
+    for (size_t i = 0; i < 499000; i++) {
+        FAIL(queue_pop(queue, &popped) != true || popped != i,
+             "queue_pop() went wrong with automatic trimming")
+    }
+    FAIL(queue->ll.blocks.values * 2 > peak,
+         "Draining the queue did not trim it")
+    for (size_t i = 0; i < 1000; i++) {
+        FAIL(queue_pop(queue, &popped) != true || popped != 499000 + i,
+             "queue_pop() went wrong with automatic trimming")
+    }
+    FAIL(queue_trim(queue) != true || queue->ll.blocks.count != 0,
+         "queue_trim() did not release every block of an empty queue")
+    FAIL(queue_push(queue, 5) != true || queue_next(queue, &popped) != true || popped != 5,
+         "queue wrong after trimming")
+    queue_delete(queue);
+    PASS(check_queue_trim)
+#endif
+}
+
+// Churns a linked_list so that its nodes end up scattered over its blocks,
+// leaving the values expected[0..size) in it.
+//
+size_t churn_linked_list(struct linked_list * ll, unsigned int * expected) {
+    size_t size = 0;
+    unsigned int seed = 777;
+    for (size_t op = 0; op < 30000; op++) {
+        seed = seed * 1103515245u + 12345u;
+        if (size > 0 && (seed >> 16) % 3 == 0) {
+            size_t index = (seed >> 4) % size;
+            linked_list_remove(ll, index);
+            memmove(expected + index, expected + index + 1,
+                    (size - index - 1) * sizeof(unsigned int));
+            size--;
+        } else {
+            size_t index = (seed >> 4) % (size + 1);
+            linked_list_insert(ll, index, op);
+            memmove(expected + index + 1, expected + index,
+                    (size - index) * sizeof(unsigned int));
+            expected[index] = op;
+            size++;
+        }
+    }
+    return size;
+}
+
+void check_linked_list_compact(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_compact)
+
+    SUBTEST(compact_null)
+    FAIL(linked_list_compact(NULL) != false,
+         "linked_list_compact(NULL) did not return false")
+    FAIL(linked_list_compact_at_iterator(NULL, 1) != 0,
+         "linked_list_compact_at_iterator(NULL, 1) did not return 0")
+
+    // Nodes, nodes in a node_pool, unrolled, compact and doubly linked.
+    //
+    static unsigned int expected[30000];
+    for (int variant = 0; variant < 5; variant++) {
+        SUBTEST(compact_after_churn)
+        struct node_pool * pool = NULL;
+        struct linked_list * ll = linked_list_create();
+        if (variant == 1) {
+            pool = node_pool_create();
+            linked_list_attach_pool(ll, pool);
+        }
+        if (variant == 2) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+        }
+        if (variant == 3) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT);
+        }
+        if (variant == 4) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+        }
+        size_t size = churn_linked_list(ll, expected);
+        FAIL(linked_list_compact(ll) != true,
+             "linked_list_compact() failed")
+        FAIL(!linked_list_matches(ll, expected, size),
+             "linked_list_compact() changed the contents")
+        if (variant == 0) {
+            FAIL(ll->blocks.count != 1 || ll->free_stack != NULL,
+                 "linked_list_compact() did not release the old blocks")
+            struct node * curr = ll->head;
+            for (size_t i = 0; i < size; i++, curr = curr->next) {
+                FAIL(curr != ll->head + i,
+                     "linked_list_compact() did not lay nodes out in order")
+            }
+        }
+        if (variant == 2) {
+            FAIL(ll->blocks.count != 1 ||
+                 ll->chunk_head->count != LINKED_LIST_UNROLLED_CAPACITY,
+                 "linked_list_compact() did not pack unrolled nodes")
+        }
+        if (variant == 3) {
+            FAIL(ll->compact_head != 0 || ll->arena.used != size ||
+                 ll->arena.nodes[0].next != 1,
+                 "linked_list_compact() did not lay compact nodes out in order")
+        }
+
+        SUBTEST(compact_then_modify)
+        linked_list_insert(ll, 1, 12345);
+        linked_list_remove(ll, 0);
+        linked_list_insert_end(ll, 54321);
+        expected[0] = 12345;
+        expected[size] = 54321;
+        FAIL(!linked_list_matches(ll, expected, size + 1),
+             "linked_list wrong after modifying a compacted list")
+        linked_list_delete(ll);
+        if (pool != NULL) {
+            node_pool_delete(pool);
+        }
+    }
+
+    // Step through a churned list, with and without the positional index,
+    // and doubly linked.
+    //
+    for (int variant = 0; variant < 3; variant++) {
+        SUBTEST(compact_incremental)
+        struct linked_list * ll = linked_list_create();
+        if (variant == 1) {
+            linked_list_enable_index(ll);
+        }
+        if (variant == 2) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+        }
+        size_t size = churn_linked_list(ll, expected);
+        struct iterator * iter = linked_list_create_iterator(ll, 10);
+        size_t moved;
+        size_t total = 0;
+        while ((moved = linked_list_compact_at_iterator(iter, 1000)) != 0) {
+            total += moved;
+            FAIL(iter->current_index != 10 + total,
+                 "linked_list_compact_at_iterator() did not advance the iterator")
+        }
+        linked_list_delete_iterator(iter);
+        FAIL(total != size - 10,
+             "linked_list_compact_at_iterator() did not reach the end")
+        FAIL(!linked_list_matches(ll, expected, size),
+             "linked_list_compact_at_iterator() changed the contents")
+        linked_list_insert_end(ll, 1);
+        linked_list_remove(ll, size / 2);
+        memmove(expected + size / 2, expected + size / 2 + 1,
+                (size - size / 2 - 1) * sizeof(unsigned int));
+        expected[size - 1] = 1;
+        FAIL(!linked_list_matches(ll, expected, size),
+             "linked_list wrong after incremental compaction")
+        linked_list_delete(ll);
+    }
+    PASS(check_linked_list_compact)
+#endif
+}
+
+void check_linked_list_prefetch(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_prefetch)
+
+    SUBTEST(prefetch_null)
+    FAIL(linked_list_set_prefetch(NULL, 8) != false,
+         "linked_list_set_prefetch(NULL, 8) did not return false")
+
+    // Prefetching only changes timing, on scattered and compacted lists of
+    // every layout.
+    //
+    static unsigned int expected[30000];
+    for (int layout = 0; layout < 4; layout++) {
+        SUBTEST(prefetch_same_results)
+        struct linked_list * ll = linked_list_create();
+        linked_list_set_layout(ll, (enum linked_list_layout)layout);
+        FAIL(linked_list_set_prefetch(ll, 8) != true ||
+             ll->prefetch_distance != 8,
+             "linked_list_set_prefetch() failed")
+        size_t size = churn_linked_list(ll, expected);
+        for (int pass = 0; pass < 2; pass++) {
+            FAIL(!linked_list_matches(ll, expected, size),
+                 "linked_list wrong with prefetching on")
+            for (size_t i = 0; i < size; i += 97) {
+                size_t index = linked_list_find(ll, expected[i]);
+                FAIL(index > i || expected[index] != expected[i],
+                     "linked_list_find() wrong with prefetching on")
+            }
+            FAIL(linked_list_find(ll, 1u << 30) != SIZE_MAX,
+                 "linked_list_find() found a missing value")
+            linked_list_compact(ll);
+        }
+
+        SUBTEST(prefetch_remove_front)
+        for (size_t i = 0; i < size; i++) {
+            struct iterator * iter = linked_list_create_iterator(ll, 0);
+            FAIL(iter == NULL || iter->data != expected[i],
+                 "Front wrong while removing with prefetching on")
+            linked_list_delete_iterator(iter);
+            FAIL(linked_list_remove(ll, 0) != true,
+                 "linked_list_remove() failed with prefetching on")
+        }
+        FAIL(linked_list_size(ll) != 0, "linked_list not empty")
+        linked_list_delete(ll);
+    }
+    PASS(check_linked_list_prefetch)
+#endif
+
+#ifdef TEST_QUEUE
+    TEST(check_queue_prefetch)
+
+    SUBTEST(queue_prefetch_fifo)
+    FAIL(queue_set_prefetch(NULL, 8) != false,
+         "queue_set_prefetch(NULL, 8) did not return false")
+    struct queue * queue = queue_create();
+    FAIL(queue_set_prefetch(queue, 8) != true,
+         "queue_set_prefetch() failed")
+    unsigned int popped = 0;
+    for (size_t round = 0; round < 3; round++) {
+        for (size_t i = 0; i < 10000; i++) {
+            queue_push(queue, i);
+        }
+        for (size_t i = 0; i < 10000; i++) {
+            FAIL(queue_pop(queue, &popped) != true || popped != i,
+                 "queue_pop() wrong with prefetching on")
+        }
+    }
+    queue_delete(queue);
+    PASS(check_queue_prefetch)
+#endif
+}
+
+void check_linked_list_doubly(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_doubly)
+
+    SUBTEST(doubly_null)
+    FAIL(linked_list_remove_end(NULL) != false,
+         "linked_list_remove_end(NULL) did not return false")
+    FAIL(linked_list_remove_node(NULL, NULL) != false,
+         "linked_list_remove_node(NULL, NULL) did not return false")
+    FAIL(linked_list_iterate_reverse(NULL) != false,
+         "linked_list_iterate_reverse(NULL) did not return false")
+
+    SUBTEST(doubly_layout_rules)
+    struct linked_list * ll = linked_list_create();
+    linked_list_insert_end(ll, 1);
+    linked_list_insert_end(ll, 2);
+    struct iterator * iter = linked_list_create_iterator(ll, 1);
+    FAIL(linked_list_iterate_reverse(iter) != false,
+         "linked_list_iterate_reverse() worked on a singly linked list")
+    linked_list_delete_iterator(iter);
+    FAIL(linked_list_remove_node(ll, ll->head) != false,
+         "linked_list_remove_node() worked on a singly linked list")
+    FAIL(linked_list_remove_end(ll) != true || linked_list_remove_end(ll) != true ||
+         linked_list_remove_end(ll) != false,
+         "linked_list_remove_end() wrong on a singly linked list")
+    FAIL(linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY) != true,
+         "linked_list_set_layout() failed")
+    struct node_pool * pool = node_pool_create();
+    FAIL(linked_list_attach_pool(ll, pool) != false,
+         "A doubly linked list was attached to a node_pool")
+    node_pool_delete(pool);
+    linked_list_delete(ll);
+
+    // Random operations, removals at the tail included.
+    //
+    SUBTEST(doubly_random_operations)
+    static unsigned int expected[200000];
+    ll = linked_list_create();
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+    size_t size = 0;
+    unsigned int seed = 4242;
+    for (size_t op = 0; op < 20000; op++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned int choice = (seed >> 16) % 4;
+        if (size > 0 && choice == 0) {
+            FAIL(linked_list_remove_end(ll) != true,
+                 "linked_list_remove_end() failed")
+            size--;
+        } else if (size > 0 && choice == 1) {
+            size_t index = (seed >> 4) % size;
+            linked_list_remove(ll, index);
+            memmove(expected + index, expected + index + 1,
+                    (size - index - 1) * sizeof(unsigned int));
+            size--;
+        } else {
+            size_t index = (seed >> 4) % (size + 1);
+            linked_list_insert(ll, index, op);
+            memmove(expected + index + 1, expected + index,
+                    (size - index) * sizeof(unsigned int));
+            expected[index] = op;
+            size++;
+        }
+    }
+    FAIL(!linked_list_matches(ll, expected, size),
+         "Doubly linked list wrong after random operations")
+
+    // Every value walked backwards from past the end.
+    //
+    SUBTEST(doubly_iterate_reverse)
+    iter = linked_list_create_iterator(ll, size - 1);
+    FAIL(linked_list_remove_at_iterator(iter) != true ||
+         iter->current_index != size - 1 || iter->current_node != NULL,
+         "linked_list_remove_at_iterator() did not move past the end")
+    size--;
+    for (size_t i = size; i > 0; i--) {
+        FAIL(linked_list_iterate_reverse(iter) != true ||
+             iter->current_index != i - 1 || iter->data != expected[i - 1],
+             "linked_list_iterate_reverse() went wrong")
+    }
+    FAIL(linked_list_iterate_reverse(iter) != false,
+         "linked_list_iterate_reverse() moved before the head")
+    FAIL(linked_list_remove_at_iterator(iter) != true,
+         "linked_list_remove_at_iterator() failed after iterating backwards")
+    memmove(expected, expected + 1, (size - 1) * sizeof(unsigned int));
+    size--;
+    linked_list_delete_iterator(iter);
+    FAIL(!linked_list_matches(ll, expected, size),
+         "Doubly linked list wrong after iterating backwards")
+
+    // Drop every odd value through its node.
+    //
+    SUBTEST(doubly_remove_node)
+    size_t kept = 0;
+    struct node * curr = ll->head;
+    while (curr != NULL) {
+        struct node * next = curr->next;
+        if (curr->data % 2 == 1) {
+            FAIL(linked_list_remove_node(ll, curr) != true,
+                 "linked_list_remove_node() failed")
+        }
+        curr = next;
+    }
+    for (size_t i = 0; i < size; i++) {
+        if (expected[i] % 2 == 0) {
+            expected[kept++] = expected[i];
+        }
+    }
+    size = kept;
+    FAIL(!linked_list_matches(ll, expected, size),
+         "Doubly linked list wrong after linked_list_remove_node()")
+    while (size > 0) {
+        FAIL(linked_list_remove_node(ll, ll->tail) != true,
+             "linked_list_remove_node() failed at the tail")
+        size--;
+        FAIL(size % 1000 == 0 && !linked_list_matches(ll, expected, size),
+             "Doubly linked list wrong while removing the tail")
+    }
+    FAIL(ll->head != NULL || ll->tail != NULL,
+         "Doubly linked list not empty")
+
+    // Used as a stack at the tail: a singly linked list would walk the
+    // whole list on every pop and run into the timeout.
+    //
+    SUBTEST(doubly_remove_end)
+    for (size_t i = 0; i < 200000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    for (size_t i = 200000; i > 0; i--) {
+        FAIL(ll->tail->data != i - 1 || linked_list_remove_end(ll) != true,
+             "linked_list_remove_end() went wrong")
+    }
+    FAIL(linked_list_size(ll) != 0, "Doubly linked list not empty")
+    linked_list_delete(ll);
+    PASS(check_linked_list_doubly)
+#endif
+
+#ifdef TEST_QUEUE
+    TEST(check_queue_doubly)
+
+    SUBTEST(queue_doubly_fifo)
+    struct queue * queue = queue_create();
+    FAIL(queue_set_layout(queue, LINKED_LIST_LAYOUT_DOUBLY) != true,
+         "queue_set_layout() failed")
+    unsigned int popped = 0;
+    for (size_t i = 0; i < 10000; i++) {
+        queue_push(queue, i);
+    }
+    for (size_t i = 0; i < 10000; i++) {
+        FAIL(queue_pop(queue, &popped) != true || popped != i,
+             "queue_pop() wrong on a doubly linked queue")
+    }
+    FAIL(queue->ll.head != NULL || queue->ll.tail != NULL,
+         "Doubly linked queue not empty")
+    queue_delete(queue);
+    PASS(check_queue_doubly)
+#endif
+}
+
+int compare_unsigned(const void * a, const void * b) {
+    unsigned int x = *(const unsigned int *)a;
+    unsigned int y = *(const unsigned int *)b;
+    return (x > y) - (x < y);
+}
+
+// A node and its position in the list before sorting.
+//
+struct node_rank {
+    const struct node * node;
+    size_t rank;
+};
+
+int compare_node_rank(const void * a, const void * b) {
+    const struct node * x = ((const struct node_rank *)a)->node;
+    const struct node * y = ((const struct node_rank *)b)->node;
+    return (x > y) - (x < y);
+}
+
+void check_linked_list_sort(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_sort)
+
+    SUBTEST(sort_null)
+    FAIL(linked_list_sort(NULL, false) != false,
+         "linked_list_sort(NULL, false) did not return false")
+
+    // Nodes, nodes with the positional index, unrolled, compact and doubly
+    // linked. The sizes go through the merge sort, the radix sort and its
+    // wide digits; half the lists are full of duplicates.
+    //
+    static const size_t sizes[] = {0, 1, 2, 300, 5000, 300000};
+    static unsigned int expected[300001];
+    static struct node_rank ranks[300000];
+    for (int variant = 0; variant < 5; variant++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            for (int duplicates = 0; duplicates < 2; duplicates++) {
+                SUBTEST(sort_random)
+                struct linked_list * ll = linked_list_create();
+                if (variant == 1) {
+                    linked_list_enable_index(ll);
+                }
+                if (variant == 2) {
+                    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+                }
+                if (variant == 3) {
+                    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT);
+                }
+                if (variant == 4) {
+                    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+                }
+                size_t size = sizes[s];
+                unsigned int seed = 99 + s;
+                for (size_t i = 0; i < size; i++) {
+                    seed = seed * 1103515245u + 12345u;
+                    expected[i] = duplicates ? (seed >> 16) % 50 : seed;
+                    linked_list_insert_end(ll, expected[i]);
+                }
+                qsort(expected, size, sizeof(unsigned int), compare_unsigned);
+
+                bool nodes = (variant != 2 && variant != 3);
+                if (nodes) {
+                    size_t i = 0;
+                    for (struct node * curr = ll->head; curr != NULL; curr = curr->next, i++) {
+                        ranks[i].node = curr;
+                        ranks[i].rank = i;
+                    }
+                    qsort(ranks, size, sizeof(struct node_rank), compare_node_rank);
+                }
+
+                FAIL(linked_list_sort(ll, false) != true,
+                     "linked_list_sort() failed")
+                FAIL(!linked_list_matches(ll, expected, size),
+                     "linked_list_sort() did not sort")
+
+                // Equal values keep their order.
+                //
+                if (nodes && duplicates) {
+                    size_t last_rank = 0;
+                    const struct node * prev = NULL;
+                    for (const struct node * curr = ll->head; curr != NULL; curr = curr->next) {
+                        struct node_rank key = {curr, 0};
+                        struct node_rank * found = bsearch(&key, ranks, size, sizeof(struct node_rank),
+                                                           compare_node_rank);
+                        FAIL(found == NULL, "linked_list_sort() lost a node")
+                        FAIL(prev != NULL && prev->data == curr->data && found->rank < last_rank,
+                             "linked_list_sort() is not stable")
+                        last_rank = found->rank;
+                        prev = curr;
+                    }
+                }
+
+                // The tail is right afterwards.
+                //
+                linked_list_insert_end(ll, 7);
+                expected[size] = 7;
+                FAIL(!linked_list_matches(ll, expected, size + 1),
+                     "linked_list wrong after sorting and inserting")
+                linked_list_delete(ll);
+            }
+        }
+    }
+
+    // Sorting and compacting lays the nodes out in order.
+    //
+    SUBTEST(sort_compact)
+    struct linked_list * ll = linked_list_create();
+    size_t size = churn_linked_list(ll, expected);
+    qsort(expected, size, sizeof(unsigned int), compare_unsigned);
+    FAIL(linked_list_sort(ll, true) != true,
+         "linked_list_sort() failed to compact")
+    FAIL(!linked_list_matches(ll, expected, size),
+         "linked_list_sort() did not sort")
+    FAIL(ll->blocks.count != 1, "linked_list_sort() did not compact")
+    struct node * curr = ll->head;
+    for (size_t i = 0; i < size; i++, curr = curr->next) {
+        FAIL(curr != ll->head + i,
+             "linked_list_sort() did not lay nodes out in order")
+    }
+    linked_list_delete(ll);
+
+    SUBTEST(sort_alloc_fail)
+    ll = linked_list_create();
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+    for (size_t i = 0; i < 100; i++) {
+        expected[i] = 100 - i;
+        linked_list_insert_end(ll, expected[i]);
+    }
+    instrumented_malloc_fail_next = true;
+    FAIL(linked_list_sort(ll, false) != false,
+         "linked_list_sort() did not fail when malloc failed")
+    FAIL(!linked_list_matches(ll, expected, 100),
+         "A failed linked_list_sort() changed the list")
+    linked_list_delete(ll);
+    PASS(check_linked_list_sort)
+#endif
+}
+
+// Creates an empty linked_list for the variants of check_linked_list_splice:
+// nodes, nodes with the positional index, unrolled and doubly linked.
+//
+struct linked_list * create_splice_variant(int variant) {
+    struct linked_list * ll = linked_list_create();
+    if (variant == 1) {
+        linked_list_enable_index(ll);
+    }
+    if (variant == 2) {
+        linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+    }
+    if (variant == 3) {
+        linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+    }
+    return ll;
+}
+
+// Returns the number of nodes on the free stack of a private ll, or
+// SIZE_MAX if the stack does not end at its recorded bottom.
+size_t free_stack_length(struct linked_list * ll) {
+    size_t length = 0;
+    if (ll->layout == LINKED_LIST_LAYOUT_UNROLLED) {
+        struct unrolled_node * last = NULL;
+        for (struct unrolled_node * chunk = ll->chunk_free_stack; chunk != NULL; chunk = chunk->next) {
+            last = chunk;
+            length++;
+        }
+        return (last == NULL || last == ll->chunk_free_stack_bottom) ? length : SIZE_MAX;
+    }
+    struct node * last = NULL;
+    for (struct node * node = ll->free_stack; node != NULL; node = node->next) {
+        last = node;
+        length++;
+    }
+    return (last == NULL || last == ll->free_stack_bottom) ? length : SIZE_MAX;
+}
+
+void check_linked_list_splice(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_splice)
+
+    SUBTEST(splice_null)
+    struct linked_list * a = linked_list_create();
+    FAIL(linked_list_concat(NULL, a) != false || linked_list_concat(a, NULL) != false,
+         "linked_list_concat() with NULL did not return false")
+    FAIL(linked_list_splice(a, NULL, a) != false,
+         "linked_list_splice() with NULL did not return false")
+    FAIL(linked_list_split_at(NULL) != NULL,
+         "linked_list_split_at(NULL) did not return NULL")
+
+    SUBTEST(splice_rules)
+    struct linked_list * b = linked_list_create();
+    linked_list_insert_end(a, 1);
+    linked_list_insert_end(b, 2);
+    FAIL(linked_list_concat(a, a) != false,
+         "linked_list_concat() accepted the same list twice")
+    linked_list_remove_all(b);
+    linked_list_set_layout(b, LINKED_LIST_LAYOUT_UNROLLED);
+    linked_list_insert_end(b, 2);
+    FAIL(linked_list_concat(a, b) != false,
+         "linked_list_concat() accepted lists with different layouts")
+    linked_list_remove_all(a);
+    linked_list_remove_all(b);
+    linked_list_set_layout(a, LINKED_LIST_LAYOUT_COMPACT);
+    linked_list_set_layout(b, LINKED_LIST_LAYOUT_COMPACT);
+    linked_list_insert_end(a, 1);
+    linked_list_insert_end(b, 2);
+    FAIL(linked_list_concat(a, b) != false,
+         "linked_list_concat() accepted compact lists")
+    struct iterator * iter = linked_list_create_iterator(a, 0);
+    FAIL(linked_list_split_at(iter) != NULL,
+         "linked_list_split_at() split a compact list")
+    linked_list_delete_iterator(iter);
+    linked_list_remove_all(a);
+    linked_list_remove_all(b);
+    linked_list_set_layout(a, LINKED_LIST_LAYOUT_NODES);
+    linked_list_set_layout(b, LINKED_LIST_LAYOUT_NODES);
+    struct node_pool * pool = node_pool_create();
+    linked_list_attach_pool(b, pool);
+    linked_list_insert_end(a, 1);
+    linked_list_insert_end(b, 2);
+    FAIL(linked_list_concat(a, b) != false,
+         "linked_list_concat() took nodes from a node_pool into a private list")
+    FAIL(!linked_list_matches(a, (unsigned int[]){1}, 1) ||
+         !linked_list_matches(b, (unsigned int[]){2}, 1),
+         "A refused linked_list_concat() changed the lists")
+
+    // A private list handed over to a pooled one gives its blocks to the
+    // pool.
+    //
+    SUBTEST(concat_into_pool)
+    linked_list_remove_all(a);
+    for (unsigned int i = 3; i < 1000; i++) {
+        linked_list_insert_end(a, i);
+    }
+    size_t blocks = pool->blocks.count;
+    FAIL(linked_list_concat(b, a) != true,
+         "linked_list_concat() into a pooled list failed")
+    FAIL(pool->blocks.count != blocks + 1 || a->blocks.count != 0 ||
+         linked_list_size(a) != 0 || linked_list_size(b) != 998 ||
+         linked_list_find(b, 999) != 997,
+         "linked_list_concat() into a pooled list went wrong")
+    linked_list_delete(a);
+    node_pool_delete(pool);
+    linked_list_delete(b);
+
+    // Free stacks are joined through their bottoms, and the joined stack
+    // can be passed on again.
+    //
+    SUBTEST(concat_free_stacks)
+    for (int variant = 0; variant < 4; variant++) {
+        a = create_splice_variant(variant);
+        b = create_splice_variant(variant);
+        struct linked_list * c = create_splice_variant(variant);
+        for (unsigned int i = 0; i < 1000; i++) {
+            linked_list_insert_end(a, i);
+            linked_list_insert_end(b, i);
+            linked_list_insert_end(c, i);
+        }
+        for (size_t i = 0; i < 300; i++) {
+            linked_list_remove(a, 0);
+            linked_list_remove(b, 0);
+            linked_list_remove(b, linked_list_size(b) - 1);
+        }
+        size_t cached = free_stack_length(a) + free_stack_length(b);
+        FAIL(free_stack_length(a) == 0 || free_stack_length(a) == SIZE_MAX ||
+             free_stack_length(b) == SIZE_MAX,
+             "Free stack does not end at its bottom")
+        FAIL(linked_list_concat(c, a) != true || linked_list_concat(c, b) != true,
+             "linked_list_concat() failed")
+        FAIL(free_stack_length(c) != cached,
+             "linked_list_concat() did not join the free stacks")
+        FAIL(linked_list_trim(c) != true || free_stack_length(c) == SIZE_MAX,
+             "linked_list_trim() lost the bottom of the free stack")
+        cached = free_stack_length(c);
+        FAIL(linked_list_concat(a, c) != true || free_stack_length(a) != cached,
+             "Joined free stack could not be passed on")
+        FAIL(linked_list_size(a) != 2100, "linked_list_concat() lost elements")
+        for (unsigned int i = 0; i < 5000; i++) {
+            linked_list_insert_end(a, i);
+        }
+        FAIL(linked_list_size(a) != 7100 || free_stack_length(a) != 0,
+             "Joined free stack not reused")
+        linked_list_delete(a);
+        linked_list_delete(b);
+        linked_list_delete(c);
+    }
+
+    static unsigned int expected[5000];
+    static unsigned int scratch[5000];
+    for (int variant = 0; variant < 4; variant++) {
+        // The free nodes of the source come along with its elements.
+        //
+        SUBTEST(concat_private)
+        a = create_splice_variant(variant);
+        b = create_splice_variant(variant);
+        for (unsigned int i = 0; i < 3000; i++) {
+            linked_list_insert_end(a, i);
+            expected[i] = i;
+        }
+        for (unsigned int i = 2900; i < 5000; i++) {
+            linked_list_insert_end(b, i);
+            expected[i] = i;
+        }
+        for (size_t i = 0; i < 100; i++) {
+            linked_list_remove(b, 0);
+        }
+        FAIL(linked_list_concat(a, b) != true,
+             "linked_list_concat() failed")
+        FAIL(!linked_list_matches(a, expected, 5000),
+             "linked_list_concat() did not append every element")
+        FAIL(!linked_list_matches(b, expected, 0) || b->blocks.count != 0 ||
+             b->free_stack != NULL || b->chunk_free_stack != NULL,
+             "linked_list_concat() left storage in the source")
+        for (unsigned int i = 0; i < 5; i++) {
+            linked_list_insert_end(b, i);
+        }
+        FAIL(!linked_list_matches(b, expected, 5),
+             "Emptied linked_list unusable after linked_list_concat()")
+        linked_list_delete(b);
+
+        // Split at random positions and splice the second half back in
+        // front of a random element of the first.
+        //
+        SUBTEST(split_and_splice)
+        size_t size = 5000;
+        unsigned int seed = 17 + variant;
+        for (size_t round = 0; round < 40; round++) {
+            seed = seed * 1103515245u + 12345u;
+            size_t k = (seed >> 4) % size;
+            iter = linked_list_create_iterator(a, k);
+            struct linked_list * rest = linked_list_split_at(iter);
+            FAIL(rest == NULL, "linked_list_split_at() failed")
+            FAIL(iter->current_index != k || linked_list_iterate(iter) != false,
+                 "linked_list_split_at() left the iterator in the list")
+            linked_list_delete_iterator(iter);
+            FAIL(!linked_list_matches(a, expected, k) ||
+                 !linked_list_matches(rest, expected + k, size - k),
+                 "linked_list_split_at() halves wrong")
+            FAIL(a->pool != NULL || rest->pool != NULL || rest->index != NULL ||
+                 (size > k && rest->blocks.count != 1),
+                 "linked_list_split_at() halves are not private")
+
+            if (k == 0) {
+                FAIL(linked_list_concat(a, rest) != true,
+                     "linked_list_concat() of split halves failed")
+                linked_list_delete(rest);
+                continue;
+            }
+            size_t j = (seed >> 16) % k;
+            iter = linked_list_create_iterator(a, j);
+            memcpy(scratch, expected, j * sizeof(unsigned int));
+            memcpy(scratch + j, expected + k, (size - k) * sizeof(unsigned int));
+            memcpy(scratch + j + size - k, expected + j, (k - j) * sizeof(unsigned int));
+            memcpy(expected, scratch, size * sizeof(unsigned int));
+
+            FAIL(linked_list_splice(a, iter, rest) != true,
+                 "linked_list_splice() failed")
+            FAIL(iter->current_index != j + size - k || iter->data != expected[j + size - k],
+                 "linked_list_splice() moved the iterator off its element")
+            linked_list_delete_iterator(iter);
+            FAIL(!linked_list_matches(a, expected, size) || linked_list_size(rest) != 0,
+                 "linked_list_splice() result wrong")
+            linked_list_delete(rest);
+        }
+
+        // Split halves keep their policies working.
+        //
+        SUBTEST(split_private)
+        iter = linked_list_create_iterator(a, 2500);
+        struct linked_list * half = linked_list_split_at(iter);
+        linked_list_delete_iterator(iter);
+        FAIL(linked_list_set_trim_policy(a, 2, 0) != true ||
+             linked_list_set_trim_policy(half, 2, 0) != true,
+             "Trim policy refused after linked_list_split_at()")
+        FAIL(linked_list_trim(a) != true || !linked_list_matches(a, expected, 2500),
+             "linked_list_trim() wrong after linked_list_split_at()")
+        if (variant == 0) {
+            FAIL(linked_list_set_adaptive(half, true) != true, "linked_list_set_adaptive() failed")
+            for (unsigned int i = 0; i < 3000; i++) {
+                linked_list_insert_end(half, i);
+            }
+            FAIL(half->layout != LINKED_LIST_LAYOUT_COMPACT,
+                 "Split half did not switch layout")
+            for (unsigned int i = 0; i < 3000; i++) {
+                linked_list_remove_end(half);
+            }
+            FAIL(linked_list_set_adaptive(half, false) != true, "linked_list_set_adaptive() failed")
+        }
+        linked_list_delete(a);
+        FAIL(!linked_list_matches(half, expected + 2500, size - 2500),
+             "Split half depends on the original")
+        a = half;
+        linked_list_set_trim_policy(a, 0, 0);
+        for (size_t i = 2500; i > 0; i--) {
+            linked_list_insert_front(a, expected[i - 1]);
+        }
+
+        // Splicing at an iterator past the end appends.
+        //
+        SUBTEST(splice_past_end)
+        iter = linked_list_create_iterator(a, 1000);
+        struct linked_list * rest = linked_list_split_at(iter);
+        FAIL(linked_list_splice(a, iter, rest) != true,
+             "linked_list_splice() past the end failed")
+        FAIL(!linked_list_matches(a, expected, size),
+             "linked_list_splice() past the end did not append")
+        linked_list_delete_iterator(iter);
+        linked_list_delete(rest);
+        linked_list_insert(a, 1, 77);
+        linked_list_remove(a, size);
+        memmove(expected + 2, expected + 1, (size - 2) * sizeof(unsigned int));
+        expected[1] = 77;
+        FAIL(!linked_list_matches(a, expected, size),
+             "linked_list wrong after splicing and modifying it")
+        linked_list_delete(a);
+    }
+
+    SUBTEST(split_alloc_fail)
+    a = linked_list_create();
+    for (unsigned int i = 0; i < 10; i++) {
+        linked_list_insert_end(a, i);
+        expected[i] = i;
+    }
+    iter = linked_list_create_iterator(a, 5);
+    instrumented_malloc_fail_next = true;
+    FAIL(linked_list_split_at(iter) != NULL,
+         "linked_list_split_at() did not fail when malloc failed")
+    instrumented_malloc_fail_next = false;
+    FAIL(!linked_list_matches(a, expected, 10) || iter->current_index != 5,
+         "A failed linked_list_split_at() changed the list")
+    linked_list_delete_iterator(iter);
+    linked_list_delete(a);
+    PASS(check_linked_list_splice)
+#endif
+
+#ifdef TEST_QUEUE
+    TEST(check_queue_concat)
+    SUBTEST(queue_concat_fifo)
+    struct queue * q0 = queue_create();
+    struct queue * q1 = queue_create();
+    for (unsigned int i = 0; i < 200; i++) {
+        queue_push(i < 100 ? q0 : q1, i);
+    }
+    FAIL(queue_concat(q0, NULL) != false || queue_concat(q0, q1) != true,
+         "queue_concat() went wrong")
+    FAIL(queue_size(q0) != 200 || queue_size(q1) != 0,
+         "queue_concat() did not move every entry")
+    unsigned int popped = 0;
+    for (unsigned int i = 0; i < 200; i++) {
+        FAIL(queue_pop(q0, &popped) != true || popped != i,
+             "queue_concat() entries popped out of order")
+    }
+    queue_delete(q0);
+    queue_delete(q1);
+    PASS(check_queue_concat)
+#endif
+}
+
+// Position of the first occurrence of data in expected, SIZE_MAX if none.
+//
+size_t expected_find(const unsigned int * expected, size_t size, unsigned int data) {
+    for (size_t i = 0; i < size; i++) {
+        if (expected[i] == data) {
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+
+void check_linked_list_hash_index(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_hash_index)
+
+    SUBTEST(hash_index_null)
+    FAIL(linked_list_enable_hash_index(NULL) != false ||
+         linked_list_disable_hash_index(NULL) != false,
+         "Hash index functions did not fail on NULL")
+    FAIL(linked_list_contains(NULL, 0) != false,
+         "linked_list_contains(NULL, 0) did not return false")
+
+    SUBTEST(hash_index_layout_rules)
+    struct linked_list * ll = linked_list_create();
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+    FAIL(linked_list_enable_hash_index(ll) != false,
+         "linked_list_enable_hash_index() accepted an unrolled list")
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_NODES);
+    FAIL(linked_list_enable_hash_index(ll) != true,
+         "linked_list_enable_hash_index() failed")
+    FAIL(linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT) != false,
+         "linked_list_set_layout() dropped the hash index")
+    FAIL(linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY) != true,
+         "linked_list_set_layout() to doubly linked failed with a hash index")
+    linked_list_delete(ll);
+
+    // Random operations through every entry point, duplicates included;
+    // the index is enabled on a non-empty list halfway through.
+    //
+    static unsigned int expected[20000];
+    static unsigned int batch[16];
+    for (int doubly = 0; doubly < 2; doubly++) {
+        SUBTEST(hash_index_random_operations)
+        ll = linked_list_create();
+        if (doubly) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+        }
+        size_t size = 0;
+        unsigned int seed = 777 + doubly;
+        for (size_t op = 0; op < 40000; op++) {
+            if (op == 1000) {
+                FAIL(linked_list_enable_hash_index(ll) != true,
+                     "linked_list_enable_hash_index() failed on a non-empty list")
+            }
+            seed = seed * 1103515245u + 12345u;
+            unsigned int choice = (seed >> 16) % 12;
+            unsigned int value = (seed >> 4) % 300;
+            size_t index = (seed >> 8) % (size + 1);
+            if (size > 0 && choice < 2) {
+                linked_list_remove(ll, 0);
+                memmove(expected, expected + 1, (size - 1) * sizeof(unsigned int));
+                size--;
+            } else if (size > 0 && choice == 2) {
+                linked_list_remove_end(ll);
+                size--;
+            } else if (size > 0 && choice == 3) {
+                index %= size;
+                if (doubly) {
+                    struct node * node = ll->head;
+                    for (size_t i = 0; i < index; i++) {
+                        node = node->next;
+                    }
+                    linked_list_remove_node(ll, node);
+                } else {
+                    linked_list_remove(ll, index);
+                }
+                memmove(expected + index, expected + index + 1,
+                        (size - index - 1) * sizeof(unsigned int));
+                size--;
+            } else if (size > 0 && choice == 4) {
+                index %= size;
+                struct iterator * iter = linked_list_create_iterator(ll, index);
+                linked_list_remove_at_iterator(iter);
+                linked_list_insert_after_iterator(iter, value);
+                linked_list_delete_iterator(iter);
+                memmove(expected + index, expected + index + 1,
+                        (size - index - 1) * sizeof(unsigned int));
+                size--;
+                if (index < size) {
+                    memmove(expected + index + 2, expected + index + 1,
+                            (size - index - 1) * sizeof(unsigned int));
+                    expected[index + 1] = value;
+                    size++;
+                }
+            } else if (choice == 5 && size + 16 < 20000) {
+                for (size_t i = 0; i < 16; i++) {
+                    batch[i] = value + i;
+                }
+                if (seed & 1) {
+                    linked_list_insert_end_n(ll, batch, 16);
+                    memcpy(expected + size, batch, sizeof(batch));
+                } else {
+                    linked_list_insert_front_n(ll, batch, 16);
+                    memmove(expected + 16, expected, size * sizeof(unsigned int));
+                    memcpy(expected, batch, sizeof(batch));
+                }
+                size += 16;
+            } else if (size + 1 < 20000) {
+                if (choice == 6) {
+                    index = 0;
+                } else if (choice < 9) {
+                    index = size;
+                }
+                linked_list_insert(ll, index, value);
+                memmove(expected + index + 1, expected + index,
+                        (size - index) * sizeof(unsigned int));
+                expected[index] = value;
+                size++;
+            }
+
+            if (op % 7 == 0) {
+                unsigned int probe = (seed >> 12) % 400;
+                size_t position = expected_find(expected, size, probe);
+                FAIL(linked_list_find(ll, probe) != position,
+                     "linked_list_find() with a hash index went wrong")
+                FAIL(linked_list_contains(ll, probe) != (position != SIZE_MAX),
+                     "linked_list_contains() went wrong")
+            }
+        }
+        FAIL(!linked_list_matches(ll, expected, size),
+             "linked_list wrong after random operations with a hash index")
+
+        // Sorting moves every first position.
+        //
+        SUBTEST(hash_index_sort)
+        linked_list_sort(ll, false);
+        qsort(expected, size, sizeof(unsigned int), compare_unsigned);
+        for (unsigned int v = 0; v < 400; v += 3) {
+            FAIL(linked_list_find(ll, v) != expected_find(expected, size, v),
+                 "linked_list_find() with a hash index wrong after sorting")
+        }
+        linked_list_delete(ll);
+    }
+
+    // Elements moved in by linked_list_concat() are found, and none is left
+    // in the source.
+    //
+    // Removals at the front past a stale first position, then insertions
+    // at the front over it.
+    //
+    SUBTEST(hash_index_front_past_stale)
+    ll = linked_list_create();
+    unsigned int values[] = {10, 11, 42, 13};
+    for (size_t i = 0; i < 4; i++) {
+        linked_list_insert_end(ll, values[i]);
+    }
+    linked_list_enable_hash_index(ll);
+    linked_list_insert(ll, 1, 99);
+    for (size_t i = 0; i < 3; i++) {
+        linked_list_remove(ll, 0);
+    }
+    FAIL(linked_list_contains(ll, 42) != true || linked_list_find(ll, 42) != 0,
+         "linked_list_find() wrong after removals at the front")
+    linked_list_insert(ll, 1, 7);
+    linked_list_remove(ll, 0);
+    linked_list_remove(ll, 0);
+    linked_list_insert_front(ll, 5);
+    linked_list_insert_front(ll, 6);
+    FAIL(linked_list_find(ll, 13) != 2 || linked_list_find(ll, 6) != 0 ||
+         linked_list_find(ll, 5) != 1,
+         "linked_list_find() wrong after insertions at the front")
+    linked_list_delete(ll);
+
+    SUBTEST(hash_index_concat)
+    ll = linked_list_create();
+    struct linked_list * other = linked_list_create();
+    linked_list_enable_hash_index(ll);
+    linked_list_enable_hash_index(other);
+    for (unsigned int i = 0; i < 100; i++) {
+        linked_list_insert_end(ll, i);
+        linked_list_insert_end(other, 1000 + i);
+    }
+    FAIL(linked_list_concat(ll, other) != true,
+         "linked_list_concat() failed")
+    FAIL(linked_list_find(ll, 1050) != 150 || linked_list_find(ll, 50) != 50 ||
+         linked_list_contains(other, 1050) != false,
+         "Hash index wrong after linked_list_concat()")
+    linked_list_delete(other);
+
+    // A failed allocation leaves the index to be rebuilt on next use.
+    //
+    SUBTEST(hash_index_alloc_fail)
+    linked_list_delete(ll);
+    ll = linked_list_create();
+    linked_list_enable_hash_index(ll);
+    linked_list_reserve(ll, 100, false);
+    for (unsigned int i = 0; i < 8; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    instrumented_malloc_fail_next = true;
+    FAIL(linked_list_insert_end(ll, 8) != true,
+         "Insertion failed when only the hash index could not grow")
+    FAIL(instrumented_malloc_fail_next != false,
+         "The hash index did not grow")
+    FAIL(linked_list_find(ll, 8) != 8 || linked_list_contains(ll, 9) != false,
+         "Hash index wrong after a failed allocation")
+    FAIL(linked_list_disable_hash_index(ll) != true || linked_list_find(ll, 8) != 8,
+         "linked_list_disable_hash_index() went wrong")
+    linked_list_delete(ll);
+    PASS(check_linked_list_hash_index)
+#endif
+}
+
+// Block allocator keeping count of the memory it has handed out.
+//
+struct counting_allocator {
+    size_t live_bytes;
+    size_t calls;
+    size_t last_alignment;
+};
+
+void * counting_allocate(size_t bytes, size_t alignment, void * context) {
+    struct counting_allocator * counter = context;
+    counter->live_bytes += bytes;
+    counter->calls += 1;
+    counter->last_alignment = alignment;
+    return aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+}
+
+void counting_release(void * addr, size_t bytes, void * context) {
+    struct counting_allocator * counter = context;
+    counter->live_bytes -= bytes;
+    free(addr);
+}
+
+// Returns whether no block of ll holds more than max_block values.
+//
+bool linked_list_blocks_capped(struct linked_list * ll, size_t max_block) {
+    for (size_t i = 0; i < ll->blocks.count; i++) {
+        const struct block_registry_entry * entry = &ll->blocks.entries[i];
+        if ((entry->chunks ? entry->nodes * LINKED_LIST_UNROLLED_CAPACITY : entry->nodes) > max_block) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void check_linked_list_alloc_policy(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_alloc_policy)
+
+    SUBTEST(alloc_policy_null)
+    struct alloc_policy policy;
+    FAIL(linked_list_set_alloc_policy(NULL, NULL) != false ||
+         linked_list_get_alloc_policy(NULL, &policy) != false,
+         "Alloc policy functions did not fail on NULL")
+
+    SUBTEST(alloc_policy_rules)
+    struct linked_list * ll = linked_list_create();
+    FAIL(linked_list_get_alloc_policy(ll, &policy) != true ||
+         policy.initial_block == 0 || policy.allocator != NULL,
+         "linked_list_get_alloc_policy() did not return the default policy")
+    struct alloc_policy bad = policy;
+    bad.initial_block = 0;
+    FAIL(linked_list_set_alloc_policy(ll, &bad) != false,
+         "linked_list_set_alloc_policy() accepted empty blocks")
+    bad = policy;
+    bad.max_block = policy.initial_block - 1;
+    FAIL(linked_list_set_alloc_policy(ll, &bad) != false,
+         "linked_list_set_alloc_policy() accepted max_block < initial_block")
+    bad = policy;
+    bad.alignment = 48;
+    FAIL(linked_list_set_alloc_policy(ll, &bad) != false,
+         "linked_list_set_alloc_policy() accepted a non power of two alignment")
+    struct linked_list_allocator half = {counting_allocate, NULL, NULL};
+    bad = policy;
+    bad.allocator = &half;
+    FAIL(linked_list_set_alloc_policy(ll, &bad) != false,
+         "linked_list_set_alloc_policy() accepted an allocator without release")
+
+    // Fixed blocks, then growing blocks up to a bound.
+    //
+    SUBTEST(alloc_policy_growth)
+    struct alloc_policy fixed = {100, 0, 0, 0, NULL};
+    FAIL(linked_list_set_alloc_policy(ll, &fixed) != true,
+         "linked_list_set_alloc_policy() failed")
+    for (unsigned int i = 0; i < 1000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    FAIL(ll->blocks.count != 10, "Fixed size blocks not allocated as asked")
+    for (size_t i = 0; i < ll->blocks.count; i++) {
+        FAIL(ll->blocks.entries[i].nodes != 100, "Fixed size block has the wrong size")
+    }
+    linked_list_remove_all(ll);
+    struct alloc_policy bounded = {100, 50, 400, 0, NULL};
+    linked_list_set_alloc_policy(ll, &bounded);
+    for (unsigned int i = 0; i < 5000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    FAIL(ll->blocks.entries[0].nodes != 100, "First block is not initial_block")
+    for (size_t i = 0; i < ll->blocks.count; i++) {
+        FAIL(ll->blocks.entries[i].nodes > 400, "Block larger than max_block")
+    }
+    FAIL(ll->blocks.entries[ll->blocks.count - 1].nodes != 400, "Blocks did not grow")
+    FAIL(linked_list_find(ll, 4999) != 4999, "linked_list wrong with bounded blocks")
+    linked_list_delete(ll);
+
+    // Reservations and bulk insertions are cut into blocks of max_block.
+    //
+    static unsigned int expected[30000];
+    for (int layout = 0; layout < 2; layout++) {
+        SUBTEST(alloc_policy_capped_bulk)
+        ll = linked_list_create();
+        if (layout == 1) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+        }
+        struct alloc_policy capped = {64, 0, 128, 0, NULL};
+        linked_list_set_alloc_policy(ll, &capped);
+        FAIL(linked_list_reserve(ll, 1000, true) != true, "linked_list_reserve() failed")
+        FAIL(!linked_list_blocks_capped(ll, 128),
+             "linked_list_reserve() allocated a block larger than max_block")
+        size_t reserved = ll->blocks.count;
+        instrumented_malloc_fail_next = true;
+        for (unsigned int i = 0; i < 1000; i++) {
+            linked_list_insert_end(ll, i);
+            expected[i] = i;
+        }
+        FAIL(instrumented_malloc_fail_next != true || ll->blocks.count != reserved,
+             "Insertions into a capped reservation allocated")
+        instrumented_malloc_fail_next = false;
+        for (unsigned int i = 1000; i < 3000; i++) {
+            expected[i] = i;
+        }
+        FAIL(linked_list_insert_end_n(ll, expected + 1000, 2000) != true,
+             "linked_list_insert_end_n() failed")
+        FAIL(!linked_list_blocks_capped(ll, 128),
+             "Bulk insertion allocated a block larger than max_block")
+        FAIL(!linked_list_matches(ll, expected, 3000), "linked_list wrong with capped blocks")
+        linked_list_delete(ll);
+    }
+
+    // So are the copies made by compaction, clones and splits.
+    //
+    for (int layout = 0; layout < 3; layout++) {
+        SUBTEST(alloc_policy_capped_copies)
+        ll = linked_list_create();
+        if (layout == 1) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+        }
+        if (layout == 2) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+        }
+        struct alloc_policy capped = {64, 0, 128, 0, NULL};
+        linked_list_set_alloc_policy(ll, &capped);
+        size_t size = churn_linked_list(ll, expected);
+        FAIL(linked_list_compact(ll) != true || !linked_list_blocks_capped(ll, 128) ||
+             !linked_list_matches(ll, expected, size),
+             "linked_list_compact() ignored max_block")
+        struct linked_list * copy = linked_list_clone(ll);
+        FAIL(copy == NULL || !linked_list_blocks_capped(copy, 128) ||
+             !linked_list_matches(copy, expected, size),
+             "linked_list_clone() ignored max_block")
+        struct iterator * iter = linked_list_create_iterator(copy, 10);
+        struct linked_list * rest = linked_list_split_at(iter);
+        linked_list_delete_iterator(iter);
+        FAIL(rest == NULL || !linked_list_blocks_capped(rest, 128) ||
+             !linked_list_matches(rest, expected + 10, size - 10),
+             "linked_list_split_at() ignored max_block")
+        linked_list_delete(rest);
+        linked_list_delete(copy);
+        if (layout != 1) {
+            iter = linked_list_create_iterator(ll, 5);
+            FAIL(linked_list_compact_at_iterator(iter, 1000) != 128 || iter->current_index != 133 ||
+                 !linked_list_blocks_capped(ll, 128),
+                 "linked_list_compact_at_iterator() ignored max_block")
+            linked_list_delete_iterator(iter);
+            FAIL(!linked_list_matches(ll, expected, size),
+                 "linked_list wrong after linked_list_compact_at_iterator()")
+        }
+        linked_list_delete(ll);
+    }
+
+    // And the nodes an adaptive list moves back to.
+    //
+    SUBTEST(alloc_policy_capped_adaptive)
+    ll = linked_list_create();
+    struct alloc_policy capped = {64, 0, 128, 0, NULL};
+    linked_list_set_alloc_policy(ll, &capped);
+    linked_list_set_adaptive(ll, true);
+    for (unsigned int i = 0; i < 3000; i++) {
+        linked_list_insert_end(ll, i);
+        expected[i] = i;
+    }
+    FAIL(ll->layout != LINKED_LIST_LAYOUT_COMPACT, "Appending did not switch to an array")
+    FAIL(linked_list_set_adaptive(ll, false) != true || ll->layout != LINKED_LIST_LAYOUT_NODES ||
+         !linked_list_blocks_capped(ll, 128) || !linked_list_matches(ll, expected, 3000),
+         "Switching back to nodes ignored max_block")
+    linked_list_delete(ll);
+
+    // Aligned blocks, for every kind of block, without an allocator.
+    //
+    for (int layout = 0; layout < 3; layout++) {
+        SUBTEST(alloc_policy_alignment)
+        ll = linked_list_create();
+        if (layout == 1) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+        }
+        if (layout == 2) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+        }
+        struct alloc_policy aligned = {64, 100, 0, 4096, NULL};
+        linked_list_set_alloc_policy(ll, &aligned);
+        size_t size = churn_linked_list(ll, expected);
+        linked_list_compact(ll);
+        for (size_t i = 0; i < 500; i++) {
+            linked_list_insert_end(ll, i);
+            expected[size++] = i;
+        }
+        FAIL(!linked_list_matches(ll, expected, size),
+             "linked_list wrong with aligned blocks")
+        for (size_t i = 0; i < ll->blocks.count; i++) {
+            FAIL((uintptr_t)ll->blocks.entries[i].base % 4096 != 0,
+                 "Block not aligned as asked")
+        }
+        linked_list_delete(ll);
+    }
+
+    // Every block goes back through the allocator it came from, whoever
+    // owns it by then.
+    //
+    SUBTEST(alloc_policy_allocator)
+    struct counting_allocator counter = {0, 0, 0};
+    struct linked_list_allocator counting = {counting_allocate, counting_release, &counter};
+    struct alloc_policy counted = {256, 100, 0, 64, &counting};
+    ll = linked_list_create();
+    linked_list_set_alloc_policy(ll, &counted);
+    for (unsigned int i = 0; i < 10000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    FAIL(counter.calls != ll->blocks.count || counter.live_bytes == 0 ||
+         counter.last_alignment != 64,
+         "Blocks not allocated through the allocator")
+    for (unsigned int i = 0; i < 10000; i++) {
+        linked_list_remove(ll, 0);
+    }
+    linked_list_trim(ll);
+    FAIL(counter.live_bytes != 0, "Trimmed blocks not released through the allocator")
+    struct node_pool * pool = node_pool_create();
+    struct linked_list * other = linked_list_create();
+    linked_list_attach_pool(ll, pool);
+    linked_list_attach_pool(other, pool);
+    for (unsigned int i = 0; i < 1000; i++) {
+        linked_list_insert_end(ll, i);
+        linked_list_insert_end(other, i);
+    }
+    FAIL(counter.live_bytes == 0 || pool->blocks.count == 0,
+         "Pooled blocks not allocated through the allocator")
+    linked_list_delete(ll);
+    node_pool_delete(pool);
+    linked_list_delete(other);
+    FAIL(counter.live_bytes != 0, "Pooled blocks not released through the allocator")
+
+    SUBTEST(alloc_policy_huge_pages)
+    ll = linked_list_create();
+    struct alloc_policy huge = {2 * 1024 * 1024 / sizeof(struct node), 100, 0, 0,
+                                &linked_list_huge_page_allocator};
+    linked_list_set_alloc_policy(ll, &huge);
+    for (unsigned int i = 0; i < 200000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    for (size_t i = 0; i < ll->blocks.count; i++) {
+        FAIL((uintptr_t)ll->blocks.entries[i].base % (2 * 1024 * 1024) != 0,
+             "Huge page block not aligned to a huge page")
+    }
+    FAIL(linked_list_find(ll, 199999) != 199999,
+         "linked_list wrong on huge page blocks")
+    linked_list_delete(ll);
+    PASS(check_linked_list_alloc_policy)
+#endif
+
+#ifdef TEST_QUEUE
+    TEST(check_queue_alloc_policy)
+    SUBTEST(queue_small_blocks)
+    struct queue * queue = queue_create();
+    struct alloc_policy small = {8, 0, 0, 0, NULL};
+    FAIL(queue_set_alloc_policy(NULL, &small) != false ||
+         queue_set_alloc_policy(queue, &small) != true,
+         "queue_set_alloc_policy() went wrong")
+    for (unsigned int i = 0; i < 100; i++) {
+        queue_push(queue, i);
+    }
+    FAIL(queue->ll.blocks.count != 13, "Queue blocks not sized as asked")
+    unsigned int popped = 0;
+    for (unsigned int i = 0; i < 100; i++) {
+        FAIL(queue_pop(queue, &popped) != true || popped != i,
+             "Queue with small blocks popped out of order")
+    }
+    queue_delete(queue);
+    PASS(check_queue_alloc_policy)
+#endif
+}
+
+void check_linked_list_stats(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_stats)
+
+    SUBTEST(stats_null)
+    struct linked_list_stats stats;
+    FAIL(linked_list_get_stats(NULL, &stats) != false ||
+         linked_list_reset_stats(NULL) != false,
+         "Stats functions did not fail on NULL")
+    struct linked_list * ll = linked_list_create();
+    FAIL(linked_list_get_stats(ll, NULL) != false,
+         "linked_list_get_stats() did not fail on NULL stats")
+
+#ifdef LINKED_LIST_STATS
+    // One block of 128 nodes, 100 of them handed out.
+    //
+    SUBTEST(stats_allocation)
+    struct alloc_policy fixed = {128, 0, 0, 0, NULL};
+    linked_list_set_alloc_policy(ll, &fixed);
+    for (unsigned int i = 0; i < 100; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    FAIL(linked_list_get_stats(ll, &stats) != true,
+         "linked_list_get_stats() failed")
+    FAIL(stats.node_requests != 100 || stats.carve_hits != 99 ||
+         stats.free_stack_hits != 0, "Node requests not counted")
+    FAIL(stats.allocations != 1 ||
+         stats.allocated_bytes != 128 * sizeof(struct node),
+         "Block allocation not counted")
+    FAIL(stats.blocks != 1 || stats.reserved_bytes != 128 * sizeof(struct node) ||
+         stats.live_bytes != 100 * sizeof(struct node) || stats.free_nodes != 28,
+         "Memory of the linked_list not reported")
+
+    // Walks of 49, 9 and 0 steps, a find comparing 19 elements and one
+    // comparing all 99 of them.
+    //
+    SUBTEST(stats_walks)
+    linked_list_insert(ll, 50, 7);
+    linked_list_remove(ll, 10);
+    linked_list_remove(ll, 0);
+    FAIL(linked_list_find(ll, 20) != 18 || linked_list_find(ll, 1000) != SIZE_MAX,
+         "linked_list_find() wrong with stats")
+    linked_list_get_stats(ll, &stats);
+    FAIL(stats.insert_walks[0] != 100 || stats.insert_walks[6] != 1,
+         "Insert walks not recorded")
+    FAIL(stats.remove_walks[0] != 1 || stats.remove_walks[4] != 1,
+         "Remove walks not recorded")
+    FAIL(stats.find_walks[5] != 1 || stats.find_walks[7] != 1,
+         "Find walks not recorded")
+    linked_list_insert_end(ll, 100);
+    linked_list_get_stats(ll, &stats);
+    FAIL(stats.free_stack_hits != 1 || stats.free_nodes != 28,
+         "Free stack hit not counted")
+
+    SUBTEST(stats_reset)
+    FAIL(linked_list_reset_stats(ll) != true, "linked_list_reset_stats() failed")
+    linked_list_get_stats(ll, &stats);
+    size_t recorded = stats.node_requests + stats.allocations + stats.allocated_bytes;
+    for (size_t i = 0; i < LINKED_LIST_STATS_BUCKETS; i++) {
+        recorded += stats.insert_walks[i] + stats.remove_walks[i] + stats.find_walks[i];
+    }
+    FAIL(recorded != 0, "linked_list_reset_stats() left counts behind")
+    FAIL(stats.blocks != 1 || stats.live_bytes != 100 * sizeof(struct node),
+         "linked_list_reset_stats() changed the memory reported")
+    linked_list_delete(ll);
+
+    // The other layouts report their own nodes and walks.
+    //
+    for (int layout = 0; layout < 2; layout++) {
+        SUBTEST(stats_layouts)
+        ll = linked_list_create();
+        linked_list_set_layout(ll, layout == 0 ? LINKED_LIST_LAYOUT_UNROLLED
+                                               : LINKED_LIST_LAYOUT_COMPACT);
+        for (unsigned int i = 0; i < 1000; i++) {
+            linked_list_insert_end(ll, i);
+        }
+        linked_list_remove(ll, 500);
+        linked_list_get_stats(ll, &stats);
+        FAIL(stats.allocations == 0 || stats.reserved_bytes == 0 ||
+             stats.live_bytes < 999 * sizeof(unsigned int) ||
+             stats.live_bytes > stats.reserved_bytes,
+             "Memory of the linked_list not reported")
+        FAIL(stats.remove_walks[0] != 0, "Remove walk not recorded")
+        linked_list_delete(ll);
+    }
+#else
+    SUBTEST(stats_not_compiled)
+    FAIL(linked_list_get_stats(ll, &stats) != false ||
+         linked_list_reset_stats(ll) != false,
+         "Stats reported without LINKED_LIST_STATS")
+    linked_list_delete(ll);
+#endif
+    PASS(check_linked_list_stats)
+#endif
+}
+
+void check_linked_list_save_load(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_save_load)
+
+    SUBTEST(save_load_null)
+    char path[] = "/tmp/linked_list_saveXXXXXX";
+    int fd = mkstemp(path);
+    FAIL(fd < 0, "mkstemp() failed")
+    FAIL(linked_list_save(NULL, fd) != false,
+         "linked_list_save(NULL, fd) did not return false")
+    FAIL(linked_list_load_mmap(NULL) != NULL,
+         "linked_list_load_mmap(NULL) did not return NULL")
+    FAIL(linked_list_load_mmap("/nonexistent/linked_list") != NULL,
+         "linked_list_load_mmap() loaded a missing file")
+
+    // Every layout loads back as a compact linked_list over the file.
+    //
+    static unsigned int expected[30000];
+    static const enum linked_list_layout layouts[] = {
+        LINKED_LIST_LAYOUT_NODES, LINKED_LIST_LAYOUT_UNROLLED,
+        LINKED_LIST_LAYOUT_COMPACT, LINKED_LIST_LAYOUT_DOUBLY,
+    };
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+        SUBTEST(save_load_round_trip)
+        struct linked_list * ll = linked_list_create();
+        linked_list_set_layout(ll, layouts[l]);
+        size_t size = churn_linked_list(ll, expected);
+        FAIL(ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0,
+             "Could not empty the file")
+        FAIL(linked_list_save(ll, fd) != true, "linked_list_save() failed")
+        linked_list_delete(ll);
+
+        ll = linked_list_load_mmap(path);
+        FAIL(ll == NULL, "linked_list_load_mmap() failed")
+        FAIL(ll->layout != LINKED_LIST_LAYOUT_COMPACT || ll->arena.mapping == NULL,
+             "Loaded linked_list does not use the mapping")
+        FAIL(!linked_list_matches(ll, expected, size),
+             "Loaded linked_list does not match the saved one")
+        FAIL(linked_list_find(ll, expected[size - 1]) != size - 1,
+             "linked_list_find() wrong on a loaded linked_list")
+
+        // Changes, including growing out of the mapping, stay private.
+        SUBTEST(save_load_modify)
+        linked_list_remove(ll, 0);
+        linked_list_insert(ll, 5, 12345);
+        for (unsigned int i = 0; i < 1000; i++) {
+            linked_list_insert_end(ll, i);
+        }
+        FAIL(ll->arena.mapping != NULL, "Grown arena still uses the mapping")
+        FAIL(linked_list_size(ll) != size + 1000 ||
+             linked_list_find(ll, 12345) != 5,
+             "Loaded linked_list wrong after changes")
+        linked_list_delete(ll);
+        ll = linked_list_load_mmap(path);
+        FAIL(ll == NULL || !linked_list_matches(ll, expected, size),
+             "Changes to a loaded linked_list reached the file")
+        linked_list_delete(ll);
+    }
+
+    SUBTEST(save_load_empty)
+    struct linked_list * ll = linked_list_create();
+    FAIL(ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0,
+         "Could not empty the file")
+    FAIL(linked_list_save(ll, fd) != true, "linked_list_save() failed on empty list")
+    linked_list_delete(ll);
+    ll = linked_list_load_mmap(path);
+    FAIL(ll == NULL || linked_list_size(ll) != 0,
+         "Empty linked_list not loaded back")
+    FAIL(linked_list_insert_end(ll, 7) != true || linked_list_find(ll, 7) != 0,
+         "Loaded empty linked_list not usable")
+    linked_list_delete(ll);
+
+    SUBTEST(save_load_bad_file)
+    FAIL(ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0,
+         "Could not empty the file")
+    ll = linked_list_create();
+    for (unsigned int i = 0; i < 100; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    linked_list_save(ll, fd);
+    linked_list_delete(ll);
+    FAIL(ftruncate(fd, 100) != 0, "Could not truncate the file")
+    FAIL(linked_list_load_mmap(path) != NULL,
+         "linked_list_load_mmap() loaded a truncated file")
+    FAIL(lseek(fd, 0, SEEK_SET) != 0 || write(fd, "garbage!", 8) != 8,
+         "Could not overwrite the file")
+    FAIL(linked_list_load_mmap(path) != NULL,
+         "linked_list_load_mmap() loaded a file without the header")
+    close(fd);
+    unlink(path);
+    PASS(check_linked_list_save_load)
+#endif
+}
+
+// Block allocator that never has memory.
+//
+void * failing_allocate(size_t bytes, size_t alignment, void * context) {
+    (void)bytes;
+    (void)alignment;
+    (void)context;
+    return NULL;
+}
+
+// Returns whether every node of ll links to its physical successor.
+//
+bool linked_list_is_physically_ordered(struct linked_list * ll) {
+    if (ll->layout == LINKED_LIST_LAYOUT_UNROLLED) {
+        for (struct unrolled_node * chunk = ll->chunk_head; chunk != ll->chunk_tail; chunk = chunk->next) {
+            if (chunk->next != chunk + 1 || chunk->count != LINKED_LIST_UNROLLED_CAPACITY) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (ll->layout == LINKED_LIST_LAYOUT_COMPACT) {
+        for (uint32_t slot = ll->compact_head; slot != ll->compact_tail; slot++) {
+            if (ll->arena.nodes[slot].next != slot + 1) {
+                return false;
+            }
+        }
+        return ll->compact_head == 0;
+    }
+    size_t node_bytes = ll->layout == LINKED_LIST_LAYOUT_DOUBLY ? sizeof(struct dnode)
+                                                              : sizeof(struct node);
+    for (struct node * node = ll->head; node != ll->tail; node = node->next) {
+        if ((char *)node->next != (char *)node + node_bytes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void check_linked_list_clone(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_clone)
+
+    SUBTEST(clone_null)
+    FAIL(linked_list_clone(NULL) != NULL, "linked_list_clone(NULL) did not return NULL")
+
+    // Nodes, nodes with an index, unrolled, doubly linked, compact and
+    // nodes in a node_pool.
+    //
+    static unsigned int expected[30000];
+    struct node_pool * pool = node_pool_create();
+    for (int variant = 0; variant < 6; variant++) {
+        SUBTEST(clone_churned)
+        struct linked_list * ll = variant < 4 ? create_splice_variant(variant) : linked_list_create();
+        if (variant == 4) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT);
+        }
+        if (variant == 5) {
+            linked_list_attach_pool(ll, pool);
+        }
+        size_t size = churn_linked_list(ll, expected);
+        struct linked_list * clone = linked_list_clone(ll);
+        FAIL(clone == NULL, "linked_list_clone() failed")
+        FAIL(clone->layout != ll->layout || clone->pool != NULL || clone->index != NULL,
+             "Clone has the wrong layout or storage")
+        FAIL(!linked_list_matches(clone, expected, size),
+             "Clone does not match the original")
+        FAIL(!linked_list_is_physically_ordered(clone),
+             "Clone is not physically ordered")
+        FAIL(variant != 4 && clone->blocks.count != 1,
+             "Clone not allocated as a single block")
+
+        SUBTEST(clone_independent)
+        linked_list_remove(clone, 0);
+        linked_list_insert(clone, 3, 99999);
+        linked_list_remove_end(clone);
+        for (unsigned int i = 0; i < 100; i++) {
+            linked_list_insert_end(clone, i);
+        }
+        FAIL(!linked_list_matches(ll, expected, size),
+             "Changing the clone changed the original")
+        FAIL(linked_list_size(clone) != size + 99 || linked_list_find(clone, 99999) != 3,
+             "Clone wrong after changes")
+        linked_list_delete(ll);
+        FAIL(linked_list_find(clone, 99999) != 3, "Clone depends on the original")
+        linked_list_delete(clone);
+    }
+    node_pool_delete(pool);
+
+    SUBTEST(clone_empty)
+    struct linked_list * ll = linked_list_create();
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+    struct linked_list * clone = linked_list_clone(ll);
+    FAIL(clone == NULL || linked_list_size(clone) != 0 ||
+         clone->layout != LINKED_LIST_LAYOUT_UNROLLED,
+         "Empty linked_list not cloned")
+    FAIL(linked_list_insert_end(clone, 5) != true || linked_list_find(clone, 5) != 0,
+         "Clone of an empty linked_list not usable")
+    linked_list_delete(clone);
+    linked_list_delete(ll);
+
+    SUBTEST(clone_alloc_fail)
+    ll = linked_list_create();
+    for (unsigned int i = 0; i < 100; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    instrumented_malloc_fail_next = true;
+    FAIL(linked_list_clone(ll) != NULL,
+         "linked_list_clone() did not fail without memory")
+    struct linked_list_allocator failing = {failing_allocate, counting_release, NULL};
+    struct alloc_policy policy = {64, 100, 0, 0, &failing};
+    linked_list_set_alloc_policy(ll, &policy);
+    FAIL(linked_list_clone(ll) != NULL,
+         "linked_list_clone() did not fail without memory for the block")
+    linked_list_delete(ll);
+    PASS(check_linked_list_clone)
+#endif
+}
+
+// Returns whether linked_list_find_parallel(), linked_list_count() and
+// linked_list_reduce() agree with expected[0..size) for a few values.
+//
+bool parallel_scans_match(struct linked_list * ll, const unsigned int * expected, size_t size) {
+    unsigned int probes[] = {expected[0], expected[size / 2], expected[size - 1], UINT_MAX};
+    for (size_t p = 0; p < sizeof(probes) / sizeof(probes[0]); p++) {
+        size_t first = SIZE_MAX;
+        size_t count = 0;
+        for (size_t i = 0; i < size; i++) {
+            if (expected[i] == probes[p]) {
+                count++;
+                if (first == SIZE_MAX) {
+                    first = i;
+                }
+            }
+        }
+        if (linked_list_find_parallel(ll, probes[p]) != first ||
+            linked_list_count(ll, probes[p]) != count) {
+            return false;
+        }
+    }
+
+    struct linked_list_summary summary;
+    uint64_t sum = 0;
+    unsigned int min = UINT_MAX;
+    unsigned int max = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum += expected[i];
+        min = expected[i] < min ? expected[i] : min;
+        max = expected[i] > max ? expected[i] : max;
+    }
+    return linked_list_reduce(ll, &summary) == true && summary.sum == sum &&
+           summary.min == min && summary.max == max;
+}
+
+#ifdef LINKED_LIST_STATS
+// Returns the pieces the scans of ll were split into since the last call,
+// and resets its stats.
+//
+size_t scan_pieces_since(struct linked_list * ll) {
+    struct linked_list_stats stats;
+    linked_list_get_stats(ll, &stats);
+    linked_list_reset_stats(ll);
+    return stats.scans == 0 ? 0 : stats.scan_pieces;
+}
+#endif
+
+void check_linked_list_parallel_scan(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_parallel_scan)
+
+    SUBTEST(parallel_scan_null)
+    struct linked_list_summary summary;
+    FAIL(linked_list_find_parallel(NULL, 1) != SIZE_MAX || linked_list_count(NULL, 1) != SIZE_MAX ||
+         linked_list_reduce(NULL, &summary) != false,
+         "Parallel scans did not fail on NULL")
+    struct linked_list * ll = linked_list_create();
+    FAIL(linked_list_reduce(ll, NULL) != false, "linked_list_reduce() did not fail on NULL summary")
+    FAIL(linked_list_find_parallel(ll, 1) != SIZE_MAX || linked_list_count(ll, 1) != 0 ||
+         linked_list_reduce(ll, &summary) != true || summary.sum != 0 ||
+         summary.min != UINT_MAX || summary.max != 0,
+         "Parallel scans wrong on an empty linked_list")
+    linked_list_delete(ll);
+
+    // Split by storage, by the positional index, or not at all, with and
+    // without threads.
+    //
+    static unsigned int expected[100001];
+    for (size_t threads = 1; threads <= 4; threads += 3) {
+        linked_list_set_scan_threads(threads);
+        for (int variant = 0; variant < 9; variant++) {
+            SUBTEST(parallel_scan_variants)
+            ll = linked_list_create();
+            if (variant == 3 || variant == 4) {
+                linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+            }
+            if (variant == 5 || variant == 6) {
+                linked_list_set_layout(ll, LINKED_LIST_LAYOUT_COMPACT);
+            }
+            if (variant == 7) {
+                linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+            }
+            size_t size = 100000;
+            for (size_t i = 0; i < size; i++) {
+                expected[i] = (unsigned int)(i * 7919 % 50000);
+                linked_list_insert_end(ll, expected[i]);
+            }
+            if (variant == 1 || variant == 2 || variant == 4) {
+                for (size_t k = 0; k < 1000; k++) {
+                    linked_list_remove(ll, 3 * k);
+                    memmove(expected + 3 * k, expected + 3 * k + 1,
+                            (size - 3 * k - 1) * sizeof(unsigned int));
+                    size--;
+                }
+            }
+            if (variant == 2) {
+                linked_list_enable_index(ll);
+            }
+            if (variant == 6) {
+                linked_list_insert(ll, 10, 12345);
+                memmove(expected + 11, expected + 10, (size - 10) * sizeof(unsigned int));
+                expected[10] = 12345;
+                size++;
+            }
+            if (variant == 8) {
+                linked_list_enable_hash_index(ll);
+            }
+            FAIL(!parallel_scans_match(ll, expected, size),
+                 "Parallel scans do not match a sequential scan")
+            linked_list_delete(ll);
+        }
+    }
+
+    // Storage of nodes cannot tell positions: a find does not split it.
+    //
+    SUBTEST(parallel_find_unordered)
+    ll = linked_list_create();
+    for (unsigned int i = 0; i < 100000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    instrumented_malloc_fail_next = true;
+    FAIL(linked_list_find_parallel(ll, 99999) != 99999 || instrumented_malloc_fail_next != true,
+         "linked_list_find_parallel() scanned storage it could not place")
+    instrumented_malloc_fail_next = false;
+    FAIL(linked_list_count(ll, 99999) != 1, "linked_list_count() wrong")
+    linked_list_delete(ll);
+
+#ifdef LINKED_LIST_STATS
+    // Each scan is split between threads wherever the documentation says
+    // it scales: fresh storage, a fresh compact, or a positional index.
+    //
+    linked_list_set_scan_threads(4);
+    for (int layout = 0; layout < 4; layout++) {
+        SUBTEST(parallel_scan_pieces)
+        static const enum linked_list_layout layouts[] = {
+            LINKED_LIST_LAYOUT_NODES, LINKED_LIST_LAYOUT_DOUBLY,
+            LINKED_LIST_LAYOUT_UNROLLED, LINKED_LIST_LAYOUT_COMPACT};
+        ll = linked_list_create();
+        linked_list_set_layout(ll, layouts[layout]);
+        for (unsigned int i = 0; i < 100000; i++) {
+            linked_list_insert_end(ll, i);
+        }
+        linked_list_reset_stats(ll);
+        FAIL(linked_list_count(ll, 5) != 1 || scan_pieces_since(ll) < 2,
+             "linked_list_count() of fresh storage not split")
+        FAIL(linked_list_reduce(ll, &summary) != true || scan_pieces_since(ll) < 2,
+             "linked_list_reduce() of fresh storage not split")
+        linked_list_find_parallel(ll, 99999);
+        FAIL((scan_pieces_since(ll) < 2) != (layout != 3),
+             "linked_list_find_parallel() split storage it cannot place, or compact slots it can")
+
+        // Removals cache nodes, after which the index splits the list, and
+        // so does a compact.
+        //
+        for (unsigned int i = 0; i < 1000; i++) {
+            linked_list_remove(ll, 7 * i);
+        }
+        linked_list_count(ll, 5);
+        FAIL(layout == 0 && scan_pieces_since(ll) != 1,
+             "linked_list_count() split storage holding removed nodes")
+        if (layout == 0) {
+            linked_list_enable_index(ll);
+            FAIL(linked_list_count(ll, 5) != 1 || scan_pieces_since(ll) < 2,
+                 "linked_list_count() not split by the index")
+            FAIL(linked_list_reduce(ll, &summary) != true || scan_pieces_since(ll) < 2,
+                 "linked_list_reduce() not split by the index")
+            FAIL(linked_list_find_parallel(ll, 99999) != 98999 || scan_pieces_since(ll) < 2,
+                 "linked_list_find_parallel() not split by the index")
+            linked_list_disable_index(ll);
+        }
+        FAIL(linked_list_compact(ll) != true, "linked_list_compact() failed")
+        linked_list_reset_stats(ll);
+        FAIL(linked_list_count(ll, 5) != 1 || scan_pieces_since(ll) < 2,
+             "linked_list_count() of a compacted linked_list not split")
+        FAIL(linked_list_reduce(ll, &summary) != true || scan_pieces_since(ll) < 2,
+             "linked_list_reduce() of a compacted linked_list not split")
+        linked_list_delete(ll);
+    }
+#endif
+    linked_list_set_scan_threads(0);
+    PASS(check_linked_list_parallel_scan)
+#endif
+}
+
+void check_linked_list_adaptive(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_adaptive)
+
+    SUBTEST(adaptive_null)
+    FAIL(linked_list_set_adaptive(NULL, true) != false, "linked_list_set_adaptive(NULL) did not fail")
+    struct linked_list * ll = linked_list_create();
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_UNROLLED);
+    FAIL(linked_list_set_adaptive(ll, true) != false, "Unrolled linked_list made adaptive")
+    linked_list_set_layout(ll, LINKED_LIST_LAYOUT_NODES);
+    FAIL(linked_list_set_adaptive(ll, true) != true, "linked_list_set_adaptive() failed")
+    FAIL(linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY) != false,
+         "Adaptive linked_list made doubly linked")
+
+    // A failed switch leaves the list in nodes, the next run of operations
+    // at the ends switches it.
+    //
+    SUBTEST(adaptive_alloc_fail)
+    static unsigned int expected[20000];
+    size_t size = 0;
+    for (; size < 1023; size++) {
+        expected[size] = (unsigned int)size;
+        linked_list_insert_end(ll, expected[size]);
+    }
+    FAIL(ll->layout != LINKED_LIST_LAYOUT_NODES, "Switched before enough operations")
+    instrumented_malloc_fail_next = true;
+    expected[size] = (unsigned int)size;
+    FAIL(linked_list_insert_end(ll, expected[size++]) != true, "Insertion failed with the switch")
+    FAIL(ll->layout != LINKED_LIST_LAYOUT_NODES || !linked_list_matches(ll, expected, size),
+         "Failed switch changed the linked_list")
+
+    SUBTEST(adaptive_to_array)
+    for (; size < 3000; size++) {
+        expected[size] = (unsigned int)size;
+        linked_list_insert_end(ll, expected[size]);
+    }
+    FAIL(ll->layout != LINKED_LIST_LAYOUT_COMPACT || ll->head != NULL,
+         "Appending did not switch to an array")
+    FAIL(!linked_list_is_physically_ordered(ll) || !linked_list_matches(ll, expected, size),
+         "Array does not match")
+    for (unsigned int i = 0; i < 100; i++) {
+        linked_list_insert_front(ll, 50000 + i);
+        linked_list_remove(ll, 0);
+    }
+    FAIL(ll->layout != LINKED_LIST_LAYOUT_COMPACT || linked_list_find(ll, 2999) != 2999,
+         "Array wrong after changes at the front")
+
+    // Never under an open iterator.
+    //
+    SUBTEST(adaptive_to_nodes)
+    struct iterator * iter = linked_list_create_iterator(ll, 0);
+    for (unsigned int i = 0; i < 2000; i++) {
+        size_t index = 1 + (i * 7) % (size - 1);
+        linked_list_insert(ll, index, 100000 + i);
+        memmove(expected + index + 1, expected + index, (size - index) * sizeof(unsigned int));
+        expected[index] = 100000 + i;
+        size++;
+    }
+    FAIL(ll->layout != LINKED_LIST_LAYOUT_COMPACT || iter->data != 0,
+         "Switched with an open iterator")
+    linked_list_delete_iterator(iter);
+    for (unsigned int i = 0; i < 1024; i++) {
+        linked_list_remove(ll, 5);
+        memmove(expected + 5, expected + 6, (size - 6) * sizeof(unsigned int));
+        size--;
+    }
+    FAIL(ll->layout != LINKED_LIST_LAYOUT_NODES || ll->blocks.count != 1,
+         "Operations in the middle did not switch back to nodes")
+    FAIL(!linked_list_matches(ll, expected, size), "Nodes do not match")
+
+    // An index pins the list to nodes, disabling moves it back to nodes.
+    //
+    SUBTEST(adaptive_index)
+    for (unsigned int i = 0; i < 3 * size; i++) {
+        linked_list_find(ll, UINT_MAX);
+    }
+    FAIL(ll->layout != LINKED_LIST_LAYOUT_COMPACT, "Scans did not switch to an array")
+    FAIL(linked_list_enable_index(ll) != true || ll->layout != LINKED_LIST_LAYOUT_NODES,
+         "linked_list_enable_index() did not switch back to nodes")
+    for (unsigned int i = 0; i < 3 * size; i++) {
+        linked_list_find(ll, UINT_MAX);
+    }
+    FAIL(ll->layout != LINKED_LIST_LAYOUT_NODES || !linked_list_matches(ll, expected, size),
+         "Switched with an index")
+    linked_list_disable_index(ll);
+    for (unsigned int i = 0; i < 3 * size; i++) {
+        linked_list_find(ll, UINT_MAX);
+    }
+    FAIL(ll->layout != LINKED_LIST_LAYOUT_COMPACT, "Scans did not switch to an array")
+    FAIL(linked_list_set_adaptive(ll, false) != true || ll->layout != LINKED_LIST_LAYOUT_NODES ||
+         !linked_list_matches(ll, expected, size),
+         "Disabling did not switch back to nodes")
+    linked_list_delete(ll);
+
+    // An iterator created before the list became adaptive cannot be
+    // counted, the list refuses to become adaptive while it may be open.
+    //
+    SUBTEST(adaptive_untracked_iterator)
+    ll = linked_list_create();
+    for (unsigned int i = 0; i < 3000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    iter = linked_list_create_iterator(ll, 0);
+    FAIL(linked_list_set_adaptive(ll, true) != false,
+         "Made adaptive with an iterator it does not count")
+    for (unsigned int i = 0; i < 3000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    FAIL(ll->layout != LINKED_LIST_LAYOUT_NODES || iter->data != 0,
+         "Switched under an iterator it does not count")
+    linked_list_delete_iterator(iter);
+    linked_list_delete(ll);
+    ll = linked_list_create();
+    for (unsigned int i = 0; i < 3000; i++) {
+        linked_list_insert_end(ll, i);
+    }
+    char path[] = "/tmp/linked_list_adaptiveXXXXXX";
+    int fd = mkstemp(path);
+    FAIL(fd < 0 || linked_list_save(ll, fd) != true, "linked_list_save() failed")
+    close(fd);
+    unlink(path);
+    FAIL(linked_list_set_adaptive(ll, true) != true,
+         "Iterators of the library kept the linked_list from becoming adaptive")
+    linked_list_delete(ll);
+
+    SUBTEST(adaptive_queue)
+    struct queue * queue = queue_create();
+    FAIL(queue_set_adaptive(NULL, true) != false || queue_set_adaptive(queue, true) != true,
+         "queue_set_adaptive() failed")
+    unsigned int popped = 0;
+    unsigned int next = 0;
+    bool in_order = true;
+    for (unsigned int i = 0; i < 50000; i++) {
+        queue_push(queue, i);
+        if (i % 3 != 0) {
+            queue_pop(queue, &popped);
+            in_order = in_order && popped == next++;
+        }
+    }
+    FAIL(queue->ll.layout != LINKED_LIST_LAYOUT_COMPACT, "Queue did not switch to an array")
+    while (queue_pop(queue, &popped)) {
+        in_order = in_order && popped == next++;
+    }
+    FAIL(!in_order || next != 50000, "Queue lost its order")
+    queue_delete(queue);
+
+    PASS(check_linked_list_adaptive)
+#endif
+}
+
+// Returns whether every finger of ll sits on the node at its position.
+//
+bool linked_list_fingers_match(struct linked_list * ll, const unsigned int * expected, size_t size) {
+    for (size_t i = 0; i < LINKED_LIST_FINGERS; i++) {
+        struct linked_list_finger * finger = &ll->fingers[i];
+        if (finger->node != NULL &&
+            (finger->index >= size || finger->node->data != expected[finger->index])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void check_linked_list_fingers(void) {
+#ifdef TEST_LINKED_LIST
+    TEST(check_linked_list_fingers)
+
+    // Random positional operations, through the list and through
+    // iterators, on distinct values.
+    //
+    static unsigned int expected[30000];
+    for (int variant = 0; variant < 2; variant++) {
+        SUBTEST(fingers_random)
+        struct linked_list * ll = linked_list_create();
+        if (variant == 1) {
+            linked_list_set_layout(ll, LINKED_LIST_LAYOUT_DOUBLY);
+        }
+        size_t size = 0;
+        unsigned int seed = 4242;
+        bool fingers_match = true;
+        for (unsigned int op = 0; op < 20000; op++) {
+            seed = seed * 1103515245u + 12345u;
+            size_t index = (seed >> 4) % (size + 1);
+            unsigned int kind = (seed >> 20) % 8;
+            if (size > 0 && index == size) {
+                index--;
+            }
+            if (size == 0 || kind < 3) {
+                linked_list_insert(ll, index, op);
+                memmove(expected + index + 1, expected + index, (size - index) * sizeof(unsigned int));
+                expected[index] = op;
+                size++;
+            } else if (kind < 5) {
+                linked_list_remove(ll, index);
+                memmove(expected + index, expected + index + 1, (size - index - 1) * sizeof(unsigned int));
+                size--;
+            } else if (kind == 5) {
+                struct iterator * iter = linked_list_create_iterator(ll, index);
+                linked_list_insert_after_iterator(iter, op);
+                linked_list_delete_iterator(iter);
+                memmove(expected + index + 2, expected + index + 1, (size - index - 1) * sizeof(unsigned int));
+                expected[index + 1] = op;
+                size++;
+            } else if (kind == 6) {
+                struct iterator * iter = linked_list_create_iterator(ll, index);
+                linked_list_remove_at_iterator(iter);
+                linked_list_delete_iterator(iter);
+                memmove(expected + index, expected + index + 1, (size - index - 1) * sizeof(unsigned int));
+                size--;
+            } else if (variant == 1) {
+                struct iterator * iter = linked_list_create_iterator(ll, index);
+                linked_list_remove_node(ll, iter->current_node);
+                linked_list_delete_iterator(iter);
+                memmove(expected + index, expected + index + 1, (size - index - 1) * sizeof(unsigned int));
+                size--;
+            } else {
+                linked_list_insert_front(ll, op);
+                memmove(expected + 1, expected, size * sizeof(unsigned int));
+                expected[0] = op;
+                size++;
+            }
+            fingers_match = fingers_match && linked_list_fingers_match(ll, expected, size);
+        }
+        FAIL(!fingers_match, "Finger off its node")
+        FAIL(!linked_list_matches(ll, expected, size), "Positional operations wrong with fingers")
+
+        // Relinking many nodes at once drops every finger.
+        //
+        SUBTEST(fingers_relink)
+        linked_list_insert(ll, size / 2, 99999);
+        linked_list_sort(ll, false);
+        bool dropped = true;
+        for (size_t i = 0; i < LINKED_LIST_FINGERS; i++) {
+            dropped = dropped && ll->fingers[i].node == NULL;
+        }
+        FAIL(!dropped, "linked_list_sort() kept a finger")
+        linked_list_delete(ll);
+    }
+
+    // Slowly increasing positions only walk the distance between them.
+    //
+    SUBTEST(fingers_sequential)
+    struct linked_list * ll = linked_list_create();
+    for (unsigned int i = 0; i < 10000; i++) {
+        linked_list_insert_end(ll, 2 * i);
+    }
+    for (size_t i = 0; i < 10000; i++) {
+        linked_list_insert(ll, 2 * i + 1, (unsigned int)(2 * i + 1));
+    }
+    for (size_t i = 0; i < 20000; i += 3) {
+        struct iterator * iter = linked_list_create_iterator(ll, i);
+        FAIL(iter == NULL || iter->data != i, "Iterator at the wrong position")
+        linked_list_delete_iterator(iter);
+    }
+    for (unsigned int i = 0; i < 20000; i++) {
+        expected[i] = i;
+    }
+    FAIL(!linked_list_matches(ll, expected, 20000), "Interleaved insertions wrong")
+#ifdef LINKED_LIST_STATS
+    struct linked_list_stats stats;
+    linked_list_get_stats(ll, &stats);
+    size_t long_walks = 0;
+    for (size_t i = 3; i < LINKED_LIST_STATS_BUCKETS; i++) {
+        long_walks += stats.insert_walks[i];
+    }
+    FAIL(long_walks != 0, "Insertions walked from the head")
+#endif
+    linked_list_delete(ll);
+
+    PASS(check_linked_list_fingers)
+#endif
+}
+
 int main(void) {
     // Set up signal handler for catching infinite loops.
     //
@@ -579,6 +3824,31 @@ int main(void) {
     check_linked_list_find_functionality();
 
     check_linked_list_additional_delete_tests();
+    check_linked_list_unrolled_functionality();
+    check_linked_list_find_layouts();
+    check_linked_list_reserve();
+    check_linked_list_index();
+    check_linked_list_cursor();
+    check_linked_list_bulk_insert();
+    check_linked_list_iterate_batch();
+    check_linked_list_block_registry();
+    check_linked_list_node_pool();
+    check_linked_list_compact_functionality();
+    check_linked_list_lazy_blocks();
+    check_linked_list_trim();
+    check_linked_list_compact();
+    check_linked_list_prefetch();
+    check_linked_list_doubly();
+    check_linked_list_sort();
+    check_linked_list_splice();
+    check_linked_list_hash_index();
+    check_linked_list_alloc_policy();
+    check_linked_list_stats();
+    check_linked_list_save_load();
+    check_linked_list_clone();
+    check_linked_list_parallel_scan();
+    check_linked_list_adaptive();
+    check_linked_list_fingers();
 
     return 0;
 }
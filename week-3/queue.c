@@ -35,6 +35,18 @@
 static void * (*malloc_fptr)(size_t size);
 static void   (*free_fptr)(void* addr);
 
+// Returns the value at the head of a non-empty queue, whatever the layout
+// of its linked_list.
+//
+static unsigned int __queue_front(struct queue * queue){
+    struct linked_list* ll = &(queue->ll);
+    if(ll->layout == LINKED_LIST_LAYOUT_UNROLLED)
+        return ll->chunk_head->data[0];
+    if(ll->layout == LINKED_LIST_LAYOUT_COMPACT)
+        return ll->arena.nodes[ll->compact_head].data;
+    return ll->head->data;
+}
+
 
 
 // Creates a new queue.
@@ -67,7 +79,7 @@ bool queue_delete(struct queue * queue){
     if(queue == NULL)
         return false;
     
-    bool success = linked_list_remove_all(&(queue->ll));
+    bool success = linked_list_delete_in_place(&(queue->ll));
 
     free_fptr(queue);
     return success;
@@ -104,7 +116,7 @@ bool queue_pop(struct queue * queue, unsigned int * popped_data){
         return false;
     }
     
-    *popped_data = ((queue->ll).head)->data;
+    *popped_data = __queue_front(queue);
     bool success = linked_list_remove(&(queue->ll), 0);
     if(!success)
         return false;
@@ -112,6 +124,124 @@ bool queue_pop(struct queue * queue, unsigned int * popped_data){
     return true;
 }
 
+// Pre-allocates room for count more entries, so that the next count
+// pushes do not allocate.
+// \param queue    : Pointer to queue.
+// \param count    : Number of entries to reserve room for.
+// \param prefault : Touch every page of the reservation up front.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_reserve(struct queue * queue, size_t count, bool prefault){
+    if(queue == NULL)
+        return false;
+
+    return linked_list_reserve(&(queue->ll), count, prefault);
+}
+
+// Makes an empty queue take its entries from a node_pool shared with other
+// queues and linked_lists. A NULL pool switches back to private allocation.
+// \param queue : Pointer to queue.
+// \param pool  : Pointer to node_pool, or NULL.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_attach_pool(struct queue * queue, struct node_pool * pool){
+    if(queue == NULL)
+        return false;
+
+    return linked_list_attach_pool(&(queue->ll), pool);
+}
+
+// Changes the storage layout of an empty queue, see enum linked_list_layout.
+// \param queue  : Pointer to queue.
+// \param layout : Layout to switch to.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_layout(struct queue * queue, enum linked_list_layout layout){
+    if(queue == NULL)
+        return false;
+
+    return linked_list_set_layout(&(queue->ll), layout);
+}
+
+// Lets the queue switch its layout by itself, see linked_list_set_adaptive().
+// \param queue   : Pointer to queue.
+// \param enabled : TRUE to switch layouts automatically.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_adaptive(struct queue * queue, bool enabled){
+    if(queue == NULL)
+        return false;
+
+    return linked_list_set_adaptive(&(queue->ll), enabled);
+}
+
+// Gives the memory of entries popped long ago back through free_fptr(),
+// see linked_list_trim().
+// \param queue : Pointer to queue.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_trim(struct queue * queue){
+    if(queue == NULL)
+        return false;
+
+    return linked_list_trim(&(queue->ll));
+}
+
+// Makes pops trim the queue automatically, see
+// linked_list_set_trim_policy().
+// \param queue        : Pointer to queue.
+// \param ratio        : Capacity to size ratio that triggers a trim, 0 to
+//                       disable automatic trimming.
+// \param min_capacity : Capacity, in entries, below which nothing is
+//                       trimmed.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_trim_policy(struct queue * queue, size_t ratio, size_t min_capacity){
+    if(queue == NULL)
+        return false;
+
+    return linked_list_set_trim_policy(&(queue->ll), ratio, min_capacity);
+}
+
+// Sets how the queue sizes and allocates its blocks of nodes, see
+// linked_list_set_alloc_policy().
+// \param queue  : Pointer to queue.
+// \param policy : Policy to follow, NULL for the default one.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_alloc_policy(struct queue * queue, const struct alloc_policy * policy){
+    if(queue == NULL)
+        return false;
+
+    return linked_list_set_alloc_policy(&(queue->ll), policy);
+}
+
+// Turns software prefetching on for the queue, see
+// linked_list_set_prefetch().
+// \param queue    : Pointer to queue.
+// \param distance : Look-ahead in nodes, 0 to turn prefetching off.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_prefetch(struct queue * queue, size_t distance){
+    if(queue == NULL)
+        return false;
+
+    return linked_list_set_prefetch(&(queue->ll), distance);
+}
+
+// Moves every entry of src to the back of dst, leaving src empty, see
+// linked_list_concat().
+// \param dst : Pointer to queue receiving the entries.
+// \param src : Pointer to queue giving its entries.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_concat(struct queue * dst, struct queue * src){
+    if(dst == NULL || src == NULL)
+        return false;
+
+    return linked_list_concat(&(dst->ll), &(src->ll));
+}
+
 // Returns the size of the queue.
 // \param queue : Pointer to queue.
 // Returns size on success, SIZE_MAX otherwise.
@@ -147,11 +277,8 @@ bool queue_next(struct queue * queue, unsigned int * popped_data){
     if(queue_size(queue) == 0){
         return false;
     }
-    struct node* head = (queue->ll).head;
-    if(head == NULL)
-        return false;
     
-    *popped_data = head->data;
+    *popped_data = __queue_front(queue);
     return true;
 }
 
@@ -49,6 +49,79 @@ bool queue_push(struct queue * queue, unsigned int data);
 //
 bool queue_pop(struct queue * queue, unsigned int * popped_data); 
 
+// Pre-allocates room for count more entries, so that the next count
+// pushes do not allocate.
+// \param queue    : Pointer to queue.
+// \param count    : Number of entries to reserve room for.
+// \param prefault : Touch every page of the reservation up front.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_reserve(struct queue * queue, size_t count, bool prefault);
+
+// Makes an empty queue take its entries from a node_pool shared with other
+// queues and linked_lists. A NULL pool switches back to private allocation.
+// \param queue : Pointer to queue.
+// \param pool  : Pointer to node_pool, or NULL.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_attach_pool(struct queue * queue, struct node_pool * pool);
+
+// Changes the storage layout of an empty queue, see enum linked_list_layout.
+// \param queue  : Pointer to queue.
+// \param layout : Layout to switch to.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_layout(struct queue * queue, enum linked_list_layout layout);
+
+// Lets the queue switch its layout by itself, see linked_list_set_adaptive().
+// \param queue   : Pointer to queue.
+// \param enabled : TRUE to switch layouts automatically.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_adaptive(struct queue * queue, bool enabled);
+
+// Gives the memory of entries popped long ago back through free_fptr(),
+// see linked_list_trim().
+// \param queue : Pointer to queue.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_trim(struct queue * queue);
+
+// Makes pops trim the queue automatically, see
+// linked_list_set_trim_policy().
+// \param queue        : Pointer to queue.
+// \param ratio        : Capacity to size ratio that triggers a trim, 0 to
+//                       disable automatic trimming.
+// \param min_capacity : Capacity, in entries, below which nothing is
+//                       trimmed.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_trim_policy(struct queue * queue, size_t ratio, size_t min_capacity);
+
+// Sets how the queue sizes and allocates its blocks of nodes, see
+// linked_list_set_alloc_policy().
+// \param queue  : Pointer to queue.
+// \param policy : Policy to follow, NULL for the default one.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_alloc_policy(struct queue * queue, const struct alloc_policy * policy);
+
+// Turns software prefetching on for the queue, see
+// linked_list_set_prefetch().
+// \param queue    : Pointer to queue.
+// \param distance : Look-ahead in nodes, 0 to turn prefetching off.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_set_prefetch(struct queue * queue, size_t distance);
+
+// Moves every entry of src to the back of dst, leaving src empty, see
+// linked_list_concat().
+// \param dst : Pointer to queue receiving the entries.
+// \param src : Pointer to queue giving its entries.
+// Returns TRUE on success, FALSE otherwise.
+//
+bool queue_concat(struct queue * dst, struct queue * src);
+
 // Returns the size of the queue.
 // \param queue : Pointer to queue.
 // Returns size on success, SIZE_MAX otherwise.